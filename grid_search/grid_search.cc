@@ -48,8 +48,8 @@ int main(int argc, char **argv) {
         ("abs_tol", po::value<double>(), "absolute tolerace for the evaluation error. ")
         ("cuda_device_number", po::value<int>(), "cuda gpu device number used for this session. ")
         ("gpu_block_size", po::value<int>(), "block size for the gpu kernel. ")
-        ("refpt_max_leaf_size", po::value<int>(), "maximum leaf size of reference point tree. ")
-        ("qgrid_max_leaf_size", po::value<int>(), "maximum leaf size of the query grid tree. ")
+        ("refpt_max_leaf_size", po::value<int>(), "maximum leaf size of reference point tree. 0 to calibrate. ")
+        ("qgrid_max_leaf_size", po::value<int>(), "maximum leaf size of the query grid tree. 0 to calibrate. ")
 
         ("input_refpts_fname", po::value<std::string>(), "path to the input reference points. ")
         ("output_scatter_fname", po::value<std::string>(), "path to output matplotlib scatter plot data. ")
@@ -237,8 +237,9 @@ void grid_search(const po::variables_map &vm) {
   std::cout << "  base bandwidth y: " << base_bwy << std::endl;
   std::cout << std::endl;
 
+  // a leaf size of 0 is calibrated below; start out with 32. 
   start = std::chrono::high_resolution_clock::now();
-  KernelDensityType kde(data, refpt_max_leaf_size);
+  KernelDensityType kde(data, refpt_max_leaf_size > 0 ? refpt_max_leaf_size : 32);
   end = std::chrono::high_resolution_clock::now();
   elapsed = end - start;
   std::cout << "  => running time: " << elapsed.count() << " ms. \n" << std::endl;
@@ -246,6 +247,36 @@ void grid_search(const po::variables_map &vm) {
   // set base bandwidth
   kde.kernel().set_bandwidths(base_bwx, base_bwy);
 
+  // calibrate the leaf sizes that are 0 at the base bandwidth. 
+  if (refpt_max_leaf_size <= 0 || qgrid_max_leaf_size <= 0) {
+
+    std::cout << "  calibrating leaf sizes. \n" << std::endl;
+
+    // only leaf sizes up to 1/64 of the sample are timed; the gpu favors 
+    // larger leaves, so it calibrates on a larger sample. 
+#ifndef __CUDACC__
+    int leaf_nmax = kde.calibrate_leaf_nmax(
+        rel_tol, abs_tol, 10000, 2, 4096, &std::cout);
+#else
+    int leaf_nmax = kde.calibrate_leaf_nmax(
+        rel_tol, abs_tol, 262144, 2, 65536, &std::cout, gpu_block_size);
+#endif
+
+    if (qgrid_max_leaf_size <= 0) { qgrid_max_leaf_size = leaf_nmax; }
+    if (refpt_max_leaf_size <= 0) { 
+      refpt_max_leaf_size = leaf_nmax; 
+      kde = KernelDensityType(data, refpt_max_leaf_size);
+      kde.kernel().set_bandwidths(base_bwx, base_bwy);
+    }
+
+    std::cout << std::endl;
+    std::cout << "  reference point tree max leaf size: ";
+    std::cout << refpt_max_leaf_size << std::endl;
+    std::cout << "  query grid tree max leaf size: ";
+    std::cout << qgrid_max_leaf_size << std::endl;
+    std::cout << std::endl;
+  }
+
   // decide whether to convert to adaptive density
   std::cout << "  perform adaptive density cross validation: ";
   std::cout << (use_adaptive_cv ? "true" : "false" ) << std::endl;
@@ -0,0 +1,72 @@
+#ifndef BBRCITKDE_ALIGNEDALLOCATOR_H__
+#define BBRCITKDE_ALIGNEDALLOCATOR_H__
+
+#include <vector>
+#include <new>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+
+namespace bbrcit {
+
+// AlignedAllocator<> is a standard allocator whose blocks start on
+// `Alignment` byte boundaries (a cache line by default), so that arrays
+// can be streamed with aligned vector loads.
+template<typename T, size_t Alignment = 64>
+class AlignedAllocator {
+
+  static_assert(Alignment >= alignof(void*) && (Alignment & (Alignment-1)) == 0,
+                "AlignedAllocator<>: Alignment must be a power of two no smaller than a pointer. ");
+
+  public:
+
+    using value_type = T;
+
+    template<typename U> struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() noexcept = default;
+    template<typename U>
+      AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(size_t n);
+    void deallocate(T*, size_t) noexcept;
+};
+
+template<typename T, typename U, size_t A>
+inline bool operator==(const AlignedAllocator<T,A>&, const AlignedAllocator<U,A>&) { return true; }
+
+template<typename T, typename U, size_t A>
+inline bool operator!=(const AlignedAllocator<T,A>&, const AlignedAllocator<U,A>&) { return false; }
+
+// std::vector<> whose data() is aligned to a cache line.
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Implementations
+// ---------------
+
+// over-allocates by `Alignment` bytes and stores the address returned by
+// malloc() immediately before the aligned block.
+template<typename T, size_t Alignment>
+T* AlignedAllocator<T,Alignment>::allocate(size_t n) {
+
+  if (n > (static_cast<size_t>(-1) - Alignment) / sizeof(T)) { throw std::bad_alloc(); }
+
+  void *raw = std::malloc(n * sizeof(T) + Alignment);
+  if (raw == nullptr) { throw std::bad_alloc(); }
+
+  std::uintptr_t aligned =
+    (reinterpret_cast<std::uintptr_t>(raw) + Alignment) & ~static_cast<std::uintptr_t>(Alignment-1);
+  reinterpret_cast<void**>(aligned)[-1] = raw;
+
+  return reinterpret_cast<T*>(aligned);
+}
+
+template<typename T, size_t Alignment>
+void AlignedAllocator<T,Alignment>::deallocate(T *p, size_t) noexcept {
+  if (p != nullptr) { std::free(reinterpret_cast<void**>(p)[-1]); }
+}
+
+}
+
+#endif
@@ -42,7 +42,7 @@ class PointWeights {
     PointWeights(PointWeights<T>&&) = default;
     PointWeights<T>& operator=(const PointWeights<T>&) = default;
     PointWeights<T>& operator=(PointWeights<T>&&) = default;
-    ~PointWeights();
+    ~PointWeights() = default;
 
     const T& weight() const;
     void set_weight(const T&);
@@ -79,9 +79,6 @@ PointWeights<T>::PointWeights()
   : weight_(ConstantTraits<T>::one()) {
 }
 
-template<typename T>
-PointWeights<T>::~PointWeights() {}
-
 template<typename T>
 PointWeights<T>::PointWeights(const T &w) 
   : weight_(w) {
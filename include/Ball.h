@@ -0,0 +1,165 @@
+#ifndef BBRCITKDE_BALL_H__
+#define BBRCITKDE_BALL_H__
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#include <Point.h>
+#include <Interval.h>
+#include <Rectangle.h>
+#include <KdeTraits.h>
+
+// API
+// ---
+
+namespace bbrcit {
+
+template <int D, typename T> class Ball;
+
+// prints Ball<>'s as { center, radius }.
+template <int D, typename T>
+std::ostream& operator<<(std::ostream&, const Ball<D,T>&);
+
+// Ball<>'s model closed balls in D-dim euclidean space.
+//
+// Ball<> mirrors the geometric interface of Rectangle<>, so that either
+// can bound the nodes of a Kdtree<>. In particular, indexing a Ball<>
+// yields its projection onto a coordinate axis, which lets Rectangle<>'s
+// and Ball<>'s compute per dimension distances to each other.
+template <int D, typename T=double>
+class Ball {
+
+  public:
+
+    using FloatType = T;
+    using EdgeType = Interval<T>;
+    static constexpr int dim() { return D; }
+
+    Ball();
+    Ball(const Point<D,T> &center, const T &radius);
+
+    // copy-control. these are all trivial; Ball<>'s are safe to memcpy.
+    Ball(const Ball<D,T>&) = default;
+    Ball(Ball<D,T>&&) noexcept = default;
+    Ball& operator=(const Ball<D,T>&) = default;
+    Ball& operator=(Ball<D,T>&&) noexcept = default;
+    ~Ball() = default;
+
+    const Point<D,T>& center() const { return center_; }
+    const T& radius() const { return radius_; }
+
+    // returns the projection of this Ball<> onto the `i`th coordinate axis.
+    EdgeType operator[](int i) const;
+
+    // returns true if the point is contained in this Ball<>.
+    template<typename PointT> bool contains(const PointT&) const;
+
+    // returns the min/max L2 distance from the argument to this Ball<>.
+    // Examples of GT: Ball<>, Rectangle<>, Point<>.
+    template <typename PointT> T min_dist(const PointT &p) const;
+    template <typename PointT> T max_dist(const PointT &p) const;
+    T min_dist(const Ball<D,T>&) const;
+    T max_dist(const Ball<D,T>&) const;
+    T min_dist(const Rectangle<D,T>&) const;
+    T max_dist(const Rectangle<D,T>&) const;
+
+    // returns the min/max distance from the argument to the projection of
+    // this Ball<> onto the `i`th coordinate axis.
+    // Examples of GT: Ball<>, Rectangle<>, Point<>.
+    template <typename GT> T min_dist(size_t i, const GT &g) const;
+    template <typename GT> T max_dist(size_t i, const GT &g) const;
+
+  private:
+    Point<D,T> center_;
+    T radius_;
+
+    template <typename PointT> T center_dist(const PointT&) const;
+};
+
+// Implementations
+// ---------------
+
+template <int D, typename T>
+Ball<D,T>::Ball() : center_(), radius_(ConstantTraits<T>::zero()) {}
+
+template <int D, typename T>
+Ball<D,T>::Ball(const Point<D,T> &center, const T &radius)
+  : center_(center), radius_(radius) {}
+
+template <int D, typename T>
+inline typename Ball<D,T>::EdgeType Ball<D,T>::operator[](int i) const {
+  return EdgeType(center_[i] - radius_, center_[i] + radius_);
+}
+
+template <int D, typename T>
+  template <typename PointT>
+T Ball<D,T>::center_dist(const PointT &p) const {
+  T total = ConstantTraits<T>::zero();
+  T curr = ConstantTraits<T>::zero();
+  for (int i = 0; i < D; ++i) {
+    curr = center_[i] - p[i];
+    total += curr * curr;
+  }
+  return std::sqrt(total);
+}
+
+template <int D, typename T>
+  template <typename PointT>
+inline bool Ball<D,T>::contains(const PointT &p) const {
+  return center_dist(p) <= radius_;
+}
+
+template <int D, typename T>
+  template <typename PointT>
+inline T Ball<D,T>::min_dist(const PointT &p) const {
+  return std::max(center_dist(p) - radius_, ConstantTraits<T>::zero());
+}
+
+template <int D, typename T>
+  template <typename PointT>
+inline T Ball<D,T>::max_dist(const PointT &p) const {
+  return center_dist(p) + radius_;
+}
+
+template <int D, typename T>
+inline T Ball<D,T>::min_dist(const Ball<D,T> &b) const {
+  return std::max(center_dist(b.center_) - radius_ - b.radius_, ConstantTraits<T>::zero());
+}
+
+template <int D, typename T>
+inline T Ball<D,T>::max_dist(const Ball<D,T> &b) const {
+  return center_dist(b.center_) + radius_ + b.radius_;
+}
+
+template <int D, typename T>
+inline T Ball<D,T>::min_dist(const Rectangle<D,T> &r) const {
+  return std::max(r.min_dist(center_) - radius_, ConstantTraits<T>::zero());
+}
+
+template <int D, typename T>
+inline T Ball<D,T>::max_dist(const Rectangle<D,T> &r) const {
+  return r.max_dist(center_) + radius_;
+}
+
+template <int D, typename T>
+  template <typename GT>
+inline T Ball<D,T>::min_dist(size_t i, const GT &g) const {
+  return (*this)[i].min_dist(g[i]);
+}
+
+template <int D, typename T>
+  template <typename GT>
+inline T Ball<D,T>::max_dist(size_t i, const GT &g) const {
+  return (*this)[i].max_dist(g[i]);
+}
+
+template <int D, typename T>
+std::ostream& operator<<(std::ostream &os, const Ball<D,T> &b) {
+  os << "{ " << b.center() << ", " << b.radius() << " }";
+  return os;
+}
+
+}
+
+#endif
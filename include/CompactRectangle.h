@@ -0,0 +1,185 @@
+#ifndef BBRCITKDE_COMPACTRECTANGLE_H__
+#define BBRCITKDE_COMPACTRECTANGLE_H__
+
+#include <cmath>
+#include <limits>
+#include <iostream>
+
+#include <Point.h>
+#include <Interval.h>
+#include <Rectangle.h>
+#include <KdeTraits.h>
+
+// API
+// ---
+
+namespace bbrcit {
+
+template <int D, typename T> class CompactRectangle;
+
+// prints CompactRectangle<>'s as { e1, e2, ..., eD }, like Rectangle<>'s.
+template <int D, typename T>
+std::ostream& operator<<(std::ostream&, const CompactRectangle<D,T>&);
+
+// CompactRectangle<>'s are Rectangle<>'s whose edges are stored in single
+// precision. The edges are rounded outward when they are stored, so that a
+// CompactRectangle<> always contains the Rectangle<> it was made from;
+// distances computed from it are therefore valid, if slightly looser,
+// bounds on those computed from the original.
+//
+// CompactRectangle<> mirrors the geometric interface of Rectangle<>, so
+// that it can bound the nodes of a Kdtree<>. For T=double, it takes half
+// the memory of a Rectangle<>. See also CompactKdtree<>.
+template <int D, typename T=double>
+class CompactRectangle {
+
+  public:
+
+    using FloatType = T;
+    using StorageType = float;
+    using EdgeType = Interval<T>;
+    static constexpr int dim() { return D; }
+
+    CompactRectangle();
+    explicit CompactRectangle(const Rectangle<D,T>&);
+
+    // copy-control. these are all trivial; CompactRectangle<>'s are safe
+    // to memcpy.
+    CompactRectangle(const CompactRectangle<D,T>&) = default;
+    CompactRectangle(CompactRectangle<D,T>&&) noexcept = default;
+    CompactRectangle& operator=(const CompactRectangle<D,T>&) = default;
+    CompactRectangle& operator=(CompactRectangle<D,T>&&) noexcept = default;
+    ~CompactRectangle() = default;
+
+    // returns the `i`th edge, widened to T.
+    EdgeType operator[](int i) const;
+
+    // returns the stored edges as a Rectangle<>.
+    Rectangle<D,T> rectangle() const;
+
+    // returns true if the argument is contained in this CompactRectangle<>.
+    // Examples of GT: Rectangle<>, Point<>.
+    template <typename GT> bool contains(const GT&) const;
+
+    // returns the min/max L2 distance from the argument to this
+    // CompactRectangle<>.
+    // Examples of GT: CompactRectangle<>, Rectangle<>, Ball<>, Point<>.
+    template <typename GT> T min_dist(const GT &g) const;
+    template <typename GT> T max_dist(const GT &g) const;
+
+    // returns the min/max distance from the argument to the `i`th edge.
+    template <typename GT> T min_dist(size_t i, const GT &g) const;
+    template <typename GT> T max_dist(size_t i, const GT &g) const;
+
+  private:
+    StorageType lower_[D];
+    StorageType upper_[D];
+
+    static StorageType round_down(const T&);
+    static StorageType round_up(const T&);
+};
+
+// Implementations
+// ---------------
+
+template <int D, typename T>
+CompactRectangle<D,T>::CompactRectangle() {
+  for (int i = 0; i < D; ++i) { lower_[i] = upper_[i] = StorageType(0); }
+}
+
+template <int D, typename T>
+CompactRectangle<D,T>::CompactRectangle(const Rectangle<D,T> &r) {
+  for (int i = 0; i < D; ++i) {
+    lower_[i] = round_down(r[i].lower());
+    upper_[i] = round_up(r[i].upper());
+  }
+}
+
+// the conversion rounds to nearest; step to the adjacent value if it
+// landed on the wrong side of `x`.
+template <int D, typename T>
+inline typename CompactRectangle<D,T>::StorageType
+CompactRectangle<D,T>::round_down(const T &x) {
+  StorageType v = static_cast<StorageType>(x);
+  if (v > x) { v = std::nextafter(v, -std::numeric_limits<StorageType>::infinity()); }
+  return v;
+}
+
+template <int D, typename T>
+inline typename CompactRectangle<D,T>::StorageType
+CompactRectangle<D,T>::round_up(const T &x) {
+  StorageType v = static_cast<StorageType>(x);
+  if (v < x) { v = std::nextafter(v, std::numeric_limits<StorageType>::infinity()); }
+  return v;
+}
+
+template <int D, typename T>
+inline typename CompactRectangle<D,T>::EdgeType
+CompactRectangle<D,T>::operator[](int i) const {
+  return EdgeType(lower_[i], upper_[i]);
+}
+
+template <int D, typename T>
+Rectangle<D,T> CompactRectangle<D,T>::rectangle() const {
+  Rectangle<D,T> r;
+  for (int i = 0; i < D; ++i) { r.resize(i, (*this)[i]); }
+  return r;
+}
+
+template <int D, typename T>
+  template <typename GT>
+bool CompactRectangle<D,T>::contains(const GT &g) const {
+  bool is_contained = true;
+  for (int i = 0; i < D && is_contained; ++i) {
+    is_contained = (*this)[i].contains(g[i]);
+  }
+  return is_contained;
+}
+
+template <int D, typename T>
+  template <typename GT>
+T CompactRectangle<D,T>::min_dist(const GT &g) const {
+  T total = ConstantTraits<T>::zero();
+  T curr = ConstantTraits<T>::zero();
+  for (int i = 0; i < D; ++i) {
+    curr = (*this)[i].min_dist(g[i]);
+    total += curr * curr;
+  }
+  return std::sqrt(total);
+}
+
+template <int D, typename T>
+  template <typename GT>
+T CompactRectangle<D,T>::max_dist(const GT &g) const {
+  T total = ConstantTraits<T>::zero();
+  T curr = ConstantTraits<T>::zero();
+  for (int i = 0; i < D; ++i) {
+    curr = (*this)[i].max_dist(g[i]);
+    total += curr * curr;
+  }
+  return std::sqrt(total);
+}
+
+template <int D, typename T>
+  template <typename GT>
+inline T CompactRectangle<D,T>::min_dist(size_t i, const GT &g) const {
+  return (*this)[i].min_dist(g[i]);
+}
+
+template <int D, typename T>
+  template <typename GT>
+inline T CompactRectangle<D,T>::max_dist(size_t i, const GT &g) const {
+  return (*this)[i].max_dist(g[i]);
+}
+
+template <int D, typename T>
+std::ostream& operator<<(std::ostream &os, const CompactRectangle<D,T> &r) {
+  os << "{ "; os << r[0];
+  for (int i = 1; i < D; ++i) { os << ", "; os << r[i]; }
+  os << " }";
+  return os;
+}
+
+}
+
+#endif
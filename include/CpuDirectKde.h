@@ -0,0 +1,396 @@
+#ifndef BBRCITKDE_CPUDIRECTKDE_H__
+#define BBRCITKDE_CPUDIRECTKDE_H__
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <KdeTraits.h>
+#include <Point.h>
+#include <AlignedAllocator.h>
+#include <ThreadPool.h>
+#include <ParallelAlgorithms.h>
+#include <KernelBlockSum.h>
+#include <Kernels/EpanechnikovKernel.h>
+
+namespace bbrcit {
+
+template<int D, typename FloatT, typename KernelT> class CpuDirectKde;
+
+template<int D, typename FloatT, typename KernelT>
+void swap(CpuDirectKde<D,FloatT,KernelT>&,
+          CpuDirectKde<D,FloatT,KernelT>&);
+
+// CpuDirectKde<> computes the kernel density estimate using the direct
+// algorithm on the cpu. it is the host counterpart of CudaDirectKde<>,
+// with the same interface.
+//
+// evaluations follow the blocking of CudaDirectKde<>: queries are split
+// into blocks of `block_size`, which are spread over a ThreadPool, and each
+// block runs through kernel_block_sums() of KernelBlockSum.h. the block
+// sweeps the reference points one l1 sized tile at a time, and several of
+// its queries share each load of the points.
+//
+// the reference points are either copied at construction, or viewed in
+// place as a structure-of-arrays. KernelDensity<>::direct_eval() views its
+// point arrays this way, on the estimator's threads. the dual tree base
+// cases do not go through CpuDirectKde<>: each leaf pair is too small to
+// spread over threads, and calls kernel_block_sums() directly.
+//
+// results do not depend on the number of threads or on `block_size`: each
+// query's sum is that of kernel_block_sum().
+template<int D,
+         typename FloatT=double,
+         typename KernelT=EpanechnikovKernel<D,FloatT>>
+class CpuDirectKde {
+
+  public:
+    using KernelType = KernelT;
+    using FloatType = FloatT;
+    using GeomPointType = Point<D,FloatT>;
+
+    friend void swap<>(CpuDirectKde<D,FloatT,KernelT>&,
+                       CpuDirectKde<D,FloatT,KernelT>&);
+
+    // default constructor gives an empty estimator.
+    CpuDirectKde();
+
+    // copy-control. copies share the threads, and views share the viewed 
+    // points.
+    CpuDirectKde(const CpuDirectKde<D,FloatT,KernelT>&);
+    CpuDirectKde(CpuDirectKde<D,FloatT,KernelT>&&) noexcept;
+    CpuDirectKde& operator=(CpuDirectKde<D,FloatT,KernelT>);
+    ~CpuDirectKde() = default;
+
+    // construct a density estimator over points in `ref_pts` to evaluate
+    // at points in `query_pts`. evaluations run on `n_threads` threads;
+    // values less than 1 select std::thread::hardware_concurrency().
+    //
+    // Note: evaluations are specified using index ranges into the
+    //       given points. the ordering of points are assumed to be the
+    //       same as those specified at the time of construction.
+    template<typename HostPointT>
+      CpuDirectKde(const std::vector<HostPointT> &ref_pts,
+                   const std::vector<HostPointT> &query_pts,
+                   int n_threads=1);
+
+    // construct a density estimator that views `n_ref` reference points in 
+    // place: coords[d][i], masses[i], and abws[i] are the d'th coordinate, 
+    // the mass, and the local bandwidth correction of point i. the arrays 
+    // must outlive the estimator. evaluations run on the threads of `pool`, 
+    // or on the calling thread if it is null. there are no query points; 
+    // evaluate with the overloads that take them. 
+    CpuDirectKde(const FloatT *const *coords, const FloatT *masses, 
+                 const FloatT *abws, size_t n_ref, 
+                 std::shared_ptr<ThreadPool> pool=nullptr);
+
+    // returns the number of reference points
+    size_t reference_size() const;
+
+    // returns the number of query points
+    size_t query_size() const;
+
+    // returns the number of threads evaluations run on
+    int n_threads() const;
+
+    // return a reference to the kernel. allow users to configure it directly
+    const KernelType& kernel() const;
+    KernelType& kernel();
+
+    // evaluate the density contributions due to reference points in the
+    // closed interval [r_i, r_j] for query points in the
+    // closed interval [q_i, q_j].
+    //
+    // the evaluation result for query point q_k in [q_i, q_j]
+    // is stored in result[q_k-q_i].
+    //
+    // use `blocksize` to tune performance; it is the number of queries
+    // sharing each reference tile, and the unit of work of each thread.
+    void eval(
+        size_t r_i, size_t r_j, size_t q_i, size_t q_j,
+        std::vector<FloatT> &results, size_t block_size=128) const;
+    void unnormalized_eval(
+        size_t r_i, size_t r_j, size_t q_i, size_t q_j,
+        std::vector<FloatT> &results, size_t block_size=128) const;
+
+    // as above, for the `n_queries` points `queries`: the result for 
+    // queries[k] is stored in results[k]. 
+    void eval(
+        size_t r_i, size_t r_j, const GeomPointType *queries, size_t n_queries,
+        FloatT *results, size_t block_size=128) const;
+    void unnormalized_eval(
+        size_t r_i, size_t r_j, const GeomPointType *queries, size_t n_queries,
+        FloatT *results, size_t block_size=128) const;
+
+  private:
+
+    // CpuDirectKde<>'s internal state:
+    //
+    // + ref_coords_, ref_masses_, ref_abws_: the reference points as a
+    //       structure-of-arrays: the d'th coordinate, the mass, and the
+    //       local bandwidth correction of each point. empty for views. 
+    //
+    // + coords_, masses_, abws_, n_ref_: the reference points evaluations 
+    //       read: either the arrays above, or the viewed ones. 
+    //
+    // + query_points_: the query points.
+    //
+    // + pool_: the threads evaluations run on. null for a single thread.
+    //
+    // + kernel_: density kernel. users configure this directly.
+
+    AlignedVector<FloatType> ref_coords_[D];
+    AlignedVector<FloatType> ref_masses_;
+    AlignedVector<FloatType> ref_abws_;
+
+    const FloatType *coords_[D];
+    const FloatType *masses_;
+    const FloatType *abws_;
+    size_t n_ref_;
+    bool is_view_;
+
+    std::vector<GeomPointType> query_points_;
+
+    std::shared_ptr<ThreadPool> pool_;
+
+    KernelType kernel_;
+
+    void point_to_copies();
+
+};
+
+template<int D, typename FT, typename KT>
+void CpuDirectKde<D,FT,KT>::unnormalized_eval(
+    size_t r_i, size_t r_j, size_t q_i, size_t q_j,
+    std::vector<FloatType> &results, size_t block_size) const {
+
+  if (r_j >= reference_size() || q_j >= query_size()) {
+    throw std::out_of_range(
+        "CpuDirectKde<>: unnormalized_eval(): j_r and j_q should be at most "
+        "the number of reference and query points. ");
+  }
+
+  if (r_i > r_j || q_i > q_j) {
+    throw std::invalid_argument(
+        "CpuDirectKde<>: unnormalized_eval(): must have i_r <= j_r and i_q <= j_q. ");
+  }
+
+  size_t n_queries = q_j-q_i+1;
+  if (results.size() < n_queries) { results.resize(n_queries); }
+  unnormalized_eval(r_i, r_j, query_points_.data() + q_i, n_queries, 
+                    results.data(), block_size);
+
+  return;
+}
+
+template<int D, typename FT, typename KT>
+void CpuDirectKde<D,FT,KT>::unnormalized_eval(
+    size_t r_i, size_t r_j, const GeomPointType *queries, size_t n_queries,
+    FloatType *results, size_t block_size) const {
+
+  if (r_j >= reference_size()) {
+    throw std::out_of_range(
+        "CpuDirectKde<>: unnormalized_eval(): j_r should be at most "
+        "the number of reference points. ");
+  }
+
+  if (r_i > r_j) {
+    throw std::invalid_argument(
+        "CpuDirectKde<>: unnormalized_eval(): must have i_r <= j_r. ");
+  }
+
+  std::fill(results, results+n_queries, ConstantTraits<FloatType>::zero());
+
+  const FloatType *coords[D];
+  for (int d = 0; d < D; ++d) { coords[d] = coords_[d] + r_i; }
+
+  // each call gets a block of queries; see the class comment.
+  parallel_for(pool_.get(), 0, n_queries, block_size,
+    [&] (size_t b, size_t e) {
+      kernel_block_sums(kernel_, queries + b, e - b, coords, 
+                        abws_ + r_i, masses_ + r_i, r_j+1-r_i, results + b);
+    });
+
+  return;
+}
+
+template<int D, typename FT, typename KT>
+void CpuDirectKde<D,FT,KT>::eval(
+    size_t r_i, size_t r_j, size_t q_i, size_t q_j,
+    std::vector<FloatType> &results, size_t block_size) const {
+
+  unnormalized_eval(r_i, r_j, q_i, q_j, results, block_size);
+  for (size_t k = 0; k < q_j-q_i+1; ++k) { results[k] *= kernel_.normalization(); }
+
+  return;
+}
+
+template<int D, typename FT, typename KT>
+void CpuDirectKde<D,FT,KT>::eval(
+    size_t r_i, size_t r_j, const GeomPointType *queries, size_t n_queries,
+    FloatType *results, size_t block_size) const {
+
+  unnormalized_eval(r_i, r_j, queries, n_queries, results, block_size);
+  for (size_t k = 0; k < n_queries; ++k) { results[k] *= kernel_.normalization(); }
+
+  return;
+}
+
+
+template<int D, typename FT, typename KT>
+void swap(CpuDirectKde<D,FT,KT> &lhs, CpuDirectKde<D,FT,KT> &rhs) {
+  using std::swap;
+
+  for (int d = 0; d < D; ++d) { swap(lhs.ref_coords_[d], rhs.ref_coords_[d]); }
+  swap(lhs.ref_masses_, rhs.ref_masses_);
+  swap(lhs.ref_abws_, rhs.ref_abws_);
+
+  // swapped vectors keep their buffers, so the pointers stay valid. 
+  for (int d = 0; d < D; ++d) { swap(lhs.coords_[d], rhs.coords_[d]); }
+  swap(lhs.masses_, rhs.masses_);
+  swap(lhs.abws_, rhs.abws_);
+  swap(lhs.n_ref_, rhs.n_ref_);
+  swap(lhs.is_view_, rhs.is_view_);
+
+  swap(lhs.query_points_, rhs.query_points_);
+
+  swap(lhs.pool_, rhs.pool_);
+
+  swap(lhs.kernel_, rhs.kernel_);
+}
+
+
+template<int D, typename FT, typename KT>
+inline CpuDirectKde<D,FT,KT>& CpuDirectKde<D,FT,KT>::operator=(
+    CpuDirectKde<D,FT,KT> rhs) {
+  swap(*this, rhs); return *this;
+}
+
+
+template<int D, typename FT, typename KT>
+CpuDirectKde<D,FT,KT>::CpuDirectKde(
+  const CpuDirectKde<D,FT,KT> &rhs) :
+  ref_masses_(rhs.ref_masses_),
+  ref_abws_(rhs.ref_abws_),
+  masses_(rhs.masses_),
+  abws_(rhs.abws_),
+  n_ref_(rhs.n_ref_),
+  is_view_(rhs.is_view_),
+  query_points_(rhs.query_points_),
+  pool_(rhs.pool_),
+  kernel_(rhs.kernel_) {
+
+  for (int d = 0; d < D; ++d) { 
+    ref_coords_[d] = rhs.ref_coords_[d]; 
+    coords_[d] = rhs.coords_[d];
+  }
+  if (!is_view_) { point_to_copies(); }
+
+}
+
+template<int D, typename FT, typename KT>
+CpuDirectKde<D,FT,KT>::CpuDirectKde(CpuDirectKde<D,FT,KT> &&rhs) noexcept
+  : ref_masses_(std::move(rhs.ref_masses_)),
+    ref_abws_(std::move(rhs.ref_abws_)),
+    masses_(rhs.masses_),
+    abws_(rhs.abws_),
+    n_ref_(rhs.n_ref_),
+    is_view_(rhs.is_view_),
+    query_points_(std::move(rhs.query_points_)),
+    pool_(std::move(rhs.pool_)),
+    kernel_(std::move(rhs.kernel_)) {
+
+  // moved vectors keep their buffers, so the pointers stay valid. 
+  for (int d = 0; d < D; ++d) { 
+    ref_coords_[d] = std::move(rhs.ref_coords_[d]); 
+    coords_[d] = rhs.coords_[d];
+  }
+}
+
+template<int D, typename FT, typename KT>
+inline size_t CpuDirectKde<D,FT,KT>::reference_size() const {
+  return n_ref_;
+}
+
+template<int D, typename FT, typename KT>
+inline size_t CpuDirectKde<D,FT,KT>::query_size() const {
+  return query_points_.size();
+}
+
+template<int D, typename FT, typename KT>
+inline int CpuDirectKde<D,FT,KT>::n_threads() const {
+  return pool_ ? pool_->size() : 1;
+}
+
+template<int D, typename FT, typename KT>
+inline const typename CpuDirectKde<D,FT,KT>::KernelType&
+CpuDirectKde<D,FT,KT>::kernel() const {
+  return kernel_;
+}
+
+template<int D, typename FT, typename KT>
+inline typename CpuDirectKde<D,FT,KT>::KernelType&
+CpuDirectKde<D,FT,KT>::kernel() {
+  return const_cast<KernelType&>(
+           static_cast<const CpuDirectKde<D,FT,KT>&>(*this).kernel()
+      );
+}
+
+template<int D, typename FT, typename KT>
+CpuDirectKde<D,FT,KT>::CpuDirectKde() 
+  : masses_(nullptr), abws_(nullptr), n_ref_(0), is_view_(false), kernel_() {
+  point_to_copies();
+}
+
+template<int D, typename FT, typename KT>
+  template<typename HostPointT>
+CpuDirectKde<D,FT,KT>::CpuDirectKde(
+    const std::vector<HostPointT> &ref_pts,
+    const std::vector<HostPointT> &query_pts,
+    int n_threads) : n_ref_(ref_pts.size()), is_view_(false), kernel_() {
+
+  size_t n_ref = ref_pts.size();
+  for (int d = 0; d < D; ++d) { ref_coords_[d].resize(n_ref); }
+  ref_masses_.resize(n_ref);
+  ref_abws_.resize(n_ref);
+  for (size_t i = 0; i < n_ref; ++i) {
+    for (int d = 0; d < D; ++d) { ref_coords_[d][i] = ref_pts[i][d]; }
+    ref_masses_[i] = ref_pts[i].attributes().mass();
+    ref_abws_[i] = ref_pts[i].attributes().abw();
+  }
+
+  query_points_.resize(query_pts.size());
+  for (size_t i = 0; i < query_pts.size(); ++i) {
+    for (int d = 0; d < D; ++d) { query_points_[i][d] = query_pts[i][d]; }
+  }
+
+  point_to_copies();
+
+  if (n_threads != 1) {
+    pool_ = std::make_shared<ThreadPool>(n_threads);
+    if (pool_->size() == 1) { pool_.reset(); }
+  }
+
+}
+
+template<int D, typename FT, typename KT>
+CpuDirectKde<D,FT,KT>::CpuDirectKde(
+    const FloatType *const *coords, const FloatType *masses, 
+    const FloatType *abws, size_t n_ref, std::shared_ptr<ThreadPool> pool) 
+  : masses_(masses), abws_(abws), n_ref_(n_ref), is_view_(true), 
+    pool_(std::move(pool)), kernel_() {
+  for (int d = 0; d < D; ++d) { coords_[d] = coords[d]; }
+}
+
+template<int D, typename FT, typename KT>
+void CpuDirectKde<D,FT,KT>::point_to_copies() {
+  for (int d = 0; d < D; ++d) { coords_[d] = ref_coords_[d].data(); }
+  masses_ = ref_masses_.data();
+  abws_ = ref_abws_.data();
+}
+
+}
+
+#endif
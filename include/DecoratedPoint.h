@@ -58,11 +58,13 @@ class DecoratedPoint {
     DecoratedPoint(PointType&&);
     DecoratedPoint(const PointType&, const AttrT&);
 
-    // copy-control. operator= uses copy and swap. 
-    DecoratedPoint(const DecoratedPoint<Dim,AttrT,FloatT>&);
-    DecoratedPoint(DecoratedPoint<Dim,AttrT,FloatT>&&);
-    DecoratedPoint<Dim,AttrT,FloatT>& operator=(DecoratedPoint<Dim,AttrT,FloatT>);
-    ~DecoratedPoint();
+    // copy-control. these are memberwise; when AttrT is trivially copyable, 
+    // so is DecoratedPoint<>. 
+    DecoratedPoint(const DecoratedPoint<Dim,AttrT,FloatT>&) = default;
+    DecoratedPoint(DecoratedPoint<Dim,AttrT,FloatT>&&) = default;
+    DecoratedPoint<Dim,AttrT,FloatT>& operator=(const DecoratedPoint<Dim,AttrT,FloatT>&) = default;
+    DecoratedPoint<Dim,AttrT,FloatT>& operator=(DecoratedPoint<Dim,AttrT,FloatT>&&) = default;
+    ~DecoratedPoint() = default;
 
     // returns the attribute or point
     const AttrT& attributes() const;
@@ -171,9 +173,6 @@ DecoratedPoint<Dim, AttrT,FloatT>::DecoratedPoint()
   : point_(), attr_() {
 }
 
-template <int Dim, typename AttrT, typename FloatT> 
-DecoratedPoint<Dim, AttrT,FloatT>::~DecoratedPoint() {}
-
 template <int Dim, typename AttrT, typename FloatT> 
 DecoratedPoint<Dim, AttrT,FloatT>::DecoratedPoint(const PointType &p) 
   : point_(p), attr_() {
@@ -189,22 +188,6 @@ DecoratedPoint<Dim, AttrT,FloatT>::DecoratedPoint(const PointType &p, const Attr
   : point_(p), attr_(a) {
 }
 
-template <int Dim, typename AttrT, typename FloatT> 
-DecoratedPoint<Dim, AttrT,FloatT>::DecoratedPoint(const DecoratedPoint<Dim,AttrT,FloatT> &p) 
-  : point_(p.point_), attr_(p.attr_) {
-}
-
-template <int Dim, typename AttrT, typename FloatT> 
-DecoratedPoint<Dim, AttrT,FloatT>::DecoratedPoint(DecoratedPoint<Dim,AttrT,FloatT> &&p) 
-  : point_(std::move(p.point_)), attr_(std::move(p.attr_)) {
-}
-
-template <int Dim, typename AttrT, typename FloatT> 
-inline DecoratedPoint<Dim,AttrT,FloatT>& 
-DecoratedPoint<Dim,AttrT,FloatT>::operator=(DecoratedPoint<Dim,AttrT,FloatT> rhs) {
-  swap(*this, rhs); return *this;
-}
-
 
 }
 #endif
@@ -0,0 +1,433 @@
+#ifndef BBRCITKDE_DYNAMICKDTREE_H__
+#define BBRCITKDE_DYNAMICKDTREE_H__
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <algorithm>
+
+#include <Kdtree.h>
+
+// API
+// ---
+
+namespace bbrcit {
+
+// DynamicKdtree<> maintains a set of D-dimensional points under insertions
+// and deletions by the logarithmic method of Bentley and Saxe.
+//
+// + Points are kept in static Kdtree<>'s, one per level. Level k holds at
+//   most buffer_nmax * 2^k points. New points collect in a small unindexed
+//   buffer; when the buffer fills, it is merged with the levels below the
+//   first empty one, and the result is built into that empty level. An
+//   insertion therefore costs O(log^2 N) amortized.
+//
+// + Points are keyed by their coordinates, as in Kdtree<>: inserting a
+//   point that is already present merges its attributes into the existing
+//   one.
+//
+// + Deleted points are tombstoned. The node attributes on the path from the
+//   point to its root are then refreshed over the remaining points, so that
+//   they always describe exactly the live points. A level is rebuilt once
+//   more than half of its points are dead.
+//
+// + With KdtreeOptions::n_threads != 1, one ThreadPool is kept for the life
+//   of the set and shared by its copies; every level is built on it.
+//
+// + KernelDensity<> does not use DynamicKdtree<>: its reference points are
+//   still held in a static Kdtree<>, so adding or removing a reference
+//   point still means rebuilding the estimator.
+template<int D,
+         typename AttrT=PointWeights<int>,
+         typename FloatT = double>
+class DynamicKdtree {
+
+  public:
+
+    using KdtreeType = Kdtree<D,AttrT,FloatT>;
+    using DataPointType = typename KdtreeType::DataPointType;
+    using RectangleType = typename KdtreeType::RectangleType;
+    using AttributesType = AttrT;
+    using FloatType = FloatT;
+    static constexpr int dim() { return D; }
+
+  private:
+    using IndexType = typename KdtreeType::IndexType;
+    using Node = typename KdtreeType::Node;
+
+  public:
+
+    // default constructor yields an empty set. each level is built with
+    // `options`; `buffer_nmax` is the capacity of the insertion buffer.
+    DynamicKdtree(const KdtreeOptions &options = KdtreeOptions(), int buffer_nmax = 64);
+
+    // construct out of an initial list of points.
+    DynamicKdtree(const std::vector<DataPointType> &data,
+                  const KdtreeOptions &options = KdtreeOptions(), int buffer_nmax = 64);
+
+    // copy-control.
+    DynamicKdtree(const DynamicKdtree<D,AttrT,FloatT>&) = default;
+    DynamicKdtree(DynamicKdtree<D,AttrT,FloatT>&&) = default;
+    DynamicKdtree<D,AttrT,FloatT>& operator=(const DynamicKdtree<D,AttrT,FloatT>&) = default;
+    DynamicKdtree<D,AttrT,FloatT>& operator=(DynamicKdtree<D,AttrT,FloatT>&&) = default;
+    ~DynamicKdtree() = default;
+
+    // returns true if there are no points.
+    bool empty() const;
+
+    // returns the number of points.
+    IndexType size() const;
+
+    // returns the number of non-empty levels.
+    int level_count() const;
+
+    // insert `p`. if a point with the same coordinates is present, the
+    // attributes of `p` are merged into it instead.
+    void insert(const DataPointType &p);
+
+    // remove the point with the same coordinates as `p`. returns false if
+    // there is no such point.
+    bool erase(const DataPointType &p);
+
+    // returns true if a point with the same coordinates as `p` is present.
+    bool contains(const DataPointType &p) const;
+
+    // rebuild every point into a single level.
+    void rebuild();
+
+    // (1) returns every point in a vector.
+    // (2) returns every point contained in the query window in a vector.
+    // (3) returns the merged attributes of every point. `AttributesType()`
+    //     if empty.
+    void report_points(std::vector<DataPointType>&) const;
+    void range_search(const RectangleType &query, std::vector<DataPointType>&) const;
+    AttributesType attributes() const;
+
+  private:
+
+    // Level is a static Kdtree<> together with its tombstones.
+    // + alive_[i] is 0 if tree_.points_[i] has been deleted.
+    // + live_[k] is the number of live points under tree_.nodes_[k].
+    //   node attributes only summarize live points, and are meaningless
+    //   for nodes with live_[k] == 0.
+    struct Level {
+      KdtreeType tree_;
+      std::vector<char> alive_;
+      std::vector<IndexType> live_;
+      IndexType n_dead_ = 0;
+
+      bool empty() const { return tree_.empty(); }
+      IndexType size() const { return tree_.size() - n_dead_; }
+    };
+
+    KdtreeOptions options_;
+    int buffer_nmax_;
+
+    // threads for the level builds; null if single threaded.
+    std::shared_ptr<ThreadPool> pool_;
+
+    // recently inserted points that are not yet in any level.
+    std::vector<DataPointType> buffer_;
+
+    // levels_[k] holds at most buffer_nmax_ * 2^k points.
+    std::vector<Level> levels_;
+
+    // helper functions
+    void initialize_pool();
+    Level make_level(std::vector<DataPointType>&&) const;
+    void collect_live(Level&, std::vector<DataPointType>&) const;
+    void place(std::vector<DataPointType>&&);
+
+    bool find(const Level&, const DataPointType&, IndexType&) const;
+    void refresh_path(Level&, IndexType);
+
+    void range_search(const Level&, const Node*, const RectangleType&,
+                      std::vector<DataPointType>&) const;
+};
+
+// Implementations
+// ---------------
+
+template<int D, typename AttrT, typename FloatT>
+DynamicKdtree<D,AttrT,FloatT>::DynamicKdtree(const KdtreeOptions &options, int buffer_nmax)
+  : options_(options), buffer_nmax_(std::max(buffer_nmax, 1)) {
+  initialize_pool();
+}
+
+template<int D, typename AttrT, typename FloatT>
+DynamicKdtree<D,AttrT,FloatT>::DynamicKdtree(
+    const std::vector<DataPointType> &data,
+    const KdtreeOptions &options, int buffer_nmax)
+  : options_(options), buffer_nmax_(std::max(buffer_nmax, 1)) {
+
+  initialize_pool();
+
+  // the initial points may contain duplicates; merge them according to
+  // options.dedup. every level built afterwards holds unique points.
+  KdtreeType initial;
+  initial.points_ = data;
+  initial.options_ = options_;
+  initial.merge_duplicates(pool_.get());
+  place(std::move(initial.points_));
+}
+
+template<int D, typename AttrT, typename FloatT>
+void DynamicKdtree<D,AttrT,FloatT>::initialize_pool() {
+  if (options_.n_threads != 1) {
+    pool_ = std::make_shared<ThreadPool>(options_.n_threads);
+    if (pool_->size() == 1) { pool_.reset(); }
+  }
+}
+
+template<int D, typename AttrT, typename FloatT>
+inline bool DynamicKdtree<D,AttrT,FloatT>::empty() const { return size() == 0; }
+
+template<int D, typename AttrT, typename FloatT>
+typename DynamicKdtree<D,AttrT,FloatT>::IndexType
+DynamicKdtree<D,AttrT,FloatT>::size() const {
+  IndexType n = buffer_.size();
+  for (const auto &l : levels_) { if (!l.empty()) { n += l.size(); } }
+  return n;
+}
+
+template<int D, typename AttrT, typename FloatT>
+int DynamicKdtree<D,AttrT,FloatT>::level_count() const {
+  int n = 0;
+  for (const auto &l : levels_) { if (!l.empty()) { ++n; } }
+  return n;
+}
+
+// build a level out of points that are known to be unique.
+template<int D, typename AttrT, typename FloatT>
+typename DynamicKdtree<D,AttrT,FloatT>::Level
+DynamicKdtree<D,AttrT,FloatT>::make_level(std::vector<DataPointType> &&points) const {
+
+  KdtreeOptions options = options_;
+  options.dedup = KdtreeDedup::None;
+
+  Level l;
+  l.tree_ = KdtreeType(std::move(points), options, pool_.get());
+  l.alive_.assign(l.tree_.points_.size(), 1);
+  l.live_.resize(l.tree_.nodes_.size());
+  for (IndexType k = 0; k < l.live_.size(); ++k) { l.live_[k] = l.tree_.nodes_[k].size(); }
+  return l;
+}
+
+// move the live points of `l` into `result` and clear `l`.
+template<int D, typename AttrT, typename FloatT>
+void DynamicKdtree<D,AttrT,FloatT>::collect_live(Level &l, std::vector<DataPointType> &result) const {
+  for (IndexType i = 0; i < l.tree_.points_.size(); ++i) {
+    if (l.alive_[i]) { result.push_back(std::move(l.tree_.points_[i])); }
+  }
+  l = Level();
+}
+
+// build `points` into the lowest level that can hold them together with 
+// every occupied level up to it.
+template<int D, typename AttrT, typename FloatT>
+void DynamicKdtree<D,AttrT,FloatT>::place(std::vector<DataPointType> &&points) {
+
+  if (points.empty()) { return; }
+
+  // like incrementing a binary counter: absorb occupied levels until the 
+  // points fit. 
+  size_t k = 0;
+  while (true) {
+    if (k == levels_.size()) { levels_.emplace_back(); }
+    if (!levels_[k].empty()) { collect_live(levels_[k], points); }
+    if (points.size() <= (size_t(buffer_nmax_) << k)) { break; }
+    ++k;
+  }
+
+  levels_[k] = make_level(std::move(points));
+}
+
+template<int D, typename AttrT, typename FloatT>
+void DynamicKdtree<D,AttrT,FloatT>::insert(const DataPointType &p) {
+
+  // merge into an existing point with the same coordinates.
+  for (auto &q : buffer_) {
+    if (ExactEqual(q, p)) {
+      q.set_attributes(merge(q.attributes(), p.attributes()));
+      return;
+    }
+  }
+
+  IndexType i;
+  for (auto &l : levels_) {
+    if (!l.empty() && find(l, p, i)) {
+      l.tree_.points_[i].set_attributes(
+          merge(l.tree_.points_[i].attributes(), p.attributes()));
+      refresh_path(l, i);
+      return;
+    }
+  }
+
+  // otherwise buffer the point, and flush the buffer when full.
+  buffer_.push_back(p);
+  if (buffer_.size() >= static_cast<size_t>(buffer_nmax_)) {
+    std::vector<DataPointType> points; points.swap(buffer_);
+    place(std::move(points));
+  }
+}
+
+template<int D, typename AttrT, typename FloatT>
+bool DynamicKdtree<D,AttrT,FloatT>::erase(const DataPointType &p) {
+
+  for (auto it = buffer_.begin(); it != buffer_.end(); ++it) {
+    if (ExactEqual(*it, p)) { buffer_.erase(it); return true; }
+  }
+
+  IndexType i;
+  for (auto &l : levels_) {
+    if (l.empty() || !find(l, p, i)) { continue; }
+
+    l.alive_[i] = 0; ++l.n_dead_;
+    if (l.size() == 0) {
+      l = Level();
+    } else if (2 * l.n_dead_ > l.tree_.size()) {
+      std::vector<DataPointType> points;
+      collect_live(l, points);
+      l = make_level(std::move(points));
+    } else {
+      refresh_path(l, i);
+    }
+    return true;
+  }
+
+  return false;
+}
+
+template<int D, typename AttrT, typename FloatT>
+bool DynamicKdtree<D,AttrT,FloatT>::contains(const DataPointType &p) const {
+  for (const auto &q : buffer_) { if (ExactEqual(q, p)) { return true; } }
+  IndexType i;
+  for (const auto &l : levels_) { if (!l.empty() && find(l, p, i)) { return true; } }
+  return false;
+}
+
+template<int D, typename AttrT, typename FloatT>
+void DynamicKdtree<D,AttrT,FloatT>::rebuild() {
+  std::vector<DataPointType> points; points.swap(buffer_);
+  for (auto &l : levels_) { if (!l.empty()) { collect_live(l, points); } }
+  levels_.clear();
+  place(std::move(points));
+}
+
+// search `l` for a live point with the same coordinates as `p`, and save
+// its index in `i`. descends into every daughter whose box contains `p`.
+template<int D, typename AttrT, typename FloatT>
+bool DynamicKdtree<D,AttrT,FloatT>::find(
+    const Level &l, const DataPointType &p, IndexType &i) const {
+
+  const Node *root = l.tree_.root_;
+  std::vector<const Node*> s; s.push_back(root);
+  while (!s.empty()) {
+    const Node *v = s.back(); s.pop_back();
+    if (l.live_[v - root] == 0 || !v->bbox_.contains(p)) { continue; }
+    if (v->is_leaf()) {
+      for (IndexType k = v->start_idx_; k <= v->end_idx_; ++k) {
+        if (l.alive_[k] && ExactEqual(l.tree_.points_[k], p)) { i = k; return true; }
+      }
+    } else {
+      s.push_back(v->right()); s.push_back(v->left());
+    }
+  }
+  return false;
+}
+
+// recompute the live counts and node attributes on the path from the root
+// of `l` to the leaf containing point index `i`.
+template<int D, typename AttrT, typename FloatT>
+void DynamicKdtree<D,AttrT,FloatT>::refresh_path(Level &l, IndexType i) {
+
+  Node *root = l.tree_.root_;
+
+  // descend by index ranges; daughters partition the range of their parent.
+  std::vector<Node*> path;
+  Node *v = root; path.push_back(v);
+  while (!v->is_leaf()) {
+    v = i <= v->left()->end_idx_ ? v->left() : v->right();
+    path.push_back(v);
+  }
+
+  // leaf: merge the attributes of its live points.
+  IndexType live = 0;
+  for (IndexType k = v->start_idx_; k <= v->end_idx_; ++k) {
+    if (!l.alive_[k]) { continue; }
+    if (live++ == 0) { v->attr_ = l.tree_.points_[k].attributes(); }
+    else { v->attr_.merge(l.tree_.points_[k].attributes()); }
+  }
+  l.live_[v - root] = live;
+
+  // ancestors: merge the attributes of their live daughters.
+  for (auto it = path.rbegin()+1; it != path.rend(); ++it) {
+    Node *u = *it;
+    IndexType nl = l.live_[u->left() - root], nr = l.live_[u->right() - root];
+    l.live_[u - root] = nl + nr;
+    if (nl && nr) { u->attr_ = merge(u->left()->attr_, u->right()->attr_); }
+    else if (nl) { u->attr_ = u->left()->attr_; }
+    else if (nr) { u->attr_ = u->right()->attr_; }
+  }
+}
+
+template<int D, typename AttrT, typename FloatT>
+void DynamicKdtree<D,AttrT,FloatT>::report_points(std::vector<DataPointType> &result) const {
+  result.insert(result.end(), buffer_.begin(), buffer_.end());
+  for (const auto &l : levels_) {
+    for (IndexType i = 0; i < l.alive_.size(); ++i) {
+      if (l.alive_[i]) { result.push_back(l.tree_.points_[i]); }
+    }
+  }
+}
+
+template<int D, typename AttrT, typename FloatT>
+void DynamicKdtree<D,AttrT,FloatT>::range_search(
+    const RectangleType &query, std::vector<DataPointType> &result) const {
+  for (const auto &p : buffer_) { if (query.contains(p)) { result.push_back(p); } }
+  for (const auto &l : levels_) {
+    if (!l.empty()) { range_search(l, l.tree_.root_, query, result); }
+  }
+}
+
+// range search over the live points of `l` under `v`. subtrees disjoint 
+// from the window are skipped, as in Kdtree<>::visit_range(). 
+template<int D, typename AttrT, typename FloatT>
+void DynamicKdtree<D,AttrT,FloatT>::range_search(
+    const Level &l, const Node *v, const RectangleType &query,
+    std::vector<DataPointType> &result) const {
+
+  if (l.live_[v - l.tree_.root_] == 0 || KdtreeType::disjoint(query, v->bbox_)) { return; }
+
+  if (v->is_leaf() || query.contains(v->bbox_)) {
+    bool inside = query.contains(v->bbox_);
+    for (IndexType k = v->start_idx_; k <= v->end_idx_; ++k) {
+      if (l.alive_[k] && (inside || query.contains(l.tree_.points_[k]))) {
+        result.push_back(l.tree_.points_[k]);
+      }
+    }
+  } else {
+    range_search(l, v->left(), query, result);
+    range_search(l, v->right(), query, result);
+  }
+}
+
+template<int D, typename AttrT, typename FloatT>
+typename DynamicKdtree<D,AttrT,FloatT>::AttributesType
+DynamicKdtree<D,AttrT,FloatT>::attributes() const {
+
+  bool first = true; AttributesType result;
+  auto absorb = [&first, &result] (const AttributesType &a) {
+    if (first) { result = a; first = false; } else { result.merge(a); }
+  };
+
+  for (const auto &p : buffer_) { absorb(p.attributes()); }
+  for (const auto &l : levels_) {
+    if (!l.empty()) { absorb(l.tree_.root_->attr_); }
+  }
+  return result;
+}
+
+}
+
+#endif
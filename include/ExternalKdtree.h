@@ -0,0 +1,588 @@
+#ifndef BBRCITKDE_EXTERNALKDTREE_H__
+#define BBRCITKDE_EXTERNALKDTREE_H__
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <utility>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <Kdtree.h>
+
+// API
+// ---
+
+namespace bbrcit {
+
+// ExternalKdtree<> is a read-only Kdtree<> whose points and nodes live in a
+// file, so that it can index point sets larger than main memory.
+//
+// + build() streams a point file into the tree file and partitions it
+//   there. Levels whose points exceed `memory_budget` bytes are split at an
+//   approximate median of a sample, along the longest side of their cell,
+//   by sequential passes over a memory map; every subtree that fits within
+//   the budget is loaded, built as a Kdtree<> with the given options, and
+//   written back.
+//
+// + The tree file holds a header, the points, and the nodes in pre-order.
+//   Opening it maps it read-only. The node array, about 1/leaf_nmax of the
+//   size of the points, is prefetched and locked in memory with mlock(),
+//   while points page in as the leaves that hold them are visited. Locking
+//   is best effort: it fails beyond RLIMIT_MEMLOCK, in which case the nodes
+//   are only prefetched and may be evicted under paging pressure; see
+//   nodes_locked().
+//
+// + The build streams the nodes to the tree file as the subtrees built in
+//   memory complete; only the nodes above those subtrees are held.
+//
+// + Points are not deduplicated: KdtreeOptions::dedup is ignored.
+//
+// + Only the range queries below are supported. KernelDensity<> cannot
+//   evaluate over the mapped tree: its reference points must still fit in
+//   memory.
+//
+// Point files are raw arrays of DataPointType, see write_points();
+// DataPointType must therefore be trivially copyable.
+template<int D,
+         typename AttrT=PointWeights<int>,
+         typename FloatT = double>
+class ExternalKdtree {
+
+  public:
+
+    using KdtreeType = Kdtree<D,AttrT,FloatT>;
+    using DataPointType = typename KdtreeType::DataPointType;
+    using RectangleType = typename KdtreeType::RectangleType;
+    using AttributesType = AttrT;
+    using FloatType = FloatT;
+    using IndexType = std::uint64_t;
+    static constexpr int dim() { return D; }
+
+    static_assert(std::is_trivially_copyable<DataPointType>::value,
+                  "ExternalKdtree<>: DataPointType must be trivially copyable. ");
+
+    // writes `points` to the point file `fname`, appending if `append` is
+    // true.
+    static void write_points(const std::string &fname,
+                             const std::vector<DataPointType> &points, bool append=false);
+
+    // builds the tree over the points in `point_file` and saves it in
+    // `tree_file`. at most about `memory_budget` bytes of points are held
+    // in memory at any time.
+    static void build(const std::string &point_file, const std::string &tree_file,
+                      const KdtreeOptions &options = KdtreeOptions(),
+                      std::size_t memory_budget = std::size_t(1) << 30);
+
+    // maps the tree saved in `tree_file`. throws std::runtime_error if it
+    // cannot be read or was built for other template arguments.
+    explicit ExternalKdtree(const std::string &tree_file);
+    ~ExternalKdtree();
+
+    ExternalKdtree(const ExternalKdtree&) = delete;
+    ExternalKdtree& operator=(const ExternalKdtree&) = delete;
+
+    IndexType size() const { return n_points_; }
+    bool empty() const { return n_points_ == 0; }
+    IndexType node_count() const { return n_nodes_; }
+
+    // returns true if the node array is locked in memory; false if mlock()
+    // failed, e.g. for lack of RLIMIT_MEMLOCK, and the nodes may be paged out.
+    bool nodes_locked() const { return nodes_locked_; }
+
+    // returns the mapped points, in tree order.
+    const DataPointType* points() const { return points_; }
+
+    // range queries. these behave as their counterparts in Kdtree<>.
+    template<typename VisitorT>
+      void range_visit(const RectangleType &query, VisitorT &&visit) const;
+    void range_search(const RectangleType &query, std::vector<DataPointType>&) const;
+    IndexType range_count(const RectangleType &query) const;
+    IndexType range_aggregate(const RectangleType &query, AttributesType &result) const;
+
+    // primarily for debugging:
+    // + report_leaves: save ranges of point indices for every leaf.
+    // + root_attributes: returns the attributes object of the root node.
+    void report_leaves(std::vector<std::pair<IndexType,IndexType>>&) const;
+    const AttributesType& root_attributes() const;
+
+  private:
+
+    // ExternalKdtree<>::Node represents a node in the tree file.
+    // + an object represents a leaf node iff left_=right_=0.
+    // + left_ and right_ are indices into the node array.
+    struct Node {
+      RectangleType bbox_;
+      AttributesType attr_;
+      IndexType start_idx_ = 0, end_idx_ = 0;
+      IndexType left_ = 0, right_ = 0;
+      bool is_leaf() const { return left_ == 0; }
+      IndexType size() const { return end_idx_ - start_idx_ + 1; }
+    };
+
+    // the tree file starts with this header. points start at the first
+    // page boundary after it, and nodes right after the points.
+    struct Header {
+      char magic_[8];
+      std::uint32_t dim_, point_size_, node_size_, reserved_;
+      std::uint64_t n_points_, n_nodes_;
+      std::uint64_t points_offset_, nodes_offset_;
+    };
+    static constexpr std::uint64_t points_offset = 4096;
+
+    static void check_header(const Header&, const std::string&);
+
+    // build helpers.
+    class Builder;
+
+    const Node* node(IndexType k) const { return nodes_ + k; }
+    static bool disjoint(const RectangleType&, const RectangleType&);
+    template<typename AggregateT>
+      void aggregate_range(const Node*, const RectangleType&, AggregateT&) const;
+    template<typename VisitorT>
+      void visit_range(const Node*, const RectangleType&, VisitorT&) const;
+
+    int fd_ = -1;
+    void *map_ = nullptr;
+    std::size_t map_size_ = 0;
+    bool nodes_locked_ = false;
+    IndexType n_points_ = 0, n_nodes_ = 0;
+    const DataPointType *points_ = nullptr;
+    const Node *nodes_ = nullptr;
+};
+
+// Implementations
+// ---------------
+
+template<int D, typename AttrT, typename FloatT>
+void ExternalKdtree<D,AttrT,FloatT>::write_points(
+    const std::string &fname, const std::vector<DataPointType> &points, bool append) {
+
+  std::ofstream out(fname, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+  if (!out) {
+    throw std::runtime_error("ExternalKdtree<>: write_points(): cannot open " + fname + ". ");
+  }
+  out.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(DataPointType));
+  if (!out) {
+    throw std::runtime_error("ExternalKdtree<>: write_points(): cannot write " + fname + ". ");
+  }
+}
+
+// Builder carries the state of one build(): the writable map of the tree
+// file and the stream that receives its nodes, in pre-order. the nodes of
+// each subtree built in memory are written out as soon as it is done; only
+// the few nodes above those subtrees are kept, and written over their
+// placeholders once their daughters are known.
+template<int D, typename AttrT, typename FloatT>
+class ExternalKdtree<D,AttrT,FloatT>::Builder {
+
+  public:
+
+    Builder(const KdtreeOptions &options, std::size_t memory_budget,
+            DataPointType *points, IndexType n_points, 
+            std::fstream &out, std::uint64_t nodes_offset)
+      : options_(options), points_(points), n_points_(n_points), 
+        out_(out), nodes_offset_(nodes_offset) {
+      options_.dedup = KdtreeDedup::None;
+      options_.layout = KdtreeLayout::DepthFirst;
+      leaf_nmin_ = std::max<IndexType>(memory_budget / (2 * sizeof(DataPointType)),
+                                       options_.leaf_nmax);
+      out_.seekp(nodes_offset_);
+    }
+
+    IndexType node_count() const { return n_nodes_; }
+
+    // writes the nodes of the subtree over the *closed* indices interval
+    // [i,j] whose points lie in `cell`, saves the attributes of its root
+    // in `attr`, and returns the index of its root.
+    IndexType construct(IndexType i, IndexType j, const RectangleType &cell, 
+                        AttributesType &attr);
+
+    // writes the kept upper nodes over their placeholders.
+    void finish();
+
+  private:
+
+    IndexType construct_in_memory(IndexType i, IndexType j, AttributesType &attr);
+    IndexType copy_nodes(const typename KdtreeType::Node*, IndexType offset, 
+                         IndexType base, std::vector<Node> &nodes);
+    IndexType partition(IndexType i, IndexType j, int d, FloatType &split);
+    void write(const Node *nodes, IndexType n);
+
+    KdtreeOptions options_;
+    DataPointType *points_;
+    IndexType n_points_;
+    IndexType leaf_nmin_;
+    std::fstream &out_;
+    std::uint64_t nodes_offset_;
+    IndexType n_nodes_ = 0;
+
+    // the nodes above the subtrees built in memory, with their indices.
+    std::vector<std::pair<IndexType, Node>> upper_;
+};
+
+template<int D, typename AttrT, typename FloatT>
+typename ExternalKdtree<D,AttrT,FloatT>::IndexType
+ExternalKdtree<D,AttrT,FloatT>::Builder::construct(
+    IndexType i, IndexType j, const RectangleType &cell, AttributesType &attr) {
+
+  if (j-i+1 <= leaf_nmin_) { return construct_in_memory(i, j, attr); }
+
+  // reserve the node's slot; its daughters follow it. 
+  IndexType p = n_nodes_;
+  Node v;
+  v.bbox_ = cell;
+  v.start_idx_ = i;
+  v.end_idx_ = j;
+  write(&v, 1);
+
+  int d = 0;
+  for (int k = 1; k < D; ++k) { if (cell[k].length() > cell[d].length()) { d = k; } }
+
+  FloatType split;
+  IndexType m = partition(i, j, d, split);
+
+  // every point has the same coordinate along d: divide the range without
+  // dividing the cell.
+  RectangleType left_cell = cell.lower_halfspace(d, split);
+  RectangleType right_cell = cell.upper_halfspace(d, split);
+  if (m < i || m >= j) {
+    m = i + (j-i) / 2;
+    left_cell = right_cell = cell;
+  }
+
+  AttributesType left_attr, right_attr;
+  v.left_ = construct(i, m, left_cell, left_attr);
+  v.right_ = construct(m+1, j, right_cell, right_attr);
+  v.attr_ = merge(left_attr, right_attr);
+  attr = v.attr_;
+  upper_.emplace_back(p, v);
+  return p;
+}
+
+template<int D, typename AttrT, typename FloatT>
+void ExternalKdtree<D,AttrT,FloatT>::Builder::finish() {
+  for (const auto &u : upper_) {
+    out_.seekp(nodes_offset_ + u.first * sizeof(Node));
+    out_.write(reinterpret_cast<const char*>(&u.second), sizeof(Node));
+  }
+  out_.seekp(nodes_offset_ + n_nodes_ * sizeof(Node));
+}
+
+template<int D, typename AttrT, typename FloatT>
+void ExternalKdtree<D,AttrT,FloatT>::Builder::write(const Node *nodes, IndexType n) {
+  out_.write(reinterpret_cast<const char*>(nodes), n * sizeof(Node));
+  n_nodes_ += n;
+}
+
+// splits [i,j] at the median of a strided sample along d. points below the
+// split go first. a single pass from both ends, so that pages are read and
+// written sequentially. returns the last index of the left side.
+template<int D, typename AttrT, typename FloatT>
+typename ExternalKdtree<D,AttrT,FloatT>::IndexType
+ExternalKdtree<D,AttrT,FloatT>::Builder::partition(
+    IndexType i, IndexType j, int d, FloatType &split) {
+
+  const IndexType n_sample = 4095;
+  IndexType n = j-i+1, stride = std::max<IndexType>(n / n_sample, 1);
+  std::vector<FloatType> sample;
+  for (IndexType k = i; k <= j && sample.size() < n_sample; k += stride) {
+    sample.push_back(points_[k][d]);
+  }
+  std::nth_element(sample.begin(), sample.begin() + sample.size()/2, sample.end());
+  split = sample[sample.size()/2];
+
+  // the sample median may be the minimum; then split above it instead.
+  auto first = points_+i, last = points_+j+1;
+  auto mid = std::partition(first, last, [d, split] (const DataPointType &q) { return q[d] < split; });
+  if (mid == first) {
+    mid = std::partition(first, last, [d, split] (const DataPointType &q) { return !(split < q[d]); });
+  }
+  return i + (mid - first) - 1;
+}
+
+template<int D, typename AttrT, typename FloatT>
+typename ExternalKdtree<D,AttrT,FloatT>::IndexType
+ExternalKdtree<D,AttrT,FloatT>::Builder::construct_in_memory(
+    IndexType i, IndexType j, AttributesType &attr) {
+
+  KdtreeType tree(std::vector<DataPointType>(points_+i, points_+j+1), options_);
+  std::copy(tree.points_.begin(), tree.points_.end(), points_+i);
+
+  IndexType base = n_nodes_;
+  std::vector<Node> nodes;
+  nodes.reserve(tree.nodes_.size());
+  copy_nodes(tree.root_, i, base, nodes);
+  write(nodes.data(), nodes.size());
+  attr = tree.root_->attr_;
+  return base;
+}
+
+// appends the subtree under `v` to `nodes`, whose first element has index
+// `base` in the tree file. returns the index of the copy of `v`. 
+template<int D, typename AttrT, typename FloatT>
+typename ExternalKdtree<D,AttrT,FloatT>::IndexType
+ExternalKdtree<D,AttrT,FloatT>::Builder::copy_nodes(
+    const typename KdtreeType::Node *v, IndexType offset, 
+    IndexType base, std::vector<Node> &nodes) {
+
+  IndexType p = nodes.size();
+  nodes.emplace_back();
+  nodes[p].bbox_ = v->bbox_;
+  nodes[p].attr_ = v->attr_;
+  nodes[p].start_idx_ = v->start_idx_ + offset;
+  nodes[p].end_idx_ = v->end_idx_ + offset;
+  if (!v->is_leaf()) {
+    IndexType l = copy_nodes(v->left(), offset, base, nodes);
+    IndexType r = copy_nodes(v->right(), offset, base, nodes);
+    nodes[p].left_ = l;
+    nodes[p].right_ = r;
+  }
+  return base + p;
+}
+
+template<int D, typename AttrT, typename FloatT>
+void ExternalKdtree<D,AttrT,FloatT>::build(
+    const std::string &point_file, const std::string &tree_file,
+    const KdtreeOptions &options, std::size_t memory_budget) {
+
+  // (1) stream the points into the tree file and find their bounding box.
+  std::ifstream in(point_file, std::ios::binary);
+  std::ofstream out(tree_file, std::ios::binary | std::ios::trunc);
+  if (!in) { throw std::runtime_error("ExternalKdtree<>: build(): cannot open " + point_file + ". "); }
+  if (!out) { throw std::runtime_error("ExternalKdtree<>: build(): cannot open " + tree_file + ". "); }
+
+  FloatType lower[D], upper[D];
+  std::fill(lower, lower+D, std::numeric_limits<FloatType>::max());
+  std::fill(upper, upper+D, std::numeric_limits<FloatType>::lowest());
+
+  out.seekp(points_offset);
+  std::vector<DataPointType> chunk(std::max<std::size_t>(memory_budget / sizeof(DataPointType) / 4, 1));
+  IndexType n_points = 0;
+  while (in) {
+    in.read(reinterpret_cast<char*>(chunk.data()), chunk.size() * sizeof(DataPointType));
+    IndexType n = in.gcount() / sizeof(DataPointType);
+    for (IndexType k = 0; k < n; ++k) {
+      for (int d = 0; d < D; ++d) {
+        lower[d] = std::min(lower[d], chunk[k][d]);
+        upper[d] = std::max(upper[d], chunk[k][d]);
+      }
+    }
+    out.write(reinterpret_cast<const char*>(chunk.data()), n * sizeof(DataPointType));
+    n_points += n;
+  }
+  out.close();
+  std::vector<DataPointType>().swap(chunk);
+  if (!out) { throw std::runtime_error("ExternalKdtree<>: build(): cannot write " + tree_file + ". "); }
+
+  Header h;
+  std::memcpy(h.magic_, "BBRCITKD", 8);
+  h.dim_ = D;
+  h.point_size_ = sizeof(DataPointType);
+  h.node_size_ = sizeof(Node);
+  h.reserved_ = 0;
+  h.n_points_ = n_points;
+  h.n_nodes_ = 0;
+  h.points_offset_ = points_offset;
+  h.nodes_offset_ = points_offset + n_points * sizeof(DataPointType);
+  h.nodes_offset_ = (h.nodes_offset_ + 63) / 64 * 64;
+
+  // (2) partition the points in place through a shared map, and stream the 
+  // nodes after them.
+  std::fstream f(tree_file, std::ios::binary | std::ios::in | std::ios::out);
+  if (!f) { throw std::runtime_error("ExternalKdtree<>: build(): cannot open " + tree_file + ". "); }
+  if (n_points) {
+
+    int fd = ::open(tree_file.c_str(), O_RDWR);
+    std::size_t map_size = points_offset + n_points * sizeof(DataPointType);
+    void *map = fd < 0 ? MAP_FAILED : ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+      if (fd >= 0) { ::close(fd); }
+      throw std::runtime_error("ExternalKdtree<>: build(): cannot map " + tree_file + ". ");
+    }
+    ::madvise(map, map_size, MADV_SEQUENTIAL);
+
+    DataPointType *points = reinterpret_cast<DataPointType*>(static_cast<char*>(map) + points_offset);
+    RectangleType cell;
+    for (int d = 0; d < D; ++d) { cell.resize(d, {lower[d], upper[d]}); }
+
+    try {
+      Builder builder(options, memory_budget, points, n_points, f, h.nodes_offset_);
+      AttributesType attr;
+      builder.construct(0, n_points-1, cell, attr);
+      builder.finish();
+      h.n_nodes_ = builder.node_count();
+    } catch (...) {
+      ::munmap(map, map_size); ::close(fd);
+      throw;
+    }
+    ::munmap(map, map_size);
+    ::close(fd);
+  }
+
+  // (3) fill in the header.
+  f.seekp(0);
+  f.write(reinterpret_cast<const char*>(&h), sizeof(Header));
+  if (!f) { throw std::runtime_error("ExternalKdtree<>: build(): cannot write " + tree_file + ". "); }
+}
+
+template<int D, typename AttrT, typename FloatT>
+void ExternalKdtree<D,AttrT,FloatT>::check_header(const Header &h, const std::string &fname) {
+  if (std::memcmp(h.magic_, "BBRCITKD", 8) != 0 || h.dim_ != D ||
+      h.point_size_ != sizeof(DataPointType) || h.node_size_ != sizeof(Node)) {
+    throw std::runtime_error("ExternalKdtree<>: ExternalKdtree(): " + fname +
+                             " is not a tree file of this type. ");
+  }
+}
+
+template<int D, typename AttrT, typename FloatT>
+ExternalKdtree<D,AttrT,FloatT>::ExternalKdtree(const std::string &tree_file) {
+
+  fd_ = ::open(tree_file.c_str(), O_RDONLY);
+  Header h;
+  if (fd_ < 0 || ::pread(fd_, &h, sizeof(Header), 0) != sizeof(Header)) {
+    if (fd_ >= 0) { ::close(fd_); }
+    throw std::runtime_error("ExternalKdtree<>: ExternalKdtree(): cannot read " + tree_file + ". ");
+  }
+  try { check_header(h, tree_file); } catch (...) { ::close(fd_); throw; }
+
+  n_points_ = h.n_points_;
+  n_nodes_ = h.n_nodes_;
+  map_size_ = h.nodes_offset_ + n_nodes_ * sizeof(Node);
+  map_ = ::mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (map_ == MAP_FAILED) {
+    ::close(fd_);
+    throw std::runtime_error("ExternalKdtree<>: ExternalKdtree(): cannot map " + tree_file + ". ");
+  }
+
+  char *base = static_cast<char*>(map_);
+  points_ = reinterpret_cast<const DataPointType*>(base + h.points_offset_);
+  nodes_ = reinterpret_cast<const Node*>(base + h.nodes_offset_);
+
+  // every query walks the nodes; only the leaves it reaches touch points.
+  ::madvise(base + h.points_offset_, n_points_ * sizeof(DataPointType), MADV_RANDOM);
+  std::size_t page = ::sysconf(_SC_PAGESIZE);
+  std::size_t nodes_begin = h.nodes_offset_ / page * page;
+  ::madvise(base + nodes_begin, map_size_ - nodes_begin, MADV_WILLNEED);
+  nodes_locked_ = ::mlock(base + nodes_begin, map_size_ - nodes_begin) == 0;
+}
+
+template<int D, typename AttrT, typename FloatT>
+ExternalKdtree<D,AttrT,FloatT>::~ExternalKdtree() {
+  if (map_) { ::munmap(map_, map_size_); }
+  if (fd_ >= 0) { ::close(fd_); }
+}
+
+template<int D, typename AttrT, typename FloatT>
+inline bool ExternalKdtree<D,AttrT,FloatT>::disjoint(
+    const RectangleType &query_range, const RectangleType &b) {
+  for (int i = 0; i < D; ++i) {
+    if (!intersect(query_range[i], b[i])) { return true; }
+  }
+  return false;
+}
+
+template<int D, typename AttrT, typename FloatT>
+  template<typename VisitorT>
+void ExternalKdtree<D,AttrT,FloatT>::range_visit(
+    const RectangleType &query_range, VisitorT &&visit) const {
+  if (n_nodes_) { visit_range(node(0), query_range, visit); }
+}
+
+template<int D, typename AttrT, typename FloatT>
+void ExternalKdtree<D,AttrT,FloatT>::range_search(
+    const RectangleType &query_range, std::vector<DataPointType> &result) const {
+  range_visit(query_range, [&result] (IndexType, const DataPointType &p) { result.push_back(p); });
+}
+
+template<int D, typename AttrT, typename FloatT>
+typename ExternalKdtree<D,AttrT,FloatT>::IndexType
+ExternalKdtree<D,AttrT,FloatT>::range_count(const RectangleType &query_range) const {
+  IndexType count = 0;
+  auto add = [&count] (IndexType n, const AttributesType*) { count += n; };
+  if (n_nodes_) { aggregate_range(node(0), query_range, add); }
+  return count;
+}
+
+template<int D, typename AttrT, typename FloatT>
+typename ExternalKdtree<D,AttrT,FloatT>::IndexType
+ExternalKdtree<D,AttrT,FloatT>::range_aggregate(
+    const RectangleType &query_range, AttributesType &result) const {
+  IndexType count = 0;
+  auto add = [&count, &result] (IndexType n, const AttributesType *attr) {
+    if (count) { result.merge(*attr); } else { result = *attr; }
+    count += n;
+  };
+  if (n_nodes_) { aggregate_range(node(0), query_range, add); }
+  return count;
+}
+
+// see Kdtree<>::aggregate_range().
+template<int D, typename AttrT, typename FloatT>
+  template<typename AggregateT>
+void ExternalKdtree<D,AttrT,FloatT>::aggregate_range(
+    const Node *v, const RectangleType &query_range, AggregateT &add) const {
+
+  if (disjoint(query_range, v->bbox_)) { return; }
+
+  if (query_range.contains(v->bbox_)) { add(v->size(), &v->attr_); return; }
+
+  if (v->is_leaf()) {
+    for (IndexType i = v->start_idx_; i <= v->end_idx_; ++i) {
+      if (query_range.contains(points_[i])) { add(1, &points_[i].attributes()); }
+    }
+  } else {
+    aggregate_range(node(v->left_), query_range, add);
+    aggregate_range(node(v->right_), query_range, add);
+  }
+}
+
+// see Kdtree<>::visit_range().
+template<int D, typename AttrT, typename FloatT>
+  template<typename VisitorT>
+void ExternalKdtree<D,AttrT,FloatT>::visit_range(
+    const Node *v, const RectangleType &query_range, VisitorT &visit) const {
+
+  if (disjoint(query_range, v->bbox_)) { return; }
+
+  if (query_range.contains(v->bbox_)) {
+    for (IndexType i = v->start_idx_; i <= v->end_idx_; ++i) { visit(i, points_[i]); }
+  } else if (v->is_leaf()) {
+    for (IndexType i = v->start_idx_; i <= v->end_idx_; ++i) {
+      if (query_range.contains(points_[i])) { visit(i, points_[i]); }
+    }
+  } else {
+    visit_range(node(v->left_), query_range, visit);
+    visit_range(node(v->right_), query_range, visit);
+  }
+}
+
+template<int D, typename AttrT, typename FloatT>
+void ExternalKdtree<D,AttrT,FloatT>::report_leaves(
+    std::vector<std::pair<IndexType,IndexType>> &result) const {
+  for (IndexType k = 0; k < n_nodes_; ++k) {
+    if (nodes_[k].is_leaf()) { result.push_back({nodes_[k].start_idx_, nodes_[k].end_idx_}); }
+  }
+}
+
+template<int D, typename AttrT, typename FloatT>
+const typename ExternalKdtree<D,AttrT,FloatT>::AttributesType&
+ExternalKdtree<D,AttrT,FloatT>::root_attributes() const {
+  if (!n_nodes_) {
+    throw std::out_of_range("ExternalKdtree<>: root_attributes(): empty tree. ");
+  }
+  return nodes_[0].attr_;
+}
+
+}
+
+#endif
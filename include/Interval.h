@@ -34,7 +34,7 @@ class Interval {
     Interval(Interval<T>&&) = default;
     Interval<T>& operator=(const Interval<T>&) = default;
     Interval<T>& operator=(Interval<T>&&) = default;
-    ~Interval();
+    ~Interval() = default;
 
     // returns the length
     T length() const;
@@ -92,9 +92,6 @@ Interval<T>::Interval(const T &l, const T &u) : lower_(l), upper_(u) {
   }
 }
 
-template <typename T>
-Interval<T>::~Interval() {}
-
 template <typename T>
 inline T Interval<T>::length() const { return upper_ - lower_; }
 
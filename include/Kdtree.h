@@ -7,47 +7,184 @@
 #include <limits>
 #include <utility>
 #include <stack>
+#include <queue>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
 #include <iostream>
+#include <string>
+#include <cmath>
 
 #include <DecoratedPoint.h>
 #include <Rectangle.h>
+#include <Ball.h>
+#include <CompactRectangle.h>
 #include <FloatUtils.h>
 #include <Attributes/PointWeights.h>
+#include <ThreadPool.h>
+#include <ParallelAlgorithms.h>
+#include <SpaceFillingCurve.h>
 
 // API
 // ---
 
 namespace bbrcit {
 
-template<int D, typename AttrT, typename FloatT> class Kdtree;
+template<int D, typename AttrT, typename FloatT, typename BoundT> class Kdtree;
+
+template<int D, typename KernelT, typename FloatT, typename AttrT, typename TreeT> class KernelDensity;
+
+template<int D, typename AttrT, typename FloatT> class DynamicKdtree;
+
+template<int D, typename AttrT, typename FloatT> class ExternalKdtree;
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void swap(Kdtree<D,AttrT,FloatT,BoundT>&, Kdtree<D,AttrT,FloatT,BoundT>&);
+
+// KdtreeLayout selects the order in which the nodes of a Kdtree<> are 
+// stored in its node array: 
+// + DepthFirst: pre-order. every subtree occupies a contiguous block. 
+// + BreadthFirst: level order. nodes of the same depth are contiguous. 
+// + VanEmdeBoas: recursively lays out the top half of the levels followed 
+//   by each of the bottom subtrees. cache oblivious for root to leaf walks. 
+enum class KdtreeLayout { DepthFirst, BreadthFirst, VanEmdeBoas };
+
+// KdtreeDedup selects how a Kdtree<> merges points with identical 
+// coordinates before construction: 
+// + Sort: lexicographic sort followed by a linear scan. 
+// + Hash: parallel hash partitioning. the first occurrence of each point 
+//   is kept, in input order, and absorbs the attributes of later 
+//   occurrences in input order. the result does not depend on n_threads. 
+// + None: no deduplication. for callers whose points are known to be 
+//   unique, e.g. evaluation grids. 
+enum class KdtreeDedup { Sort, Hash, None };
+
+// KdtreeSplit selects how an internal node of a Kdtree<> partitions its points: 
+// + RoundRobin: median along dimensions cycled by depth. 
+// + MaxSpread: median along the dimension in which its points spread the most. 
+// + SlidingMidpoint: midpoint of the longest side of its cell. if all points 
+//   fall on one side, the split slides to the nearest point. 
+enum class KdtreeSplit { RoundRobin, MaxSpread, SlidingMidpoint };
+
+// KdtreeCurve selects the order of the points of a Kdtree<> within each 
+// node: 
+// + None: whatever order the partitioning leaves behind. 
+// + Morton, Hilbert: the points are first sorted along the space filling 
+//   curve through their bounding box, and the partitions are stable. the 
+//   tree itself is unchanged, but consecutive leaves, and the points within 
+//   each leaf, follow the curve. the Hilbert curve is the more coherent of 
+//   the two; the Morton curve is cheaper to compute. 
+enum class KdtreeCurve { None, Morton, Hilbert };
+
+// KdtreeBuild selects how a Kdtree<> finds the medians of its nodes: 
+// + Select: std::nth_element over the points of each node. 
+// + Indirect: the same selection over proxies holding only the coordinates 
+//   and index of each point, followed by a single permutation of the 
+//   points. it yields the same partitions as Select up to ties, and pays 
+//   off when the points are large compared to their coordinates (about 
+//   1 KB or more). it applies to the median split rules without a space 
+//   filling curve; other options fall back to Select. 
+enum class KdtreeBuild { Select, Indirect };
+
+// KdtreeOptions configures the construction of a Kdtree<>. 
+struct KdtreeOptions {
+
+  // maximum number of points per leaf. 
+  int leaf_nmax = 2;
+
+  // order of the nodes in memory. 
+  KdtreeLayout layout = KdtreeLayout::DepthFirst;
+
+  // number of threads used to construct the tree, including the calling 
+  // thread. values less than 1 select std::thread::hardware_concurrency(). 
+  int n_threads = 1;
+
+  // duplicate point handling. 
+  KdtreeDedup dedup = KdtreeDedup::Sort;
+
+  // split rule for internal nodes. 
+  KdtreeSplit split = KdtreeSplit::RoundRobin;
+
+  // if true, every node stores the smallest rectangle containing its points 
+  // instead of its cell, the halfspace assigned to it by its ancestors. 
+  // Ball<> bounds are always computed from the points. 
+  bool tight_bbox = false;
+
+  // order of the points within each node. 
+  KdtreeCurve curve = KdtreeCurve::None;
+
+  // median finding algorithm. 
+  KdtreeBuild build = KdtreeBuild::Select;
+};
 
-template<int D, typename KernelT, typename FloatT, typename AttrT> class KernelDensity;
+// KdtreeNodeStorage<> holds the fields of a Kdtree<> node whose width 
+// depends on the bound: the split coordinate of internal nodes, and the 
+// type of the point index range. CompactKdtree<>'s keep no split, which 
+// no traversal reads, and index their points with 32 bits. 
+template<typename FloatT, typename BoundT>
+struct KdtreeNodeStorage {
+  using IndexType = std::size_t;
+  FloatT split_ = FloatT();
+  void set_split(FloatT s) { split_ = s; }
+};
 
-template<int D, typename AttrT, typename FloatT>
-void swap(Kdtree<D,AttrT,FloatT>&, Kdtree<D,AttrT,FloatT>&);
+template<int D, typename FloatT>
+struct KdtreeNodeStorage<FloatT, CompactRectangle<D,FloatT>> {
+  using IndexType = std::uint32_t;
+  void set_split(FloatT) {}
+};
 
 // Kdtree<> implements a D-dimensional kdtree. It currently supports:
-// + Range search. 
+// + Range search, by copy (range_search()) or through a visitor
+//   (range_visit()), and batched over many windows on several threads.
+// + Range counts and aggregates of point attributes (range_count(),
+//   range_aggregate()).
+// + k nearest neighbor search, for a single query or for every point of a
+//   query tree by a dual tree traversal (knn_search()).
+// + Path-local updates of point attributes (update_attributes()).
+//
+// All nodes are stored contiguously in a single array, and daughters are 
+// addressed by 32-bit offsets relative to their parent. Copying a Kdtree<> 
+// is therefore a bulk copy of the point and node arrays. 
+//
+// With KdtreeOptions::n_threads > 1, the construction fork-joins the 
+// subtrees over a ThreadPool. Each forked right subtree is built into its 
+// own node array and appended after the left one; since offsets are 
+// relative, no fixup is needed. 
+//
+// BoundT is the shape that bounds the points under each node: Rectangle<> 
+// (the default), CompactRectangle<>, or Ball<>. Partitioning is the same 
+// for all; only the bounds, and hence the distance estimates made by their 
+// users, differ. 
+// See also BallTree<> and CompactKdtree<> below. 
 template<int D, 
          typename AttrT=PointWeights<int>, 
-         typename FloatT = double>
+         typename FloatT = double,
+         typename BoundT = Rectangle<D,FloatT>>
 class Kdtree {
 
   public: 
 
     using DataPointType = DecoratedPoint<D,AttrT,FloatT>;
     using RectangleType = Rectangle<D,FloatT>;
+    using BoundType = BoundT;
     using AttributesType = AttrT;
     using FloatType = FloatT;
     static constexpr int dim() { return D; }
 
   protected:
     using IndexType = typename std::vector<DataPointType>::size_type;
-    friend void swap<>(Kdtree<D,AttrT,FloatT>&, Kdtree<D,AttrT,FloatT>&);
+    friend void swap<>(Kdtree<D,AttrT,FloatT,BoundT>&, Kdtree<D,AttrT,FloatT,BoundT>&);
 
-    template <int DIM, typename KT, typename FT, typename AT> 
+    template <int DIM, typename KT, typename FT, typename AT, typename TT> 
       friend class KernelDensity;
 
+    template <int DIM, typename AT, typename FT> 
+      friend class DynamicKdtree;
+
+    template <int DIM, typename AT, typename FT> 
+      friend class ExternalKdtree;
+
   public: 
 
     // default constructor yields a null tree. 
@@ -56,13 +193,31 @@ class Kdtree {
     // construct Kdtree out of data given as a list of DataPointType's. 
     Kdtree(const std::vector<DataPointType> &data, int leaf_nmax=2);
     Kdtree(std::vector<DataPointType> &&data, int leaf_nmax=2);
+    Kdtree(const std::vector<DataPointType> &data, const KdtreeOptions&);
+    Kdtree(std::vector<DataPointType> &&data, const KdtreeOptions&);
+
+    // as above, but construct on the threads of `pool`, or on the calling 
+    // thread alone if it is null, instead of on KdtreeOptions::n_threads 
+    // threads of its own. for callers that build many trees, e.g. one per 
+    // query batch, and keep a pool across them. 
+    Kdtree(const std::vector<DataPointType> &data, const KdtreeOptions&, ThreadPool *pool);
+    Kdtree(std::vector<DataPointType> &&data, const KdtreeOptions&, ThreadPool *pool);
 
     // copy-control. operator='s use copy and swap.
-    Kdtree(const Kdtree<D,AttrT,FloatT>&);
-    Kdtree(Kdtree<D,AttrT,FloatT>&&) noexcept;
-    Kdtree<D,AttrT,FloatT>& operator=(Kdtree<D,AttrT,FloatT>);
+    Kdtree(const Kdtree<D,AttrT,FloatT,BoundT>&);
+    Kdtree(Kdtree<D,AttrT,FloatT,BoundT>&&) noexcept;
+    Kdtree<D,AttrT,FloatT,BoundT>& operator=(Kdtree<D,AttrT,FloatT,BoundT>);
     virtual ~Kdtree();
 
+    // replace the points by a copy of `data` and rebuild with `options`. 
+    // the point and node arrays keep their storage, so that rebuilding with 
+    // no more points or nodes than before allocates neither. the second 
+    // form rebuilds on the threads of `pool`, as the constructors above; 
+    // subtrees of 4096 points or more are then forked, and their tasks and 
+    // node arrays do allocate. 
+    void rebuild(const std::vector<DataPointType> &data, const KdtreeOptions&);
+    void rebuild(const std::vector<DataPointType> &data, const KdtreeOptions&, ThreadPool *pool);
+
     // returns true if this is a null tree. 
     bool empty() const;
 
@@ -72,6 +227,15 @@ class Kdtree {
     // returns the maximum number of points per leaf. 
     int leaf_nmax() const;
 
+    // returns the options used to construct this Kdtree. 
+    const KdtreeOptions& options() const;
+
+    // returns the number of nodes in this Kdtree.
+    IndexType node_count() const;
+
+    // returns the size of the node array in bytes. 
+    size_t node_bytes() const;
+
     // returns a const reference to the points.
     const std::vector<DataPointType>& points() const;
 
@@ -81,13 +245,61 @@ class Kdtree {
     // (1) print each partition at depth d and leaf partitions of depth <= d on a separate line of os.
     // (2) returns each partition at depth d and leaf partitions of depth <= d in a vector.
     void print_partitions(int d, std::ostream&) const;
-    void report_partitions(int d, std::vector<RectangleType>&) const;
+    void report_partitions(int d, std::vector<BoundType>&) const;
 
     // (1) print each DataPointType contained in the query window on a separate line of os.
     // (2) returns each DataPointType contained in the query window in a vector. 
     void print_range_search(const RectangleType &query, std::ostream &os) const;
     void range_search(const RectangleType &query, std::vector<DataPointType>&) const;
 
+    // (1) calls `visit(i, p)` for each point p = points()[i] contained in the 
+    //     query window, in index order within each node. nothing is copied. 
+    // (2) batched range search: saves the indices into points() of the points 
+    //     contained in queries[q] at positions [offsets[q], offsets[q+1]) of 
+    //     `indices`, in the order (1) visits them. queries are distributed 
+    //     over `n_threads` threads, with the same convention as 
+    //     KdtreeOptions::n_threads, or over the threads of `pool`, which may 
+    //     be kept across batches. the tree is only read, so the result does 
+    //     not depend on the number of threads. 
+    template<typename VisitorT> 
+      void range_visit(const RectangleType &query, VisitorT &&visit) const;
+    void range_search(const std::vector<RectangleType> &queries, 
+                      std::vector<IndexType> &offsets, std::vector<IndexType> &indices, 
+                      int n_threads=1) const;
+    void range_search(const std::vector<RectangleType> &queries, 
+                      std::vector<IndexType> &offsets, std::vector<IndexType> &indices, 
+                      ThreadPool &pool) const;
+
+    // (1) returns the number of points contained in the query window. 
+    // (2) same as (1), but also merges the attributes of these points into 
+    //     `result`, e.g. their total weight. `result` is left untouched if 
+    //     the window is empty. 
+    // nodes contained in the window contribute their attributes as a whole, 
+    // so no point is copied and only nodes straddling its boundary are opened. 
+    IndexType range_count(const RectangleType &query) const;
+    IndexType range_aggregate(const RectangleType &query, AttributesType &result) const;
+
+    // (1) saves the indices into points() of the k points nearest to `query` in 
+    //     `indices` and their euclidean distances in `dists`, nearest first. 
+    // (2) all k nearest neighbors: does the same for every point of `queries` 
+    //     with a dual tree traversal. the neighbors of queries.points()[i] are 
+    //     saved at positions [i*k, (i+1)*k) of `indices` and `dists`. 
+    // ties in distance go to the lower index. if the query points are the 
+    // points of this tree, every point is its own nearest neighbor; ask for 
+    // k+1 neighbors to exclude it. throws std::invalid_argument unless 
+    // 1 <= k <= size(). 
+    void knn_search(const DataPointType &query, int k, 
+                    std::vector<IndexType> &indices, std::vector<FloatType> &dists) const;
+    void knn_search(const Kdtree<D,AttrT,FloatT,BoundT> &queries, int k, 
+                    std::vector<IndexType> &indices, std::vector<FloatType> &dists) const;
+
+    // replace the attributes of points()[indices[k]] by attributes[k] for every k, 
+    // and refresh the node attributes on the paths from these points to the root. 
+    // ancestors shared by several points are refreshed once, so updating k points 
+    // costs O(k log N). if an index appears more than once, the last one wins. 
+    void update_attributes(const std::vector<IndexType> &indices, 
+                           const std::vector<AttributesType> &attributes);
+
     // primarily for debugging: 
     // + report_leaves: save ranges of point indices for every leaf. 
     // + root_attributes: returns the attributes object of the root node. 
@@ -97,29 +309,39 @@ class Kdtree {
 
     // Kdtree<>::Node represents a node in the Kdtree. 
     // (I/L) are members that are meaningful for internal/leaf nodes. 
-    // + An object represents an internal node iff left_=right_=nullptr.
-    struct Node {
+    // + An object represents a leaf node iff left_=right_=0.
+    // + Nodes are only meaningful as elements of the node array nodes_. 
+    struct Node : KdtreeNodeStorage<FloatT,BoundT> {
 
-      // (I) coordinate at which to partition half spaces.
-      FloatType split_ = FloatType();
+      // (I) the coordinate at which to partition half spaces is kept in 
+      // KdtreeNodeStorage<>, if at all. 
 
-      // (I/L) links to the daughters
-      Node *left_ = nullptr, *right_ = nullptr;
+      // (I) offsets, in units of Node's, from this node to its daughters 
+      // in the node array. daughters are always stored after their parent. 
+      std::uint32_t left_ = 0, right_ = 0;
 
       // (I/L) the index range [start_idx_, end_idx_] are the data points 
       // in points_ that are organized under this node
-      IndexType start_idx_ = 0;
-      IndexType end_idx_ = 0;
+      typename KdtreeNodeStorage<FloatT,BoundT>::IndexType start_idx_ = 0;
+      typename KdtreeNodeStorage<FloatT,BoundT>::IndexType end_idx_ = 0;
 
       // (I/L) attributes associated with this node
       AttributesType attr_ = AttributesType();
 
-      // (I/L) the smallest rectangle containing all data points 
-      // associated with this node. 
-      RectangleType bbox_;
+      // (I/L) a bound containing all data points associated with this node. 
+      // for Rectangle<>'s: its cell, or with KdtreeOptions::tight_bbox, the 
+      // smallest one. for Ball<>'s: the ball about their centroid that 
+      // reaches the farthest of them. 
+      BoundType bbox_;
       
       // returns true if this object is a leaf
-      bool is_leaf() const { return left_ == nullptr && right_ == nullptr; }
+      bool is_leaf() const { return left_ == 0 && right_ == 0; }
+
+      // (I) returns pointers to the daughters
+      const Node* left() const { return this + left_; }
+      const Node* right() const { return this + right_; }
+      Node* left() { return this + left_; }
+      Node* right() { return this + right_; }
       
       // returns the number of points under this node 
       IndexType size() const { return end_idx_ - start_idx_ + 1;}
@@ -130,73 +352,189 @@ class Kdtree {
     // Note: the order of DataPointType's should NOT change once the object is constructed.
     std::vector<DataPointType> points_;
 
-    // root node of the Kdtree. 
+    // every node of the Kdtree, laid out according to options_.layout. 
+    // the root is always the first element. 
+    std::vector<Node> nodes_;
+
+    // root node of the Kdtree. points into nodes_, or nullptr for a null tree. 
     Node *root_;
 
-    // maximum number of points per leaf. 
-    int leaf_nmax_;
+    // construction options, including the maximum number of points per leaf. 
+    KdtreeOptions options_;
 
   private:
 
     // helper functions
     void initialize();
-    void merge_duplicates();
-    RectangleType compute_bounding_box() const;
-    Node* construct_tree(int, int, int, const RectangleType&);
-
-    Node* tree_deep_copy(const Node*) const;
-
-    void delete_tree(Node*);
-
-    void retrieve_point_indices(const Node*, std::vector<IndexType>&) const;
-    void retrieve_range_indices(const Node*, const RectangleType&, std::vector<IndexType>&) const;
-    void retrieve_partitions(const Node *, int, std::vector<RectangleType>&) const;
+    void initialize(ThreadPool*);
+    void merge_duplicates(ThreadPool*);
+    void sort_merge_duplicates(ThreadPool*);
+    void hash_merge_duplicates(ThreadPool*);
+    RectangleType compute_bounding_box(int, int, ThreadPool*) const;
+    void curve_sort(ThreadPool*);
+    int stable_median_partition(int, int, int, FloatType&, ThreadPool*);
+    int sliding_midpoint_partition(int, int, int, const RectangleType&, FloatType&);
+    void assign_bound(Rectangle<D,FloatT>&, int, int, const RectangleType&, const RectangleType&) const;
+    void assign_bound(CompactRectangle<D,FloatT>&, int, int, const RectangleType&, const RectangleType&) const;
+    void assign_bound(Ball<D,FloatT>&, int, int, const RectangleType&, const RectangleType&) const;
+    IndexType construct_tree(int, int, int, const RectangleType&, 
+                             std::vector<Node>&, const FloatType*, ThreadPool*);
+    struct BuildProxy { FloatType x_[D]; std::uint32_t idx_; };
+    void indirect_partition(std::vector<FloatType>&, ThreadPool*);
+    void select_proxies(int, int, int, std::vector<BuildProxy>&, 
+                        std::vector<FloatType>&, ThreadPool*) const;
+
+    void apply_layout();
+    void breadth_first_order(std::vector<IndexType>&) const;
+    void van_emde_boas_order(IndexType, int, std::vector<IndexType>&) const;
+    void collect_at_depth(IndexType, int, std::vector<IndexType>&) const;
+    int height(IndexType) const;
+
+    template<typename VisitorT>
+      void visit_range(const Node*, const RectangleType&, VisitorT&) const;
+    void batch_range_search(const std::vector<RectangleType>&, 
+                            std::vector<IndexType>&, std::vector<IndexType>&, 
+                            ThreadPool*) const;
+    template<typename AggregateT>
+      void aggregate_range(const Node*, const RectangleType&, AggregateT&) const;
+    static bool disjoint(const RectangleType&, const BoundType&);
+    void retrieve_partitions(const Node *, int, std::vector<BoundType>&) const;
+
+    // (distance, index) max-heaps of the best k candidates for kNN queries. 
+    using KnnCandidate = std::pair<FloatType, IndexType>;
+    void check_knn_arguments(int, const char*) const;
+    FloatType point_distance(IndexType, const DataPointType&) const;
+    static void offer_knn_candidate(KnnCandidate*, int&, int, const KnnCandidate&);
+    void single_tree_knn(const Node*, const DataPointType&, int, KnnCandidate*, int&) const;
+    void dual_tree_knn(const Node*, const Node*, const Kdtree<D,AttrT,FloatT,BoundT>&, 
+                       int, KnnCandidate*, std::vector<int>&, std::vector<FloatType>&) const;
+    void dual_tree_knn_closer_first(const Node*, const Node*, const Kdtree<D,AttrT,FloatT,BoundT>&, 
+                       int, KnnCandidate*, std::vector<int>&, std::vector<FloatType>&) const;
 
     void refresh_node_attributes(Node*);
+    void refresh_node_attributes(std::vector<IndexType>);
+    void refresh_node_attributes(Node*, const IndexType*, const IndexType*);
 };
 
+// BallTree<> is a Kdtree<> whose nodes are bounded by Ball<>'s. Euclidean 
+// distances to balls degrade more gracefully with the dimension than those 
+// to rectangles, whose corners dominate in high dimensions. construct it 
+// with KdtreeSplit::MaxSpread for the usual ball tree partitioning. 
+template<int D, 
+         typename AttrT=PointWeights<int>, 
+         typename FloatT = double>
+using BallTree = Kdtree<D,AttrT,FloatT,Ball<D,FloatT>>;
+
+// CompactKdtree<> is a Kdtree<> whose node rectangles are stored in single 
+// precision, rounded outward. it partitions and answers queries exactly as 
+// a Kdtree<> does, but its nodes are smaller, so that more of a large tree 
+// stays in cache; the price is slightly looser distance bounds. its nodes 
+// also keep no split and index their points with 32 bits; see 
+// KdtreeNodeStorage<>. in 2-D with PointWeights<double>, a node takes 40 
+// bytes instead of 72. 
+template<int D, 
+         typename AttrT=PointWeights<int>, 
+         typename FloatT = double>
+using CompactKdtree = Kdtree<D,AttrT,FloatT,CompactRectangle<D,FloatT>>;
+
 // Implementations
 // ---------------
 
 // refresh node attributes stored in the subtree pointed to by `p`, 
 // according to the current attributes of its data points (`points`). 
-template<int D, typename AttrT, typename FloatT>
-void Kdtree<D,AttrT,FloatT>::refresh_node_attributes(Node *p) {
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::refresh_node_attributes(Node *p) {
 
   if (p == nullptr) { return; }
 
   if (p->is_leaf()) {
-    size_t i = p->start_idx_, j = p->end_idx_;
+    IndexType i = p->start_idx_, j = p->end_idx_;
     p->attr_ = points_[i].attributes();
-    for (int k = i+1; k <= j; ++k) {
+    for (IndexType k = i+1; k <= j; ++k) {
       p->attr_.merge(points_[k].attributes());
     }
   } else {
-    refresh_node_attributes(p->left_);
-    refresh_node_attributes(p->right_);
-    p->attr_ = merge(p->left_->attr_, p->right_->attr_);
+    refresh_node_attributes(p->left());
+    refresh_node_attributes(p->right());
+    p->attr_ = merge(p->left()->attr_, p->right()->attr_);
   }
 
   return;
 }
 
-template<int D, typename AttrT, typename FloatT>
-void Kdtree<D,AttrT,FloatT>::print_partitions(int depth, std::ostream &os) const {
-  std::vector<RectangleType> result;
+// refresh node attributes on the paths from the root to the points at 
+// `indices`, according to the current attributes of these points. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::refresh_node_attributes(std::vector<IndexType> indices) {
+  if (root_ == nullptr || indices.empty()) { return; }
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+  refresh_node_attributes(root_, &indices[0], &indices[0] + indices.size());
+}
+
+// refresh node attributes in the subtree pointed to by `p` that lie on paths 
+// to the points indexed by the sorted range [first, last). subtrees without 
+// any such point are left untouched. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::refresh_node_attributes(
+    Node *p, const IndexType *first, const IndexType *last) {
+
+  if (first == last) { return; }
+
+  if (p->is_leaf()) {
+    IndexType i = p->start_idx_, j = p->end_idx_;
+    p->attr_ = points_[i].attributes();
+    for (IndexType k = i+1; k <= j; ++k) {
+      p->attr_.merge(points_[k].attributes());
+    }
+  } else {
+
+    // daughters partition the index range of their parent. 
+    const IndexType *mid = std::upper_bound(first, last, p->left()->end_idx_);
+    refresh_node_attributes(p->left(), first, mid);
+    refresh_node_attributes(p->right(), mid, last);
+    p->attr_ = merge(p->left()->attr_, p->right()->attr_);
+  }
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::update_attributes(
+    const std::vector<IndexType> &indices, 
+    const std::vector<AttributesType> &attributes) {
+
+  if (indices.size() != attributes.size()) {
+    throw std::invalid_argument("Kdtree<>: update_attributes(): "
+                                "indices and attributes must have equal lengths. ");
+  }
+
+  for (IndexType k = 0; k < indices.size(); ++k) {
+    if (indices[k] >= points_.size()) {
+      throw std::out_of_range("Kdtree<>: update_attributes(): "
+                              "point index out of range. ");
+    }
+    points_[indices[k]].set_attributes(attributes[k]);
+  }
+
+  refresh_node_attributes(indices);
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::print_partitions(int depth, std::ostream &os) const {
+  std::vector<BoundType> result;
   retrieve_partitions(root_, depth, result);
   for (const auto &r : result) { os << r << std::endl; }
 }
 
-template<int D, typename AttrT, typename FloatT>
-inline void Kdtree<D,AttrT,FloatT>::report_partitions(int depth, std::vector<RectangleType> &result) const {
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline void Kdtree<D,AttrT,FloatT,BoundT>::report_partitions(int depth, std::vector<BoundType> &result) const {
   retrieve_partitions(root_, depth, result);
 }
 
 // use DFS to retrieve partitions. 
-template<int D, typename AttrT, typename FloatT>
-void Kdtree<D,AttrT,FloatT>::retrieve_partitions(
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::retrieve_partitions(
     const Node *r, int depth, 
-    std::vector<RectangleType> &result) const {
+    std::vector<BoundType> &result) const {
 
   // handle null tree separately
   if (r == nullptr) { return; }
@@ -204,171 +542,556 @@ void Kdtree<D,AttrT,FloatT>::retrieve_partitions(
   // both conditions required. see API. 
   if (depth == 0 || r->is_leaf()) { result.push_back(r->bbox_); return; }
 
-  retrieve_partitions(r->left_, depth-1, result);
-  retrieve_partitions(r->right_, depth-1, result);
+  retrieve_partitions(r->left(), depth-1, result);
+  retrieve_partitions(r->right(), depth-1, result);
+
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::print_range_search(const RectangleType &query_range, std::ostream &os) const {
+  range_visit(query_range, [&os] (IndexType, const DataPointType &p) { os << p << std::endl; });
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::range_search(const RectangleType &query_range, std::vector<DataPointType> &result) const {
+  range_visit(query_range, [&result] (IndexType, const DataPointType &p) { result.push_back(p); });
+}
 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+  template<typename VisitorT>
+void Kdtree<D,AttrT,FloatT,BoundT>::range_visit(const RectangleType &query_range, VisitorT &&visit) const {
+  visit_range(root_, query_range, visit);
 }
 
-template<int D, typename AttrT, typename FloatT>
-void Kdtree<D,AttrT,FloatT>::print_range_search(const RectangleType &query_range, std::ostream &os) const {
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::range_search(
+    const std::vector<RectangleType> &queries, 
+    std::vector<IndexType> &offsets, std::vector<IndexType> &indices, 
+    int n_threads) const {
 
-  std::vector<IndexType> result_indices;
-  retrieve_range_indices(root_, query_range, result_indices);
-  for (auto i : result_indices) { os << points_[i] << std::endl; }
+  std::unique_ptr<ThreadPool> pool;
+  if (n_threads != 1) { 
+    pool.reset(new ThreadPool(n_threads)); 
+    if (pool->size() == 1) { pool.reset(); }
+  }
 
+  batch_range_search(queries, offsets, indices, pool.get());
 }
 
-template<int D, typename AttrT, typename FloatT>
-void Kdtree<D,AttrT,FloatT>::range_search(const RectangleType &query_range, std::vector<DataPointType> &result) const {
-  std::vector<IndexType> result_indices;
-  retrieve_range_indices(root_, query_range, result_indices);
-  for (auto i : result_indices) { result.emplace_back(points_[i]); }
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline void Kdtree<D,AttrT,FloatT,BoundT>::range_search(
+    const std::vector<RectangleType> &queries, 
+    std::vector<IndexType> &offsets, std::vector<IndexType> &indices, 
+    ThreadPool &pool) const {
+  batch_range_search(queries, offsets, indices, pool.size() == 1 ? nullptr : &pool);
 }
 
-// standard range search algorithm for kdtrees. 
-template<int D, typename AttrT, typename FloatT>
-void Kdtree<D,AttrT,FloatT>::retrieve_range_indices(
-    const Node *v, const RectangleType &query_range, 
-    std::vector<IndexType> &result) const {
+// queries are cut into chunks of consecutive windows. each chunk appends 
+// its hits to a buffer of its own, and the buffers are then concatenated 
+// in chunk order; only one allocation per chunk is amortized over all of 
+// its windows. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::batch_range_search(
+    const std::vector<RectangleType> &queries, 
+    std::vector<IndexType> &offsets, std::vector<IndexType> &indices, 
+    ThreadPool *pool) const {
+
+  // grain: a few chunks per thread, so that uneven windows even out. 
+  IndexType grain = pool ? queries.size() / (8 * pool->size()) : queries.size();
+  grain = std::max(grain, IndexType(1));
+  IndexType n_chunks = (queries.size() + grain - 1) / grain;
+
+  // offsets[q+1] temporarily holds the number of hits of queries[q]. 
+  offsets.assign(queries.size()+1, 0);
+  std::vector<std::vector<IndexType>> buffers(n_chunks);
+  parallel_for(pool, 0, queries.size(), grain, 
+    [this, grain, &queries, &offsets, &buffers] (size_t b, size_t e) {
+      std::vector<IndexType> &buffer = buffers[b / grain];
+      for (size_t q = b; q < e; ++q) {
+        IndexType n = buffer.size();
+        range_visit(queries[q], [&buffer] (IndexType i, const DataPointType&) { buffer.push_back(i); });
+        offsets[q+1] = buffer.size() - n;
+      }
+    });
 
-  if (v == nullptr) { return; }
+  for (IndexType q = 0; q < queries.size(); ++q) { offsets[q+1] += offsets[q]; }
 
-  if (v->is_leaf()) { 
-    for (IndexType i = v->start_idx_; i <= v->end_idx_; ++i) {
-      if (query_range.contains(points_[i])) {
-        result.push_back(i);
+  indices.resize(offsets.back());
+  parallel_for(pool, 0, n_chunks, 1, 
+    [grain, &offsets, &indices, &buffers] (size_t b, size_t e) {
+      for (size_t c = b; c < e; ++c) {
+        std::copy(buffers[c].begin(), buffers[c].end(), indices.begin() + offsets[c * grain]);
+        std::vector<IndexType>().swap(buffers[c]);
       }
+    });
+}
+
+// standard range search algorithm for kdtrees. subtrees contained in the 
+// window are visited without further tests. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+  template<typename VisitorT>
+void Kdtree<D,AttrT,FloatT,BoundT>::visit_range(
+    const Node *v, const RectangleType &query_range, VisitorT &visit) const {
+
+  if (v == nullptr || disjoint(query_range, v->bbox_)) { return; }
+
+  if (query_range.contains(v->bbox_)) {
+    for (IndexType i = v->start_idx_; i <= v->end_idx_; ++i) { visit(i, points_[i]); }
+  } else if (v->is_leaf()) { 
+    for (IndexType i = v->start_idx_; i <= v->end_idx_; ++i) {
+      if (query_range.contains(points_[i])) { visit(i, points_[i]); }
     }
   } else {
+    visit_range(v->left(), query_range, visit);
+    visit_range(v->right(), query_range, visit);
+  }
+}
 
-    // left halfspace
-    if (query_range.contains(v->left_->bbox_)) {
-      retrieve_point_indices(v->left_, result);
-    } else {
-      retrieve_range_indices(v->left_, query_range, result);
+// returns true if the query window and the node bound `b` cannot share a 
+// point. compares their projections on each axis. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline bool Kdtree<D,AttrT,FloatT,BoundT>::disjoint(
+    const RectangleType &query_range, const BoundType &b) {
+  for (int i = 0; i < D; ++i) {
+    if (!intersect(query_range[i], b[i])) { return true; }
+  }
+  return false;
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+typename Kdtree<D,AttrT,FloatT,BoundT>::IndexType 
+Kdtree<D,AttrT,FloatT,BoundT>::range_count(const RectangleType &query_range) const {
+  IndexType count = 0;
+  auto add = [&count] (IndexType n, const AttributesType*) { count += n; };
+  aggregate_range(root_, query_range, add);
+  return count;
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+typename Kdtree<D,AttrT,FloatT,BoundT>::IndexType 
+Kdtree<D,AttrT,FloatT,BoundT>::range_aggregate(
+    const RectangleType &query_range, AttributesType &result) const {
+  IndexType count = 0;
+  auto add = [&count, &result] (IndexType n, const AttributesType *attr) { 
+    if (count) { result.merge(*attr); } else { result = *attr; }
+    count += n;
+  };
+  aggregate_range(root_, query_range, add);
+  return count;
+}
+
+// calls `add(n, &attr)` for every maximal subtree contained in the query 
+// window, with n its number of points and attr its attributes, and for 
+// every other point in the window, with n = 1. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+  template<typename AggregateT>
+void Kdtree<D,AttrT,FloatT,BoundT>::aggregate_range(
+    const Node *v, const RectangleType &query_range, AggregateT &add) const {
+
+  if (v == nullptr || disjoint(query_range, v->bbox_)) { return; }
+
+  if (query_range.contains(v->bbox_)) { add(v->size(), &v->attr_); return; }
+
+  if (v->is_leaf()) {
+    for (IndexType i = v->start_idx_; i <= v->end_idx_; ++i) {
+      if (query_range.contains(points_[i])) { add(1, &points_[i].attributes()); }
     }
+  } else {
+    aggregate_range(v->left(), query_range, add);
+    aggregate_range(v->right(), query_range, add);
+  }
+}
 
-    // right halfspace
-    if (query_range.contains(v->right_->bbox_)) {
-      retrieve_point_indices(v->right_, result);
-    } else {
-      retrieve_range_indices(v->right_, query_range, result);
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::check_knn_arguments(int k, const char *fn) const {
+  if (k < 1 || static_cast<IndexType>(k) > size()) {
+    throw std::invalid_argument(std::string("Kdtree<>: ") + fn + 
+                                ": k must be between 1 and size(). ");
+  }
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline FloatT Kdtree<D,AttrT,FloatT,BoundT>::point_distance(
+    IndexType i, const DataPointType &q) const {
+  FloatType total = ConstantTraits<FloatType>::zero(), diff;
+  for (int d = 0; d < D; ++d) { diff = points_[i][d] - q[d]; total += diff * diff; }
+  return std::sqrt(total);
+}
+
+// offer candidate `c` to the max-heap `heap` of `n` out of at most `k` candidates. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline void Kdtree<D,AttrT,FloatT,BoundT>::offer_knn_candidate(
+    KnnCandidate *heap, int &n, int k, const KnnCandidate &c) {
+  if (n < k) {
+    heap[n++] = c; std::push_heap(heap, heap+n);
+  } else if (c < heap[0]) {
+    std::pop_heap(heap, heap+n); heap[n-1] = c; std::push_heap(heap, heap+n);
+  }
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::knn_search(
+    const DataPointType &query, int k, 
+    std::vector<IndexType> &indices, std::vector<FloatType> &dists) const {
+
+  check_knn_arguments(k, "knn_search()");
+
+  std::vector<KnnCandidate> heap(k);
+  int n = 0;
+  single_tree_knn(root_, query, k, &heap[0], n);
+  std::sort_heap(heap.begin(), heap.end());
+
+  indices.resize(k); dists.resize(k);
+  for (int i = 0; i < k; ++i) { dists[i] = heap[i].first; indices[i] = heap[i].second; }
+}
+
+// depth first search, visiting the daughter closer to `query` first. a node 
+// is pruned once k candidates are known and it is farther than all of them. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::single_tree_knn(
+    const Node *v, const DataPointType &query, int k, 
+    KnnCandidate *heap, int &n) const {
+
+  if (v->is_leaf()) {
+    for (IndexType i = v->start_idx_; i <= v->end_idx_; ++i) {
+      offer_knn_candidate(heap, n, k, KnnCandidate(point_distance(i, query), i));
+    }
+    return;
+  }
+
+  // ties are common when bounds overlap, as Ball<>'s do; break them 
+  // by the max distance. 
+  const Node *closer = v->left(), *further = v->right();
+  FloatType closer_dist = closer->bbox_.min_dist(query);
+  FloatType further_dist = further->bbox_.min_dist(query);
+  if (further_dist < closer_dist || (further_dist == closer_dist && 
+        further->bbox_.max_dist(query) < closer->bbox_.max_dist(query))) { 
+    std::swap(closer, further); std::swap(closer_dist, further_dist); 
+  }
+
+  if (n < k || closer_dist <= heap[0].first) { 
+    single_tree_knn(closer, query, k, heap, n); 
+  }
+  if (n < k || further_dist <= heap[0].first) { 
+    single_tree_knn(further, query, k, heap, n); 
+  }
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::knn_search(
+    const Kdtree<D,AttrT,FloatT,BoundT> &queries, int k, 
+    std::vector<IndexType> &indices, std::vector<FloatType> &dists) const {
+
+  check_knn_arguments(k, "knn_search()");
+
+  // one heap per query point, and for each query node, an upper bound 
+  // on the k'th neighbor distance of every query point under it. 
+  IndexType n_queries = queries.size();
+  std::vector<KnnCandidate> heaps(n_queries * k);
+  std::vector<int> heap_sizes(n_queries, 0);
+  std::vector<FloatType> node_bounds(queries.nodes_.size(), 
+                                     std::numeric_limits<FloatType>::max());
+
+  if (n_queries) { 
+    dual_tree_knn(queries.root_, root_, queries, k, &heaps[0], heap_sizes, node_bounds);
+  }
+
+  indices.resize(n_queries * k); dists.resize(n_queries * k);
+  for (IndexType q = 0; q < n_queries; ++q) {
+    std::sort_heap(heaps.begin() + q*k, heaps.begin() + (q+1)*k);
+    for (int i = 0; i < k; ++i) {
+      dists[q*k+i] = heaps[q*k+i].first; indices[q*k+i] = heaps[q*k+i].second;
+    }
+  }
+}
+
+// dual tree traversal over query node Q and reference node R. the pair 
+// is pruned when R is farther from Q than the k'th neighbor bound of Q. 
+// internal nodes are split in both trees at once; reference daughters are 
+// visited closer first. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::dual_tree_knn(
+    const Node *Q, const Node *R, const Kdtree<D,AttrT,FloatT,BoundT> &queries, 
+    int k, KnnCandidate *heaps, std::vector<int> &heap_sizes, 
+    std::vector<FloatType> &node_bounds) const {
+
+  IndexType q_idx = Q - queries.root_;
+  if (R->bbox_.min_dist(Q->bbox_) > node_bounds[q_idx]) { return; }
+
+  if (Q->is_leaf() && R->is_leaf()) {
+
+    // the k'th neighbor distance of any point in Q is at most the largest 
+    // among them, and at most the smallest plus the diameter of Q. 
+    FloatType max_kth = ConstantTraits<FloatType>::zero();
+    FloatType min_kth = std::numeric_limits<FloatType>::max();
+    for (IndexType q = Q->start_idx_; q <= Q->end_idx_; ++q) {
+      KnnCandidate *heap = heaps + q*k;
+      int &n = heap_sizes[q];
+      if (n < k || R->bbox_.min_dist(queries.points_[q]) <= heap[0].first) {
+        for (IndexType r = R->start_idx_; r <= R->end_idx_; ++r) {
+          offer_knn_candidate(heap, n, k, 
+              KnnCandidate(point_distance(r, queries.points_[q]), r));
+        }
+      }
+      FloatType kth = n < k ? std::numeric_limits<FloatType>::max() : heap[0].first;
+      max_kth = std::max(max_kth, kth);
+      min_kth = std::min(min_kth, kth);
+    }
+    if (min_kth < std::numeric_limits<FloatType>::max()) {
+      max_kth = std::min(max_kth, min_kth + Q->bbox_.max_dist(Q->bbox_));
+    }
+    node_bounds[q_idx] = std::min(node_bounds[q_idx], max_kth);
+
+  } else if (Q->is_leaf()) {
+
+    dual_tree_knn_closer_first(Q, R, queries, k, heaps, heap_sizes, node_bounds);
+
+  } else {
+
+    // split Q, and R with it unless it is a leaf. 
+    for (const Node *q_child : { Q->left(), Q->right() }) {
+      if (R->is_leaf()) {
+        dual_tree_knn(q_child, R, queries, k, heaps, heap_sizes, node_bounds);
+      } else {
+        dual_tree_knn_closer_first(q_child, R, queries, k, heaps, heap_sizes, node_bounds);
+      }
     }
+    node_bounds[q_idx] = std::min(node_bounds[q_idx], 
+        std::max(node_bounds[Q->left() - queries.root_], 
+                 node_bounds[Q->right() - queries.root_]));
+  }
+}
 
+// visits the daughters of R against Q, the one closer to Q first. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline void Kdtree<D,AttrT,FloatT,BoundT>::dual_tree_knn_closer_first(
+    const Node *Q, const Node *R, const Kdtree<D,AttrT,FloatT,BoundT> &queries, 
+    int k, KnnCandidate *heaps, std::vector<int> &heap_sizes, 
+    std::vector<FloatType> &node_bounds) const {
+
+  const Node *closer = R->left(), *further = R->right();
+  FloatType closer_dist = closer->bbox_.min_dist(Q->bbox_);
+  FloatType further_dist = further->bbox_.min_dist(Q->bbox_);
+  if (further_dist < closer_dist || (further_dist == closer_dist && 
+        further->bbox_.max_dist(Q->bbox_) < closer->bbox_.max_dist(Q->bbox_))) {
+    std::swap(closer, further);
   }
+  dual_tree_knn(Q, closer, queries, k, heaps, heap_sizes, node_bounds);
+  dual_tree_knn(Q, further, queries, k, heaps, heap_sizes, node_bounds);
 }
 
-template<int D, typename AttrT, typename FloatT>
-void swap(Kdtree<D,AttrT,FloatT> &lhs, Kdtree<D,AttrT,FloatT> &rhs) {
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void swap(Kdtree<D,AttrT,FloatT,BoundT> &lhs, Kdtree<D,AttrT,FloatT,BoundT> &rhs) {
 
   using std::swap;
   
   swap(lhs.points_, rhs.points_);
-  swap(lhs.leaf_nmax_, rhs.leaf_nmax_);
+  swap(lhs.options_, rhs.options_);
 
-  // simply switch the root_ pointers.
-  typename Kdtree<D,AttrT,FloatT>::Node *ptemp = lhs.root_;
-  lhs.root_ = rhs.root_;
-  rhs.root_ = ptemp;
+  // swapping vectors does not move their elements, so it is 
+  // enough to simply switch the root_ pointers.
+  swap(lhs.nodes_, rhs.nodes_);
+  swap(lhs.root_, rhs.root_);
 }
 
-template<int D, typename AttrT, typename FloatT>
-inline Kdtree<D,AttrT,FloatT>& Kdtree<D,AttrT,FloatT>::operator=(Kdtree<D,AttrT,FloatT> rhs) {
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline Kdtree<D,AttrT,FloatT,BoundT>& Kdtree<D,AttrT,FloatT,BoundT>::operator=(Kdtree<D,AttrT,FloatT,BoundT> rhs) {
   swap(*this, rhs); return *this;
 }
 
-template<int D, typename AttrT, typename FloatT>
-inline bool Kdtree<D,AttrT,FloatT>::empty() const { return root_ == nullptr; }
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline bool Kdtree<D,AttrT,FloatT,BoundT>::empty() const { return root_ == nullptr; }
 
-template<int D, typename AttrT, typename FloatT>
-inline typename Kdtree<D,AttrT,FloatT>::IndexType Kdtree<D,AttrT,FloatT>::size() const { 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline typename Kdtree<D,AttrT,FloatT,BoundT>::IndexType Kdtree<D,AttrT,FloatT,BoundT>::size() const { 
   return root_ == nullptr ? 0 : root_->size(); 
 }
 
-template<int D, typename AttrT, typename FloatT>
-inline int Kdtree<D,AttrT,FloatT>::leaf_nmax() const 
-{ return leaf_nmax_; }
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline int Kdtree<D,AttrT,FloatT,BoundT>::leaf_nmax() const 
+{ return options_.leaf_nmax; }
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline const KdtreeOptions& Kdtree<D,AttrT,FloatT,BoundT>::options() const 
+{ return options_; }
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline typename Kdtree<D,AttrT,FloatT,BoundT>::IndexType 
+Kdtree<D,AttrT,FloatT,BoundT>::node_count() const 
+{ return nodes_.size(); }
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline size_t Kdtree<D,AttrT,FloatT,BoundT>::node_bytes() const 
+{ return nodes_.size() * sizeof(Node); }
 
 // DFS to the leaves and print the index range of points to os
-template<int D, typename AttrT, typename FloatT>
-inline void Kdtree<D,AttrT,FloatT>::report_leaves(
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline void Kdtree<D,AttrT,FloatT,BoundT>::report_leaves(
     std::vector<std::pair<IndexType,IndexType>> &result) const { 
-  std::stack<Node*> s; s.push(root_);
+  if (root_ == nullptr) { return; }
+  std::stack<const Node*> s; s.push(root_);
   while (!s.empty()) {
-    Node *r = s.top(); s.pop();
+    const Node *r = s.top(); s.pop();
     if (r->is_leaf()) { 
       result.push_back(std::make_pair(r->start_idx_, r->end_idx_));
     } else {
-      if (r->right_) { s.push(r->right_); }
-      if (r->left_) { s.push(r->left_); }
+      s.push(r->right());
+      s.push(r->left());
     }
   }
 }
 
-template<int D, typename AttrT, typename FloatT>
-inline const std::vector<typename Kdtree<D,AttrT,FloatT>::DataPointType>&
-Kdtree<D,AttrT,FloatT>::points() const {
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline const std::vector<typename Kdtree<D,AttrT,FloatT,BoundT>::DataPointType>&
+Kdtree<D,AttrT,FloatT,BoundT>::points() const {
   return points_;
 }
 
-template<int D, typename AttrT, typename FloatT>
-void Kdtree<D,AttrT,FloatT>::print_points(std::ostream &os) const {
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::print_points(std::ostream &os) const {
   for (const auto &p : points_) { os << p << std::endl; }
 }
 
-template<int D, typename AttrT, typename FloatT>
-void Kdtree<D,AttrT,FloatT>::retrieve_point_indices(const Node *r, std::vector<IndexType> &result) const {
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+Kdtree<D,AttrT,FloatT,BoundT>::Kdtree() : points_(0), nodes_(0), root_(nullptr) {}
 
-  // check for null tree
-  if (r == nullptr) { return; }
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+Kdtree<D,AttrT,FloatT,BoundT>::~Kdtree() {}
 
-  // simply append all points under this node
-  for (IndexType i = r->start_idx_; i <= r->end_idx_; ++i) {
-    result.emplace_back(i);
-  }
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::rebuild(
+    const std::vector<DataPointType> &points, const KdtreeOptions &options) {
+  points_.assign(points.begin(), points.end());
+  options_ = options;
+  initialize();
 }
 
-template<int D, typename AttrT, typename FloatT>
-Kdtree<D,AttrT,FloatT>::Kdtree() : points_(0), root_(nullptr) {}
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::rebuild(
+    const std::vector<DataPointType> &points, const KdtreeOptions &options, 
+    ThreadPool *pool) {
+  points_.assign(points.begin(), points.end());
+  options_ = options;
+  initialize(pool);
+}
 
-template<int D, typename AttrT, typename FloatT>
-Kdtree<D,AttrT,FloatT>::~Kdtree() { delete_tree(root_); }
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::initialize() {
 
-template<int D, typename AttrT, typename FloatT>
-void Kdtree<D,AttrT,FloatT>::initialize() {
+  // workers live for the duration of the construction only. 
+  std::unique_ptr<ThreadPool> pool;
+  if (options_.n_threads != 1) { 
+    pool.reset(new ThreadPool(options_.n_threads)); 
+    if (pool->size() == 1) { pool.reset(); }
+  }
+
+  initialize(pool.get());
+}
+
+// construct the tree on the threads of `pool`, if not null. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::initialize(ThreadPool *pool) {
+
+  if (pool && pool->size() == 1) { pool = nullptr; }
 
   // merge duplicate keys
-  merge_duplicates();
+  merge_duplicates(pool);
+
+  // pre-order along the space filling curve 
+  curve_sort(pool);
 
   // build the tree
+  nodes_.clear();
+  root_ = nullptr;
   if (!points_.empty()) { 
-    root_ = construct_tree(0, points_.size()-1, 0, compute_bounding_box()); 
+    if (points_.size() - 1 > std::numeric_limits<
+          typename KdtreeNodeStorage<FloatT,BoundT>::IndexType>::max()) {
+      throw std::length_error("Kdtree<>: initialize(): "
+                              "number of points exceeds the node index type. ");
+    }
+    std::vector<FloatType> splits;
+    if (options_.build == KdtreeBuild::Indirect && 
+        options_.split != KdtreeSplit::SlidingMidpoint && 
+        options_.curve == KdtreeCurve::None) {
+      indirect_partition(splits, pool);
+    }
+    construct_tree(0, points_.size()-1, 0, 
+                   compute_bounding_box(0, points_.size()-1, pool), 
+                   nodes_, splits.empty() ? nullptr : splits.data(), pool); 
+    apply_layout();
+    root_ = &nodes_[0];
   }
 }
 
-template<int D, typename AttrT, typename FloatT>
-Kdtree<D,AttrT,FloatT>::Kdtree(
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+Kdtree<D,AttrT,FloatT,BoundT>::Kdtree(
     const std::vector<DataPointType> &points, int leaf_nmax) 
-  : points_(points), root_(nullptr), leaf_nmax_(leaf_nmax) {
+  : points_(points), root_(nullptr) {
+  options_.leaf_nmax = leaf_nmax;
   initialize();
 }
 
-template<int D, typename AttrT, typename FloatT>
-Kdtree<D,AttrT,FloatT>::Kdtree(
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+Kdtree<D,AttrT,FloatT,BoundT>::Kdtree(
     std::vector<DataPointType> &&points, int leaf_nmax) 
-  : points_(std::move(points)), root_(nullptr), leaf_nmax_(leaf_nmax) {
+  : points_(std::move(points)), root_(nullptr) {
+  options_.leaf_nmax = leaf_nmax;
   initialize();
 }
 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+Kdtree<D,AttrT,FloatT,BoundT>::Kdtree(
+    const std::vector<DataPointType> &points, const KdtreeOptions &options) 
+  : points_(points), root_(nullptr), options_(options) {
+  initialize();
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+Kdtree<D,AttrT,FloatT,BoundT>::Kdtree(
+    std::vector<DataPointType> &&points, const KdtreeOptions &options) 
+  : points_(std::move(points)), root_(nullptr), options_(options) {
+  initialize();
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+Kdtree<D,AttrT,FloatT,BoundT>::Kdtree(
+    const std::vector<DataPointType> &points, const KdtreeOptions &options, 
+    ThreadPool *pool) 
+  : points_(points), root_(nullptr), options_(options) {
+  initialize(pool);
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+Kdtree<D,AttrT,FloatT,BoundT>::Kdtree(
+    std::vector<DataPointType> &&points, const KdtreeOptions &options, 
+    ThreadPool *pool) 
+  : points_(std::move(points)), root_(nullptr), options_(options) {
+  initialize(pool);
+}
+
 // merge duplicate keys in the data by merging the attributes. 
-template<int D, typename AttrT, typename FloatT>
-void Kdtree<D,AttrT,FloatT>::merge_duplicates() {
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::merge_duplicates(ThreadPool *pool) {
 
   if (points_.empty()) { return; }
 
+  switch (options_.dedup) {
+    case KdtreeDedup::Sort: sort_merge_duplicates(pool); break;
+    case KdtreeDedup::Hash: hash_merge_duplicates(pool); break;
+    case KdtreeDedup::None: break;
+  }
+}
+
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::sort_merge_duplicates(ThreadPool *pool) {
+
   // preprocess by sorting the data points lexicographically
   // note: exact comparison of floating point is ok for this purpose
-  std::sort(points_.begin(), points_.end(), ExactLexicoLess<DataPointType>);
+  if (pool) {
+    parallel_sort(points_.begin(), points_.end(), ExactLexicoLess<DataPointType>, *pool);
+  } else {
+    std::sort(points_.begin(), points_.end(), ExactLexicoLess<DataPointType>);
+  }
 
   // remove duplicates by merging attributes. 
   // algorithm is similar to the partition step in quicksort.
@@ -389,25 +1112,174 @@ void Kdtree<D,AttrT,FloatT>::merge_duplicates() {
 
 }
 
+// hash based deduplication in three parallel passes: 
+// (1) hash every point and scatter the indices into buckets by the high 
+//     bits of their hash. within a bucket, indices stay in input order. 
+// (2) deduplicate each bucket independently with an open addressing table. 
+// (3) stably compact points_ to the surviving first occurrences. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::hash_merge_duplicates(ThreadPool *pool) {
+
+  const size_t n = points_.size();
+  const int bucket_bits = 8; 
+  const size_t n_buckets = size_t(1) << bucket_bits;
+  const size_t grain = 1 << 14;
+
+  // equal points must hash equally; x + 0 maps -0.0 to +0.0. 
+  std::vector<std::uint64_t> hashes(n);
+  parallel_for(pool, 0, n, grain, [&] (size_t b, size_t e) {
+    for (size_t k = b; k < e; ++k) {
+      std::uint64_t h = 0;
+      for (int d = 0; d < D; ++d) {
+        h ^= std::hash<FloatType>()(points_[k][d] + FloatType(0));
+        h *= 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 29;
+      }
+      hashes[k] = h;
+    }
+  });
+
+  // (1) counting sort of the indices by bucket. blocks are fixed in size, 
+  // independently of the number of threads, to keep the result deterministic.
+  size_t n_blocks = (n + grain - 1) / grain;
+  std::vector<size_t> offsets(n_blocks * n_buckets, 0);
+  parallel_for(pool, 0, n_blocks, 1, [&] (size_t b, size_t e) {
+    for (size_t blk = b; blk < e; ++blk) {
+      for (size_t k = blk*grain; k < std::min(n, (blk+1)*grain); ++k) {
+        ++offsets[blk*n_buckets + (hashes[k] >> (64-bucket_bits))];
+      }
+    }
+  });
+
+  std::vector<size_t> bucket_start(n_buckets+1, 0);
+  size_t total = 0;
+  for (size_t c = 0; c < n_buckets; ++c) {
+    bucket_start[c] = total;
+    for (size_t blk = 0; blk < n_blocks; ++blk) {
+      size_t cnt = offsets[blk*n_buckets + c];
+      offsets[blk*n_buckets + c] = total;
+      total += cnt;
+    }
+  }
+  bucket_start[n_buckets] = total;
+
+  std::vector<size_t> bucketed(n);
+  parallel_for(pool, 0, n_blocks, 1, [&] (size_t b, size_t e) {
+    for (size_t blk = b; blk < e; ++blk) {
+      for (size_t k = blk*grain; k < std::min(n, (blk+1)*grain); ++k) {
+        bucketed[offsets[blk*n_buckets + (hashes[k] >> (64-bucket_bits))]++] = k;
+      }
+    }
+  });
+
+  // (2) buckets are disjoint in the points they touch. keep[k] is 0 for 
+  // every point that was merged into an earlier occurrence. 
+  std::vector<char> keep(n, 1);
+  parallel_for(pool, 0, n_buckets, 1, [&] (size_t b, size_t e) {
+    std::vector<size_t> table;
+    for (size_t c = b; c < e; ++c) {
+
+      size_t first = bucket_start[c], last = bucket_start[c+1];
+      if (last - first < 2) { continue; }
+
+      size_t capacity = 1; 
+      while (capacity < 2*(last-first)) { capacity <<= 1; }
+      table.assign(capacity, n);
+
+      for (size_t t = first; t < last; ++t) {
+        size_t k = bucketed[t];
+        size_t slot = hashes[k] & (capacity-1);
+        while (table[slot] != n && !ExactEqual(points_[table[slot]], points_[k])) {
+          slot = (slot + 1) & (capacity-1);
+        }
+        if (table[slot] == n) { 
+          table[slot] = k; 
+        } else {
+          size_t i = table[slot];
+          points_[i].set_attributes(merge(points_[i].attributes(), points_[k].attributes()));
+          keep[k] = 0;
+        }
+      }
+    }
+  });
+
+  // (3) stable compaction. each block first counts its survivors. 
+  std::vector<size_t> n_kept(n_blocks+1, 0);
+  parallel_for(pool, 0, n_blocks, 1, [&] (size_t b, size_t e) {
+    for (size_t blk = b; blk < e; ++blk) {
+      for (size_t k = blk*grain; k < std::min(n, (blk+1)*grain); ++k) {
+        n_kept[blk+1] += keep[k];
+      }
+    }
+  });
+  for (size_t blk = 0; blk < n_blocks; ++blk) { n_kept[blk+1] += n_kept[blk]; }
+  if (n_kept[n_blocks] == n) { return; }
+
+  std::vector<DataPointType> unique(n_kept[n_blocks]);
+  parallel_for(pool, 0, n_blocks, 1, [&] (size_t b, size_t e) {
+    for (size_t blk = b; blk < e; ++blk) {
+      size_t i = n_kept[blk];
+      for (size_t k = blk*grain; k < std::min(n, (blk+1)*grain); ++k) {
+        if (keep[k]) { unique[i++] = std::move(points_[k]); }
+      }
+    }
+  });
+  points_.swap(unique);
+}
+
 
 // if points_ is non-empty, return the minimum area axis-aligned rectangle that 
-// containing all DataPointType's in points_. otherwise return a degenerate rectangle 
-// (a rectangle of 0 length edges at the origin)
-template<int D, typename AttrT, typename FloatT>
-typename Kdtree<D,AttrT,FloatT>::RectangleType Kdtree<D,AttrT,FloatT>::compute_bounding_box() const {
+// containing all DataPointType's in points_ within the *closed* indices interval 
+// [first,last]. otherwise return a degenerate rectangle (a rectangle of 0 length 
+// edges at the origin)
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+typename Kdtree<D,AttrT,FloatT,BoundT>::RectangleType 
+Kdtree<D,AttrT,FloatT,BoundT>::compute_bounding_box(int first, int last, ThreadPool *pool) const {
 
   // handle the empty data set. 
   if (points_.empty()) { return RectangleType(); }
 
-  // simply scan through points_ to find the mininimum and maximum 
+  // small ranges are not worth the parallel reduction. 
+  size_t n = last - first + 1;
+  if (n < (1 << 16)) { pool = nullptr; }
+
+  // scan through a block of points_ to find the mininimum and maximum 
   // coordinate value in each dimension. 
-  std::vector<FloatType> min_coord_val(D, std::numeric_limits<FloatType>::max());
-  std::vector<FloatType> max_coord_val(D, std::numeric_limits<FloatType>::min());
-  for (const auto &p : points_) {
-    for (int i = 0; i < D; ++i) { 
-      min_coord_val[i] = std::min(p[i], min_coord_val[i]);
-      max_coord_val[i] = std::max(p[i], max_coord_val[i]);
+  auto scan = [this] (size_t b, size_t e, FloatType *min_val, FloatType *max_val) {
+    for (size_t k = b; k < e; ++k) {
+      for (int i = 0; i < D; ++i) { 
+        min_val[i] = std::min(points_[k][i], min_val[i]);
+        max_val[i] = std::max(points_[k][i], max_val[i]);
+      }
     }
+  };
+
+  FloatType min_coord_val[D], max_coord_val[D];
+  std::fill(min_coord_val, min_coord_val+D, std::numeric_limits<FloatType>::max());
+  std::fill(max_coord_val, max_coord_val+D, std::numeric_limits<FloatType>::lowest());
+
+  if (pool) {
+
+    // reduce the per-block extrema when running in parallel.
+    size_t n_blocks = 4 * pool->size();
+    size_t block = (n + n_blocks - 1) / n_blocks;
+    std::vector<FloatType> block_min(n_blocks*D, std::numeric_limits<FloatType>::max());
+    std::vector<FloatType> block_max(n_blocks*D, std::numeric_limits<FloatType>::lowest());
+    pool->parallel_for(0, n_blocks, 1, [&] (size_t b, size_t e) {
+      for (size_t k = b; k < e; ++k) {
+        scan(first + std::min(k*block, n), first + std::min((k+1)*block, n), 
+             &block_min[k*D], &block_max[k*D]);
+      }
+    });
+    for (size_t k = 0; k < n_blocks; ++k) {
+      for (int i = 0; i < D; ++i) { 
+        min_coord_val[i] = std::min(min_coord_val[i], block_min[k*D+i]);
+        max_coord_val[i] = std::max(max_coord_val[i], block_max[k*D+i]);
+      }
+    }
+
+  } else {
+    scan(first, last+1, min_coord_val, max_coord_val);
   }
 
   // initialize and resize a rectangle to the min/max coordinates. 
@@ -419,92 +1291,463 @@ typename Kdtree<D,AttrT,FloatT>::RectangleType Kdtree<D,AttrT,FloatT>::compute_b
   return r;
 }
 
-// returns a pointer to the root of a Kdtree constructed over elements in points_
-// within the *closed* indices interval [i,j]. Uses a pre-order tree walk. 
-// + d indexes the dimension to perform the first split.
-// + bbox is a minimum area rectangle containing all the points in [i,j].
+// appends the nodes of a Kdtree constructed over elements in points_ within 
+// the *closed* indices interval [i,j] to `nodes` and returns the index of its
+// root in `nodes`. Uses a pre-order tree walk. 
+// + d indexes the dimension to perform the first split under KdtreeSplit::RoundRobin.
+// + bbox is the cell of the subtree; it contains all the points in [i,j].
 // + this procedure rearranges points_ such that the indices stored at the leaves
 //   refer to the appropriate data point. 
+// + if `splits` is not null, indirect_partition() has already partitioned 
+//   points_, and the split of the node whose median is at m is splits[m]. 
+// + if `pool` is not null, subtrees with enough points are built in parallel. 
 // Note: do NOT change the ordering of points_ outside of this function. 
-template<int D, typename AttrT, typename FloatT>
-typename Kdtree<D,AttrT,FloatT>::Node* 
-Kdtree<D,AttrT,FloatT>::construct_tree(
-    int i, int j, int d, const RectangleType &bbox) {
-
-  Node *p = new Node();
-  p->start_idx_ = i;
-  p->end_idx_ = j;
-
-  // explicitly store the bounding box at the node. 
-  p->bbox_ = bbox;
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+typename Kdtree<D,AttrT,FloatT,BoundT>::IndexType 
+Kdtree<D,AttrT,FloatT,BoundT>::construct_tree(
+    int i, int j, int d, const RectangleType &bbox, 
+    std::vector<Node> &nodes, const FloatType *splits, ThreadPool *pool) {
+
+  // subtrees smaller than this are not worth forking. 
+  const int fork_nmin = 1 << 12;
+
+  // nodes may reallocate during recursion; refer to nodes by index only. 
+  IndexType p = nodes.size();
+  nodes.emplace_back();
+  nodes[p].start_idx_ = i;
+  nodes[p].end_idx_ = j;
+
+  // explicitly store the bound at the node. the tight box is also 
+  // needed to find the dimension of maximum spread. 
+  RectangleType tight;
+  if (options_.tight_bbox || options_.split == KdtreeSplit::MaxSpread) {
+    tight = compute_bounding_box(i, j, pool);
+  }
+  assign_bound(nodes[p].bbox_, i, j, bbox, tight);
 
-  // create a leaf node when [i,j] contains no more than leaf_nmax_ indices. 
-  if (j-i+1 <= leaf_nmax_) { 
+  // create a leaf node when [i,j] contains no more than options_.leaf_nmax indices. 
+  if (j-i+1 <= options_.leaf_nmax) { 
 
-    p->attr_ = points_[i].attributes();
+    nodes[p].attr_ = points_[i].attributes();
     for (int k = i+1; k <= j; ++k) {
-      p->attr_.merge(points_[k].attributes());
+      nodes[p].attr_.merge(points_[k].attributes());
     }
 
-  // partition points_ by the lower median m. [i,m] go in the left subtree 
-  // while [m+1,j] go in the right subtree. 
+  // partition points_ at index m. [i,m] go in the left subtree while 
+  // [m+1,j] go in the right subtree. 
   } else {
 
-    // median finding in expected linear time. Note: C++ requires the end 
-    // iterator to be one past the last index, hence the +1 in the 3rd 
-    // argument. 
-    int m = i + (j-i) / 2;
-    std::nth_element(points_.begin()+i, points_.begin()+m, points_.begin()+j+1, 
-                    [d] (const DataPointType &p1, const DataPointType &p2) { return p1[d] < p2[d]; });
-    p->split_ = points_[m][d];
+    // choose the split dimension. 
+    if (options_.split != KdtreeSplit::RoundRobin) {
+      const RectangleType &r = options_.split == KdtreeSplit::MaxSpread ? tight : bbox;
+      d = 0;
+      for (int k = 1; k < D; ++k) { if (r[k].length() > r[d].length()) { d = k; } }
+    }
+
+    int m; FloatType split;
+    if (options_.split == KdtreeSplit::SlidingMidpoint) {
+
+      m = sliding_midpoint_partition(i, j, d, bbox, split);
+
+    } else if (splits) {
+
+      m = i + (j-i) / 2;
+      split = splits[m];
+
+    } else if (options_.curve != KdtreeCurve::None) {
 
-    // pre-order tree walk, but first partition the bounding box. 
-    RectangleType left_bbox = bbox.lower_halfspace(d, p->split_);
-    p->left_ = construct_tree(i, m, (d+1)%D, left_bbox);
+      m = stable_median_partition(i, j, d, split, pool);
 
-    RectangleType right_bbox = bbox.upper_halfspace(d, p->split_);
-    p->right_ = construct_tree(m+1, j, (d+1)%D, right_bbox);
+    } else {
+
+      // partition by the lower median in expected linear time. Note: C++ 
+      // requires the end iterator to be one past the last index, hence the 
+      // +1 in the 3rd argument. the partition itself runs in parallel near 
+      // the root. 
+      m = i + (j-i) / 2;
+      auto less_d = [d] (const DataPointType &p1, const DataPointType &p2) { return p1[d] < p2[d]; };
+      if (pool) {
+        parallel_nth_element(points_.begin()+i, points_.begin()+m, points_.begin()+j+1, less_d, *pool);
+      } else {
+        std::nth_element(points_.begin()+i, points_.begin()+m, points_.begin()+j+1, less_d);
+      }
+      split = points_[m][d];
+    }
+    nodes[p].set_split(split);
+
+    // pre-order tree walk, but first partition the bounding box. the left
+    // daughter immediately follows its parent. 
+    IndexType r;
+    if (pool && j-i+1 >= fork_nmin) {
+
+      // the right subtree goes into its own array while the left subtree 
+      // is appended to `nodes`; the two never touch the same memory. 
+      std::vector<Node> right_nodes;
+      pool->fork_join(
+        [&] { construct_tree(i, m, (d+1)%D, bbox.lower_halfspace(d, split), nodes, splits, pool); },
+        [&] { construct_tree(m+1, j, (d+1)%D, bbox.upper_halfspace(d, split), right_nodes, splits, pool); });
+      r = nodes.size();
+      nodes.insert(nodes.end(), right_nodes.begin(), right_nodes.end());
+
+    } else {
+      construct_tree(i, m, (d+1)%D, bbox.lower_halfspace(d, split), nodes, splits, pool);
+      r = construct_tree(m+1, j, (d+1)%D, bbox.upper_halfspace(d, split), nodes, splits, pool);
+    }
+
+    if (r - p > std::numeric_limits<std::uint32_t>::max()) {
+      throw std::length_error("Kdtree<>: construct_tree(): "
+                              "daughter offset exceeds 32 bits. ");
+    }
 
-    p->attr_ = merge(p->left_->attr_, p->right_->attr_);
+    nodes[p].left_ = 1;
+    nodes[p].right_ = r - p;
+    nodes[p].attr_ = merge(nodes[p+1].attr_, nodes[r].attr_);
   }
   return p;
 }
 
-template<int D, typename AttrT, typename FloatT>
-Kdtree<D,AttrT,FloatT>::Kdtree(Kdtree<D,AttrT,FloatT> &&obj) noexcept : 
-  points_(std::move(obj.points_)), 
-  leaf_nmax_(std::move(obj.leaf_nmax_)) {
-  root_ = obj.root_;
-  obj.root_ = nullptr;
+// partition points_ as construct_tree() would with median splits, moving 
+// small proxies instead of points: 
+// (1) copy the coordinates and the index of every point into a proxy. 
+// (2) select_proxies() partitions the proxies node by node. 
+// (3) permute points_ into the order of the proxies. 
+// the split of the node whose median is at index m is saved in splits[m]; 
+// distinct internal nodes have distinct medians. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::indirect_partition(
+    std::vector<FloatType> &splits, ThreadPool *pool) {
+
+  const size_t n = points_.size();
+  const size_t grain = 1 << 14;
+  if (n > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error("Kdtree<>: indirect_partition(): "
+                            "number of points exceeds 32 bits. ");
+  }
+
+  std::vector<BuildProxy> proxies(n);
+  parallel_for(pool, 0, n, grain, [&] (size_t b, size_t e) {
+    for (size_t k = b; k < e; ++k) { 
+      for (int d = 0; d < D; ++d) { proxies[k].x_[d] = points_[k][d]; }
+      proxies[k].idx_ = k;
+    }
+  });
+
+  splits.resize(n);
+  select_proxies(0, n-1, 0, proxies, splits, pool);
+
+  std::vector<DataPointType> permuted(n);
+  parallel_for(pool, 0, n, grain, [&] (size_t b, size_t e) {
+    for (size_t k = b; k < e; ++k) { permuted[k] = std::move(points_[proxies[k].idx_]); }
+  });
+  points_.swap(permuted);
+}
+
+// partition the proxies in the *closed* indices interval [i,j] at the lower 
+// median along d, chosen as in construct_tree(), save the split, and recurse. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::select_proxies(
+    int i, int j, int d, std::vector<BuildProxy> &proxies, 
+    std::vector<FloatType> &splits, ThreadPool *pool) const {
+
+  const int fork_nmin = 1 << 12;
+
+  if (j-i+1 <= options_.leaf_nmax) { return; }
+
+  if (options_.split == KdtreeSplit::MaxSpread) {
+    FloatType lower[D], upper[D];
+    std::fill(lower, lower+D, std::numeric_limits<FloatType>::max());
+    std::fill(upper, upper+D, std::numeric_limits<FloatType>::lowest());
+    for (int k = i; k <= j; ++k) {
+      for (int l = 0; l < D; ++l) { 
+        lower[l] = std::min(lower[l], proxies[k].x_[l]); 
+        upper[l] = std::max(upper[l], proxies[k].x_[l]); 
+      }
+    }
+    d = 0;
+    for (int l = 1; l < D; ++l) { if (upper[l] - lower[l] > upper[d] - lower[d]) { d = l; } }
+  }
+
+  int m = i + (j-i) / 2;
+  auto less_d = [d] (const BuildProxy &p1, const BuildProxy &p2) { return p1.x_[d] < p2.x_[d]; };
+  if (pool) {
+    parallel_nth_element(proxies.begin()+i, proxies.begin()+m, proxies.begin()+j+1, less_d, *pool);
+  } else {
+    std::nth_element(proxies.begin()+i, proxies.begin()+m, proxies.begin()+j+1, less_d);
+  }
+  splits[m] = proxies[m].x_[d];
+
+  if (pool && j-i+1 >= fork_nmin) {
+    pool->fork_join(
+      [&] { select_proxies(i, m, (d+1)%D, proxies, splits, pool); },
+      [&] { select_proxies(m+1, j, (d+1)%D, proxies, splits, pool); });
+  } else {
+    select_proxies(i, m, (d+1)%D, proxies, splits, pool);
+    select_proxies(m+1, j, (d+1)%D, proxies, splits, pool);
+  }
 }
 
-template<int D, typename AttrT, typename FloatT>
-Kdtree<D,AttrT,FloatT>::Kdtree(const Kdtree<D,AttrT,FloatT> &obj) 
-  : points_(obj.points_), leaf_nmax_(obj.leaf_nmax_) {
-  root_ = tree_deep_copy(obj.root_);
+// set `b` to the rectangle bounding the points in the *closed* indices interval 
+// [i,j]: `tight` under KdtreeOptions::tight_bbox, and `cell` otherwise. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline void Kdtree<D,AttrT,FloatT,BoundT>::assign_bound(
+    Rectangle<D,FloatT> &b, int, int, 
+    const RectangleType &cell, const RectangleType &tight) const {
+  b = options_.tight_bbox ? tight : cell;
 }
 
-// return a pointer to a deep copy of the tree pointed to by the argument. 
-template<int D, typename AttrT, typename FloatT>
-typename Kdtree<D,AttrT,FloatT>::Node* 
-Kdtree<D,AttrT,FloatT>::tree_deep_copy(
-    const Kdtree<D,AttrT,FloatT>::Node *target_r) const {
-  if (target_r == nullptr) { return nullptr; }
-  Node *r = new Node(*target_r);
-  r->left_ = tree_deep_copy(target_r->left_);
-  r->right_ = tree_deep_copy(target_r->right_);
-  return r;
+// same as above, rounded outward to single precision. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+inline void Kdtree<D,AttrT,FloatT,BoundT>::assign_bound(
+    CompactRectangle<D,FloatT> &b, int, int, 
+    const RectangleType &cell, const RectangleType &tight) const {
+  b = CompactRectangle<D,FloatT>(options_.tight_bbox ? tight : cell);
 }
 
-// delete Kdtree<>::Nodes by a post order tree walk. 
-template<int D, typename AttrT, typename FloatT>
-void Kdtree<D,AttrT,FloatT>::delete_tree(Node *p) {
-  if (p == nullptr) { return; }
-  if (!p->is_leaf()) { 
-    delete_tree(p->left_);
-    delete_tree(p->right_);
+// set `b` to the ball centered at the centroid of the points in the *closed* 
+// indices interval [i,j] whose radius reaches the farthest of them. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::assign_bound(
+    Ball<D,FloatT> &b, int i, int j, 
+    const RectangleType&, const RectangleType&) const {
+
+  typename DataPointType::PointType center;
+  for (int k = i; k <= j; ++k) {
+    for (int d = 0; d < D; ++d) { center[d] += points_[k][d]; }
+  }
+  for (int d = 0; d < D; ++d) { center[d] /= (j-i+1); }
+
+  FloatType r2 = ConstantTraits<FloatType>::zero();
+  for (int k = i; k <= j; ++k) {
+    FloatType dist2 = ConstantTraits<FloatType>::zero();
+    for (int d = 0; d < D; ++d) {
+      FloatType diff = points_[k][d] - center[d];
+      dist2 += diff * diff;
+    }
+    r2 = std::max(r2, dist2);
+  }
+
+  // pad the radius by a few ulps so that roundoff in the distances computed 
+  // from it can never exclude the farthest point. 
+  FloatType r = std::sqrt(r2);
+  r += 4 * std::numeric_limits<FloatType>::epsilon() * r;
+
+  b = Ball<D,FloatT>(center, r);
+}
+
+// partition points_ in the *closed* indices interval [i,j] along dimension d 
+// at the midpoint of `cell`, and return the last index m of the lower half. 
+// if either half is empty, the split slides to the nearest point, which 
+// then forms a half on its own. the split coordinate is saved in `split`. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+int Kdtree<D,AttrT,FloatT,BoundT>::sliding_midpoint_partition(
+    int i, int j, int d, const RectangleType &cell, FloatType &split) {
+
+  auto first = points_.begin()+i, last = points_.begin()+j+1;
+  auto less_d = [d] (const DataPointType &p1, const DataPointType &p2) { return p1[d] < p2[d]; };
+
+  FloatType mid = cell[d].middle();
+  auto below = [d, mid] (const DataPointType &p) { return p[d] < mid; };
+  int m = (options_.curve == KdtreeCurve::None ? std::partition(first, last, below) 
+                                                 : std::stable_partition(first, last, below))
+          - points_.begin() - 1;
+
+  // rotations instead of swaps keep the order of the other points. 
+  split = mid;
+  if (m < i) {
+    auto it = std::min_element(first, last, less_d);
+    std::rotate(first, it, it+1);
+    m = i; split = points_[i][d];
+  } else if (m == j) {
+    auto it = std::max_element(first, last, less_d);
+    std::rotate(it, it+1, last);
+    m = j-1; split = points_[j][d];
+  }
+
+  return m;
+}
+
+// sort points_ along options_.curve through their bounding box. ties 
+// keep their relative order. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::curve_sort(ThreadPool *pool) {
+
+  if (options_.curve == KdtreeCurve::None || points_.size() < 2) { return; }
+
+  const size_t n = points_.size();
+  const size_t grain = 1 << 14;
+  const int bits = curve_key_bits<D>();
+  RectangleType bbox = compute_bounding_box(0, n-1, pool);
+
+  std::vector<std::pair<std::uint64_t, size_t>> keys(n);
+  parallel_for(pool, 0, n, grain, [&] (size_t b, size_t e) {
+    std::uint32_t x[D];
+    for (size_t k = b; k < e; ++k) {
+      for (int i = 0; i < D; ++i) { 
+        x[i] = curve_grid_coordinate(points_[k][i], bbox[i].lower(), bbox[i].upper(), bits);
+      }
+      keys[k].first = options_.curve == KdtreeCurve::Morton ? morton_key<D>(x) : hilbert_key<D>(x);
+      keys[k].second = k;
+    }
+  });
+
+  if (pool) {
+    parallel_sort(keys.begin(), keys.end(), 
+                  std::less<std::pair<std::uint64_t, size_t>>(), *pool, grain);
+  } else {
+    std::sort(keys.begin(), keys.end());
+  }
+
+  std::vector<DataPointType> sorted(n);
+  parallel_for(pool, 0, n, grain, [&] (size_t b, size_t e) {
+    for (size_t k = b; k < e; ++k) { sorted[k] = std::move(points_[keys[k].second]); }
+  });
+  points_.swap(sorted);
+}
+
+// partition points_ in the *closed* indices interval [i,j] at the lower 
+// median along dimension d, as construct_tree() does, but without changing 
+// the relative order of the points on either side. sets `split` to the 
+// median and returns the last index of the left side. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+int Kdtree<D,AttrT,FloatT,BoundT>::stable_median_partition(
+    int i, int j, int d, FloatType &split, ThreadPool *pool) {
+
+  // select the median among a copy of the coordinates. 
+  int m = i + (j-i) / 2;
+  std::vector<FloatType> coords(j-i+1);
+  for (int k = i; k <= j; ++k) { coords[k-i] = points_[k][d]; }
+  if (pool) {
+    parallel_nth_element(coords.begin(), coords.begin()+(m-i), coords.end(), 
+                         std::less<FloatType>(), *pool);
+  } else {
+    std::nth_element(coords.begin(), coords.begin()+(m-i), coords.end());
+  }
+  split = coords[m-i];
+
+  // at most m-i points are below the median and at least m-i+1 are not 
+  // above it. the left side takes the former and, in order, as many points 
+  // equal to the median as it needs. 
+  int n_equal = m-i+1;
+  for (int k = i; k <= j; ++k) { n_equal -= points_[k][d] < split; }
+
+  std::vector<DataPointType> right; right.reserve(j-m);
+  int w = i;
+  for (int k = i; k <= j; ++k) {
+    bool left = points_[k][d] < split || (!(split < points_[k][d]) && n_equal-- > 0);
+    if (left) { points_[w++] = std::move(points_[k]); } 
+    else { right.push_back(std::move(points_[k])); }
+  }
+  std::move(right.begin(), right.end(), points_.begin()+m+1);
+
+  return m;
+}
+
+// rearrange nodes_, which is in pre-order after construct_tree(), 
+// according to options_.layout. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::apply_layout() {
+
+  if (nodes_.empty() || options_.layout == KdtreeLayout::DepthFirst) { return; }
+
+  // order[k] is the current index of the node that should be stored at k. 
+  std::vector<IndexType> order; order.reserve(nodes_.size());
+  if (options_.layout == KdtreeLayout::BreadthFirst) {
+    breadth_first_order(order);
+  } else {
+    van_emde_boas_order(0, height(0), order);
+  }
+
+  std::vector<IndexType> position(nodes_.size());
+  for (IndexType k = 0; k < order.size(); ++k) { position[order[k]] = k; }
+
+  // both layouts place daughters after their parents, so the 
+  // relative offsets remain positive. 
+  std::vector<Node> relaid(nodes_.size());
+  for (IndexType k = 0; k < order.size(); ++k) {
+    const Node &n = nodes_[order[k]];
+    relaid[k] = n;
+    if (!n.is_leaf()) {
+      IndexType l = position[order[k]+n.left_], r = position[order[k]+n.right_];
+      if (l - k > std::numeric_limits<std::uint32_t>::max() || 
+          r - k > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error("Kdtree<>: apply_layout(): "
+                                "daughter offset exceeds 32 bits. ");
+      }
+      relaid[k].left_ = l - k;
+      relaid[k].right_ = r - k;
+    }
+  }
+
+  nodes_.swap(relaid);
+}
+
+// level order traversal of nodes_ starting from the root. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::breadth_first_order(std::vector<IndexType> &order) const {
+  std::queue<IndexType> q; q.push(0);
+  while (!q.empty()) {
+    IndexType k = q.front(); q.pop();
+    order.push_back(k);
+    if (!nodes_[k].is_leaf()) {
+      q.push(k + nodes_[k].left_);
+      q.push(k + nodes_[k].right_);
+    }
   }
-  delete p; 
+}
+
+// van Emde Boas order of the subtree rooted at nodes_[k], restricted to its 
+// top h levels. the top floor(h/2) levels are laid out first, followed by 
+// each subtree hanging below them from left to right. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::van_emde_boas_order(
+    IndexType k, int h, std::vector<IndexType> &order) const {
+
+  if (h == 1 || nodes_[k].is_leaf()) { order.push_back(k); return; }
+
+  int h_top = h / 2;
+  van_emde_boas_order(k, h_top, order);
+
+  std::vector<IndexType> bottom;
+  collect_at_depth(k, h_top, bottom);
+  for (auto b : bottom) { van_emde_boas_order(b, h-h_top, order); }
+}
+
+// collect, from left to right, the nodes at depth `depth` below nodes_[k]. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+void Kdtree<D,AttrT,FloatT,BoundT>::collect_at_depth(
+    IndexType k, int depth, std::vector<IndexType> &result) const {
+  if (depth == 0) { result.push_back(k); return; }
+  if (nodes_[k].is_leaf()) { return; }
+  collect_at_depth(k + nodes_[k].left_, depth-1, result);
+  collect_at_depth(k + nodes_[k].right_, depth-1, result);
+}
+
+// number of levels in the subtree rooted at nodes_[k]. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+int Kdtree<D,AttrT,FloatT,BoundT>::height(IndexType k) const {
+  if (nodes_[k].is_leaf()) { return 1; }
+  return 1 + std::max(height(k + nodes_[k].left_), 
+                      height(k + nodes_[k].right_));
+}
+
+// the node array is position independent, so moving it 
+// keeps the root_ pointer valid. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+Kdtree<D,AttrT,FloatT,BoundT>::Kdtree(Kdtree<D,AttrT,FloatT,BoundT> &&obj) noexcept : 
+  points_(std::move(obj.points_)), 
+  nodes_(std::move(obj.nodes_)),
+  root_(obj.root_),
+  options_(std::move(obj.options_)) {
+  obj.root_ = nullptr;
+}
+
+// copying the node array is a bulk copy; only the root_ pointer 
+// needs to be redirected. 
+template<int D, typename AttrT, typename FloatT, typename BoundT>
+Kdtree<D,AttrT,FloatT,BoundT>::Kdtree(const Kdtree<D,AttrT,FloatT,BoundT> &obj) 
+  : points_(obj.points_), nodes_(obj.nodes_), 
+    root_(nullptr), options_(obj.options_) {
+  if (!nodes_.empty()) { root_ = &nodes_[0]; }
 }
 
 }
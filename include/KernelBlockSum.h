@@ -0,0 +1,387 @@
+#ifndef BBRCITKDE_KERNELBLOCKSUM_H__
+#define BBRCITKDE_KERNELBLOCKSUM_H__
+
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+#include <KdeTraits.h>
+#include <Kernels/KernelTraits.h>
+
+// vector extensions and function multiversioning need gcc or clang on x86.
+// elsewhere, and under nvcc, the block sums fall back to the scalar loop.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(__CUDACC__)
+#define BBRCITKDE_SIMD_X86 1
+#endif
+
+// API
+// ---
+
+namespace bbrcit {
+
+// instruction sets the block sums may run on.
+enum class SimdIsa { Scalar, Sse2, Avx2, Avx512 };
+
+// returns the instruction set the block sums run on: the widest one this
+// cpu supports, unless lowered through set_simd_isa().
+SimdIsa simd_isa();
+
+// returns the widest instruction set this cpu supports.
+SimdIsa detected_simd_isa();
+
+// makes the block sums run on `isa`, or on detected_simd_isa() if it is
+// wider. meant for tests and benchmarks comparing the implementations.
+void set_simd_isa(SimdIsa isa);
+
+// returns the name of `isa`.
+const char* simd_isa_name(SimdIsa isa);
+
+// returns sum_i masses[i] * kernel.unnormalized_eval(p, q_i, abws[i]) over
+// the `n` points q_i whose d'th coordinates are coords[d][0..n).
+//
+// kernels with KernelBlockTraits<> are evaluated `W` points at a time, with
+// W set by simd_isa(); the lanes are summed in a different order than the
+// scalar loop, and exp() is a polynomial approximation good to about 1 ulp,
+// so results agree with it up to rounding. other kernels, and FloatT other
+// than double, run the scalar loop.
+template<typename KernT, typename PointT, typename FloatT>
+FloatT kernel_block_sum(const KernT &kernel, const PointT &p,
+                        const FloatT *const *coords, const FloatT *abws,
+                        const FloatT *masses, size_t n);
+
+// adds kernel_block_sum(kernel, queries[k], coords, abws, masses, n) to 
+// results[k] for each of the `n_queries` points queries[k]. 
+//
+// each sum is computed exactly as kernel_block_sum() computes it, whatever 
+// the number of queries; but the points are swept in tiles that stay in the 
+// l1 cache while every query sums over them, and each vector of points is 
+// loaded once for several queries, whose partial sums stay in registers. 
+template<typename KernT, typename PointT, typename FloatT>
+void kernel_block_sums(const KernT &kernel, const PointT *queries, size_t n_queries,
+                       const FloatT *const *coords, const FloatT *abws,
+                       const FloatT *masses, size_t n, FloatT *results);
+
+// Implementations
+// ---------------
+
+namespace kernel_block_sum_impl {
+
+// widest supported instruction set, or the one forced through
+// set_simd_isa(). -1 until the first call to simd_isa().
+inline std::atomic<int>& isa_state() {
+  static std::atomic<int> isa(-1);
+  return isa;
+}
+
+template<typename KernT, typename PointT, typename FloatT>
+FloatT scalar_sum(const KernT &kernel, const PointT &p,
+                  const FloatT *const *coords, const FloatT *abws,
+                  const FloatT *masses, size_t n) {
+  FloatT total = ConstantTraits<FloatT>::zero();
+  PointT q;
+  for (size_t i = 0; i < n; ++i) {
+    for (int d = 0; d < PointT::dim(); ++d) { q[d] = coords[d][i]; }
+    total += masses[i] * kernel.unnormalized_eval(p, q, abws[i]);
+  }
+  return total;
+}
+
+#ifdef BBRCITKDE_SIMD_X86
+
+#define BBRCITKDE_ALWAYS_INLINE inline __attribute__((always_inline))
+
+// W lanes of doubles and of their bits. vector_size does not take a
+// dependent size, hence the specializations.
+template<int W> struct VectorTypes;
+template<> struct VectorTypes<2> {
+  typedef double V __attribute__((vector_size(16)));
+  typedef int64_t VI __attribute__((vector_size(16)));
+};
+template<> struct VectorTypes<4> {
+  typedef double V __attribute__((vector_size(32)));
+  typedef int64_t VI __attribute__((vector_size(32)));
+};
+template<> struct VectorTypes<8> {
+  typedef double V __attribute__((vector_size(64)));
+  typedef int64_t VI __attribute__((vector_size(64)));
+};
+
+// exp(x) over each lane; cephes' argument reduction and Pade approximant.
+// 2^n is assembled in the exponent bits, so x is clamped to the range
+// where that is a normal number; exp(-708) underflows every sum anyway.
+template<typename V, typename VI>
+BBRCITKDE_ALWAYS_INLINE void vexp(V &x) {
+  const V lo = V{} - 708.0, hi = V{} + 709.0;
+  x = x < lo ? lo : x;
+  x = x > hi ? hi : x;
+
+  // n = round(x/ln2) through the 1.5 * 2^52 rounding trick; its low bits
+  // then hold n as an integer.
+  const V shifter = V{} + 6755399441055744.0;
+  V t = x * 1.4426950408889634073599 + shifter;
+  V n = t - shifter;
+  x = x - n * 6.93145751953125E-1;
+  x = x - n * 1.42860682030941723212E-6;
+
+  V xx = x * x;
+  V px = ((1.26177193074810590878E-4 * xx + 3.02994407707441961300E-2) * xx
+          + 9.99999999999999999910E-1) * x;
+  V qx = ((3.00198505138664455042E-6 * xx + 2.52448340349684104192E-3) * xx
+          + 2.27265548208155028766E-1) * xx + 2.00000000000000000009E0;
+  x = 1.0 + 2.0 * px / (qx - px);
+
+  VI e = ((VI) t - (VI) shifter + 1023) << 52;
+  x *= (V) e;
+}
+
+// queries whose partial sums are kept at a time, queries sharing each load 
+// of the points, and points in each tile. a tile is a multiple of every W; 
+// with D=2, its coordinates, masses, and bandwidths take 16KB. 
+constexpr size_t query_batch = 64;
+constexpr int query_block = 4;
+constexpr size_t tile_size = 512;
+
+// adds the contributions of points [b, e) to the W lane partial sums 
+// acc[q*W..(q+1)*W) of each of the Q queries p[q*D..(q+1)*D). e-b is a 
+// multiple of W. the operations on each query's lanes do not depend on Q. 
+template<int W, KernelBlockShape S, int D, int Q>
+BBRCITKDE_ALWAYS_INLINE void tile_sums(
+    const double *p, const double *scales, const double *const *coords,
+    const double *abws, const double *masses, size_t b, size_t e, double *acc) {
+
+  using V = typename VectorTypes<W>::V;
+  using VI = typename VectorTypes<W>::VI;
+
+  const V one = V{} + 1.0, zero = V{};
+  V sums[Q];
+  for (int q = 0; q < Q; ++q) { std::memcpy(&sums[q], acc + q*W, sizeof(V)); }
+
+  for (size_t i = b; i < e; i += W) {
+    V a, m, x;
+    std::memcpy(&a, abws + i, sizeof(V));
+    std::memcpy(&m, masses + i, sizeof(V));
+    V inv_a2 = one / (a * a);
+
+    V k[Q], arg[Q];
+    for (int q = 0; q < Q; ++q) { k[q] = one; arg[q] = zero; }
+    for (int d = 0; d < D; ++d) {
+      std::memcpy(&x, coords[d] + i, sizeof(V));
+      for (int q = 0; q < Q; ++q) {
+        V diff = x - p[q*D+d];
+        V t = diff * diff * scales[d];
+        if (S == KernelBlockShape::EpanechnikovProduct) {
+          t *= inv_a2;
+          k[q] *= t < one ? one - t : zero;
+        } else {
+          arg[q] += t;
+        }
+      }
+    }
+    for (int q = 0; q < Q; ++q) {
+      if (S == KernelBlockShape::Gaussian) {
+        arg[q] = -0.5 * (arg[q] * inv_a2);
+        vexp<V,VI>(arg[q]); k[q] = arg[q];
+      } else if (S == KernelBlockShape::Epanechnikov) {
+        arg[q] *= inv_a2;
+        k[q] = arg[q] < one ? one - arg[q] : zero;
+      }
+      sums[q] += m * k[q];
+    }
+  }
+
+  for (int q = 0; q < Q; ++q) { std::memcpy(acc + q*W, &sums[q], sizeof(V)); }
+}
+
+// adds the sums of the `n_queries` <= query_batch queries p[k*D..(k+1)*D) 
+// to results[k]. the points are summed W at a time, tile by tile; the 
+// remainder runs through the same formulas one lane wide. vectors never 
+// cross a function boundary by value, so these compile the same whatever 
+// the caller's target. 
+template<int W, KernelBlockShape S, int D>
+BBRCITKDE_ALWAYS_INLINE void block_sums(
+    const double *p, size_t n_queries, const double *scales, 
+    const double *const *coords, const double *abws, const double *masses, 
+    size_t n, double *results) {
+
+  double acc[query_batch * W];
+  std::fill(acc, acc + n_queries * W, 0.0);
+
+  const size_t n_vec = n - n % W;
+  for (size_t t = 0; t < n_vec; t += tile_size) {
+    size_t t_end = std::min(t + tile_size, n_vec);
+    size_t k = 0;
+    for (; k + query_block <= n_queries; k += query_block) {
+      tile_sums<W,S,D,query_block>(p + k*D, scales, coords, abws, masses, t, t_end, acc + k*W);
+    }
+    for (; k < n_queries; ++k) {
+      tile_sums<W,S,D,1>(p + k*D, scales, coords, abws, masses, t, t_end, acc + k*W);
+    }
+  }
+
+  for (size_t k = 0; k < n_queries; ++k) {
+
+    const double *pk = p + k*D;
+    double total = 0.0;
+    for (int l = 0; l < W; ++l) { total += acc[k*W+l]; }
+
+    for (size_t i = n_vec; i < n; ++i) {
+      double inv_a2 = 1.0 / (abws[i] * abws[i]);
+      double kv = 1.0, arg = 0.0;
+      for (int d = 0; d < D; ++d) {
+        double diff = coords[d][i] - pk[d];
+        double t = diff * diff * scales[d];
+        if (S == KernelBlockShape::EpanechnikovProduct) {
+          t *= inv_a2;
+          kv *= t < 1.0 ? 1.0 - t : 0.0;
+        } else {
+          arg += t;
+        }
+      }
+      if (S == KernelBlockShape::Gaussian) {
+        kv = std::exp(-0.5 * (arg * inv_a2));
+      } else if (S == KernelBlockShape::Epanechnikov) {
+        arg *= inv_a2;
+        kv = arg < 1.0 ? 1.0 - arg : 0.0;
+      }
+      total += masses[i] * kv;
+    }
+
+    results[k] += total;
+  }
+}
+
+template<KernelBlockShape S, int D>
+__attribute__((target("avx2,fma")))
+void block_sums_avx2(const double *p, size_t n_queries, const double *scales, 
+                     const double *const *coords, const double *abws, 
+                     const double *masses, size_t n, double *results) {
+  block_sums<4,S,D>(p, n_queries, scales, coords, abws, masses, n, results);
+}
+
+template<KernelBlockShape S, int D>
+__attribute__((target("avx512f")))
+void block_sums_avx512(const double *p, size_t n_queries, const double *scales, 
+                       const double *const *coords, const double *abws, 
+                       const double *masses, size_t n, double *results) {
+  block_sums<8,S,D>(p, n_queries, scales, coords, abws, masses, n, results);
+}
+
+#undef BBRCITKDE_ALWAYS_INLINE
+
+#endif
+
+template<typename KernT, typename PointT, typename FloatT>
+inline void dispatch(std::false_type, const KernT &kernel, 
+                     const PointT *queries, size_t n_queries,
+                     const FloatT *const *coords, const FloatT *abws,
+                     const FloatT *masses, size_t n, FloatT *results) {
+  for (size_t k = 0; k < n_queries; ++k) {
+    results[k] += scalar_sum(kernel, queries[k], coords, abws, masses, n);
+  }
+}
+
+template<typename KernT, typename PointT>
+inline void dispatch(std::true_type, const KernT &kernel, 
+                     const PointT *queries, size_t n_queries,
+                     const double *const *coords, const double *abws,
+                     const double *masses, size_t n, double *results) {
+#ifdef BBRCITKDE_SIMD_X86
+  using Traits = KernelBlockTraits<KernT>;
+  constexpr int D = Traits::dim;
+  constexpr KernelBlockShape S = Traits::shape;
+  SimdIsa isa = simd_isa();
+  if (isa == SimdIsa::Scalar) {
+    dispatch(std::false_type(), kernel, queries, n_queries, coords, abws, masses, n, results);
+    return;
+  }
+
+  double p[query_batch * D], scales[D];
+  Traits::scales(kernel, scales);
+  for (size_t b = 0; b < n_queries; b += query_batch) {
+    size_t nb = std::min(query_batch, n_queries - b);
+    for (size_t k = 0; k < nb; ++k) {
+      for (int d = 0; d < D; ++d) { p[k*D+d] = queries[b+k][d]; }
+    }
+    switch (isa) {
+      case SimdIsa::Avx512:
+        block_sums_avx512<S,D>(p, nb, scales, coords, abws, masses, n, results + b);
+        break;
+      case SimdIsa::Avx2:
+        block_sums_avx2<S,D>(p, nb, scales, coords, abws, masses, n, results + b);
+        break;
+      default:
+        block_sums<2,S,D>(p, nb, scales, coords, abws, masses, n, results + b);
+        break;
+    }
+  }
+#else
+  dispatch(std::false_type(), kernel, queries, n_queries, coords, abws, masses, n, results);
+#endif
+}
+
+}
+
+inline SimdIsa detected_simd_isa() {
+#ifdef BBRCITKDE_SIMD_X86
+  static const SimdIsa isa = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) { return SimdIsa::Avx512; }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { return SimdIsa::Avx2; }
+    return SimdIsa::Sse2;
+  }();
+  return isa;
+#else
+  return SimdIsa::Scalar;
+#endif
+}
+
+inline SimdIsa simd_isa() {
+  int isa = kernel_block_sum_impl::isa_state().load(std::memory_order_relaxed);
+  if (isa < 0) {
+    isa = static_cast<int>(detected_simd_isa());
+    kernel_block_sum_impl::isa_state().store(isa, std::memory_order_relaxed);
+  }
+  return static_cast<SimdIsa>(isa);
+}
+
+inline void set_simd_isa(SimdIsa isa) {
+  SimdIsa widest = detected_simd_isa();
+  if (static_cast<int>(isa) > static_cast<int>(widest)) { isa = widest; }
+  kernel_block_sum_impl::isa_state().store(static_cast<int>(isa), std::memory_order_relaxed);
+}
+
+inline const char* simd_isa_name(SimdIsa isa) {
+  switch (isa) {
+    case SimdIsa::Sse2: return "sse2";
+    case SimdIsa::Avx2: return "avx2";
+    case SimdIsa::Avx512: return "avx512";
+    default: return "scalar";
+  }
+}
+
+template<typename KernT, typename PointT, typename FloatT>
+inline void kernel_block_sums(const KernT &kernel, const PointT *queries, size_t n_queries,
+                              const FloatT *const *coords, const FloatT *abws,
+                              const FloatT *masses, size_t n, FloatT *results) {
+  using Vectorized = std::integral_constant<bool,
+    KernelBlockTraits<KernT>::value && std::is_same<FloatT, double>::value>;
+  kernel_block_sum_impl::dispatch(Vectorized(), kernel, queries, n_queries, 
+                                  coords, abws, masses, n, results);
+}
+
+template<typename KernT, typename PointT, typename FloatT>
+inline FloatT kernel_block_sum(const KernT &kernel, const PointT &p,
+                               const FloatT *const *coords, const FloatT *abws,
+                               const FloatT *masses, size_t n) {
+  FloatT total = ConstantTraits<FloatT>::zero();
+  kernel_block_sums(kernel, &p, 1, coords, abws, masses, n, &total);
+  return total;
+}
+
+}
+
+#endif
@@ -2,36 +2,42 @@
 #define BBRCITKDE_KERNELDENSITY_H__
 
 #include <iostream>
+#include <type_traits>
+#include <memory>
+#include <utility>
 
 #include <Kdtree.h>
+#include <AlignedAllocator.h>
 #include <Attributes/AdaKdeAttributes.h>
 #include <Kernels/EpanechnikovKernel.h>
 
 #ifdef __CUDACC__
 #include <CudaDirectKde.h>
+#else
+#include <CpuDirectKde.h>
 #endif
 
 namespace bbrcit {
 
-template<int D, typename KT, typename FT, typename AT> class KernelDensity;
+template<int D, typename KT, typename FT, typename AT, typename TT> class KernelDensity;
 
 // custom swap for KernelDensity<>
-template<int D, typename KT, typename FT, typename AT>
-void swap(KernelDensity<D,KT,FT,AT>&, KernelDensity<D,KT,FT,AT>&);
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void swap(KernelDensity<D,KT,FT,AT,TT>&, KernelDensity<D,KT,FT,AT,TT>&);
 
 
 // least squares cross validation using numerical integration for 2d data. 
 #ifndef __CUDACC__
-template<typename KT, typename FT, typename AT>
+template<typename KT, typename FT, typename AT, typename TT>
 FT lsq_numint_cross_validate(
-    const KernelDensity<2,KT,FT,AT> &kde, 
+    const KernelDensity<2,KT,FT,AT,TT> &kde, 
     FT start_x, FT end_x, int step_x, 
     FT start_y, FT end_y, int step_y,
     FT rel_err=1e-6, FT abs_err=1e-8, int qtree_leaf_nmax=2);
 #else
-template<typename KT, typename FT, typename AT>
+template<typename KT, typename FT, typename AT, typename TT>
 FT lsq_numint_cross_validate(
-    const KernelDensity<2,KT,FT,AT> &kde, 
+    const KernelDensity<2,KT,FT,AT,TT> &kde, 
     FT start_x, FT end_x, int step_x, 
     FT start_y, FT end_y, int step_y,
     FT rel_err=1e-6, FT abs_err=1e-8, int qtree_leaf_nmax=1024,
@@ -41,16 +47,32 @@ FT lsq_numint_cross_validate(
 
 // KernelDensity<> implements a kernel density estimator in D dimensions 
 // using a D dimensional Kdtree. 
+//
+// TreeT is the spatial index over both the reference and the query points. 
+// It may be any Kdtree<D,AttrT,FloatT,BoundT>, e.g. BallTree<D,AttrT,FloatT>, 
+// whose bounds are tighter in higher dimensions, or CompactKdtree<D,AttrT,FloatT>, 
+// whose nodes are smaller. 
+//
+// On the CPU, dual tree evaluations, and hence eval() on many queries, 
+// self_eval(), cross validation and adapt_density(), run on as many threads 
+// as KdtreeOptions::n_threads of the data tree. Disjoint query subtrees are 
+// forked onto a work stealing ThreadPool; each task only updates the bounds 
+// in its own query subtree, and parents take the min/max of their 
+// daughters' bounds once both have joined. 
 template<int D, 
          typename KernelT=EpanechnikovKernel<D,double>,
          typename FloatT=double,
-         typename AttrT=AdaKdeAttributes<FloatT>>
+         typename AttrT=AdaKdeAttributes<FloatT>,
+         typename TreeT=Kdtree<D,AttrT,FloatT>>
 class KernelDensity {
 
+    static_assert(std::is_same<TreeT, Kdtree<D,AttrT,FloatT,typename TreeT::BoundType>>::value, 
+                  "KernelDensity<>: TreeT must be a Kdtree<D,AttrT,FloatT,BoundT>. ");
+
   public: 
 
     using FloatType = FloatT;
-    using KdtreeType = Kdtree<D,AttrT,FloatT>; 
+    using KdtreeType = TreeT; 
     using DataPointType = typename KdtreeType::DataPointType;
     using KernelType = KernelT;
     using KernelFloatType = typename KernelType::FloatType;
@@ -60,7 +82,7 @@ class KernelDensity {
 
   private:
 
-    using KernelDensityType = KernelDensity<D,KernelT,FloatT,AttrT>;
+    using KernelDensityType = KernelDensity<D,KernelT,FloatT,AttrT,TreeT>;
     using TreeNodeType = typename KdtreeType::Node;
     using GeomPointType = typename KdtreeType::DataPointType::PointType;
 
@@ -72,9 +94,12 @@ class KernelDensity {
     KernelDensity();
 
     // construct a kernel density estimator with 
-    // kernel `k` over the points `data`.
+    // kernel `k` over the points `data`. `options` configures 
+    // the construction of the data tree. 
     KernelDensity(const std::vector<DataPointType> &data, int leaf_nmax=2);
     KernelDensity(std::vector<DataPointType> &&data, int leaf_nmax=2);
+    KernelDensity(const std::vector<DataPointType> &data, const KdtreeOptions &options);
+    KernelDensity(std::vector<DataPointType> &&data, const KdtreeOptions &options);
 
     // copy-control
     KernelDensity(const KernelDensityType&) = default;
@@ -88,17 +113,37 @@ class KernelDensity {
     KernelType& kernel();
     void set_kernel(const KernelType&);
 
+    // if true, dual tree evaluations on the cpu defer their base cases: 
+    // the leaf pairs that cannot be approximated are recorded during the 
+    // traversal, and evaluated in bulk once it completes. the pairs are 
+    // grouped by query leaf, ordered as the data points, and the groups are 
+    // spread over the threads; each runs the block sums of KernelBlockSum.h 
+    // over runs of adjacent data leaves. 
+    //
+    // the bounds stay looser during the traversal, so that fewer node pairs 
+    // may be approximated; in exchange, the base cases run as large regular 
+    // loops. false by default. 
+    bool defer_base_cases() const;
+    void set_defer_base_cases(bool);
+
     // returns the number of data points
     size_t size() const;
 
     // returns a const reference to the data points
     const std::vector<DataPointType>& points() const;
 
+    // returns the sum of the weights in points(). the density weighs point i 
+    // by points()[i].attributes().weight() / weight_total(). 
+    FloatType weight_total() const;
+
     // returns a const reference to the data tree
     const KdtreeType& data_tree() const;
 
 
-    // return the direct kde evaluated at point `p` or at points in `queries`
+    // return the direct kde evaluated at point `p` or at points in `queries`. 
+    // on the cpu, `queries` are evaluated by a CpuDirectKde<> that views the 
+    // point arrays in place, on the estimator's threads; see the n_threads 
+    // option of the data tree. 
     FloatT direct_eval(DataPointType &p) const;
 #ifndef __CUDACC__
     void direct_eval(std::vector<DataPointType> &queries) const;
@@ -112,6 +157,9 @@ class KernelDensity {
     //   + the relative error is at most `rel_err`.
     //   + the absolute error is at most `abs_err`.
     // otherwise, it will report to stderr that precision has been lost. 
+    // kernels with MomentBoundTraits<>, such as the default Epanechnikov 
+    // kernel, prune against both tolerances with tighter bounds; their 
+    // results differ slightly from those of the usual bounds. 
     //
     // Note: for multi point queries, the method taking a vector<> first constructs 
     // KdtreeType<> before evaluation. Since such a construction uses randomized 
@@ -131,6 +179,81 @@ class KernelDensity {
               size_t block_size=128) const;
 #endif
 
+    // single tree evaluation at every point of `queries`: eval(queries[i], 
+    // rel_err, abs_err) for each i. no query tree is built and the queries 
+    // keep their order. this suits few or scattered queries, which share 
+    // too little of the data tree for the dual tree to pay off. the queries 
+    // are distributed over `n_threads` threads, with the same convention as 
+    // KdtreeOptions::n_threads, or over the threads of `pool`, which may be 
+    // kept across calls. precision losses are reported once every query is 
+    // done, in query order. 
+    void eval_parallel(std::vector<DataPointType> &queries, 
+                       FloatType rel_err, FloatType abs_err, int n_threads=1) const;
+    void eval_parallel(std::vector<DataPointType> &queries, 
+                       FloatType rel_err, FloatType abs_err, ThreadPool &pool) const;
+
+    // reusable storage for repeated eval() calls on vectors of queries: the 
+    // query tree, whose point and node arrays persist across calls. on a 
+    // single threaded estimator, calls with no more queries than any before 
+    // do not allocate. with n_threads != 1, this only holds for batches too 
+    // small to be split over the threads, i.e. below 1024 queries; larger 
+    // ones allocate for the forked build and traversal tasks. a context may 
+    // be used with any KernelDensity<> of the same type, but by one thread 
+    // at a time. 
+    class EvalContext {
+      public:
+        explicit EvalContext(int leaf_nmax=2) : leaf_nmax_(leaf_nmax) {}
+        int leaf_nmax() const { return leaf_nmax_; }
+        void set_leaf_nmax(int leaf_nmax) { leaf_nmax_ = leaf_nmax; }
+      private:
+        friend class KernelDensity;
+        int leaf_nmax_;
+        KdtreeType query_tree_;
+    };
+
+#ifndef __CUDACC__
+    void eval(std::vector<DataPointType> &queries, 
+              FloatType rel_err, FloatType abs_err, EvalContext &context) const;
+#else
+    void eval(std::vector<DataPointType> &queries, 
+              FloatType rel_err, FloatType abs_err, EvalContext &context, 
+              size_t block_size=128) const;
+#endif
+
+    // evaluate the kde at every reference point, including the point's own 
+    // contribution: `values[i]` is the kde at points()[i]. this is eval() on 
+    // a copy of data_tree(), except that data_tree() itself serves as the 
+    // query tree, so that no copy is made. 
+#ifndef __CUDACC__
+    void self_eval(std::vector<FloatType> &values, 
+                   FloatType rel_err, FloatType abs_err) const;
+#else
+    void self_eval(std::vector<FloatType> &values, 
+                   FloatType rel_err, FloatType abs_err, size_t block_size=128) const;
+#endif
+
+    // returns the leaf size, among the powers of two in [`min_leaf_nmax`, 
+    // `max_leaf_nmax`], at which self_eval() runs fastest on a sample of 
+    // `sample_size` points with the current kernel on this machine. the 
+    // sample is the neighborhood of a reference point, so that it is as dense 
+    // as the data itself. the result suits both the data tree and the query 
+    // trees of eval(). candidates above `sample_size`/64 are not timed: a 
+    // sample of only a few leaves says little about the full tree, so 
+    // calibrating large leaves takes a large sample. if `os` is given, the 
+    // timing of each candidate is reported to it, so that the choice can be 
+    // pinned. 
+#ifndef __CUDACC__
+    int calibrate_leaf_nmax(FloatType rel_err, FloatType abs_err, 
+                            size_t sample_size=10000, 
+                            int min_leaf_nmax=2, int max_leaf_nmax=4096,
+                            std::ostream *os=nullptr) const;
+#else
+    int calibrate_leaf_nmax(FloatType rel_err, FloatType abs_err, 
+                            size_t sample_size=10000, 
+                            int min_leaf_nmax=2, int max_leaf_nmax=65536,
+                            std::ostream *os=nullptr, size_t block_size=128) const;
+#endif
+
 
     // convert between adaptive and non-adaptive kernel density estimates.
     //
@@ -154,6 +277,20 @@ class KernelDensity {
     void unadapt_density();
 
 
+    // update the weights and local bandwidth corrections of the reference points 
+    // at positions `indices` in points(). `weights` are on the scale of the weights
+    // in points(). the other weights are left as they are, so that weight_total() 
+    // follows the updates; the density stays normalized regardless. masses follow 
+    // as in adapt_density(). 
+    //
+    // node attributes and moments are only refreshed on the paths to the updated 
+    // points, and the cumulative weights are a Fenwick tree, so updating k points 
+    // costs O(k log N). 
+    void update_points(const std::vector<size_t> &indices, 
+                       const std::vector<FloatType> &weights, 
+                       const std::vector<FloatType> &abws);
+
+
     // compute the cross validation score for the current 
     // kernel configuration. likelihood and least squares are available. 
     // see non-member `lsq_convolution_cross_validate` for another flavor of
@@ -199,29 +336,76 @@ class KernelDensity {
     // comments:
     //
     // + weight: these are the relative importance of each data point. 
-    //           throughout the lifetime of this KernelDensity<> object, 
-    //           we maintain the sum over all point weights to be 1.0. 
+    //           the constructors normalize the weights to sum to 1.0, but 
+    //           update_points() lets the sum drift; it is the weight of the 
+    //           root node. see weight_scale(). 
     //
     // + mass: while similar to weight, this is the actual contribution that
     //         the point has towards kde queries. though this is usually the 
     //         same as weight, it can be different; for example, in the adaptive
     //         kernels, this is the weight multiplied by local bandwidth corrections. 
+    //         masses are on the scale of the weights. 
     //
     KdtreeType data_tree_;
 
-    // cumulative weights of each data point. used for simulation. 
+    // Fenwick tree over the point weights, used for simulation: cum_weights_[i-1] 
+    // is the sum of the weights of points (i - (i & -i), i], 1-based. 
     std::vector<FloatType> cum_weights_;
 
+    // structure-of-arrays mirror of data_tree_.points_ in the same (leaf) order: 
+    // point_coords_[d][i], point_masses_[i], and point_abws_[i] are the d'th 
+    // coordinate, the mass, and the local bandwidth correction of point i. 
+    // base cases and direct evaluations stream through these instead of the 
+    // DataPointType's, whose other attributes they never read. 
+    AlignedVector<FloatType> point_coords_[D];
+    AlignedVector<FloatType> point_masses_;
+    AlignedVector<FloatType> point_abws_;
+
+    // mass weighted moments of the points under each node of data_tree_, 
+    // indexed as the node array: the centroid, and the spread, i.e. the mass 
+    // weighted mean squared distance to the centroid. see 
+    // estimate_mean_contributions(). empty unless KernelType has 
+    // MomentBoundTraits<>. 
+    struct NodeMoments {
+      GeomPointType centroid_;
+      FloatType spread_ = FloatType();
+    };
+    std::vector<NodeMoments> node_moments_;
+
+    // see set_defer_base_cases(). 
+    bool defer_base_cases_ = false;
+
+    // threads for the cpu dual tree evaluations, with the n_threads of the 
+    // data tree's options. null for a single thread. created once with the 
+    // estimator and shared by its copies; a ThreadPool takes work from any 
+    // number of outside threads. 
+    std::shared_ptr<ThreadPool> pool_;
+
     // helper functions for initialization
     // ------------------------------------------
     void initialize_attributes(std::vector<DataPointType>&);
     void normalize_weights(std::vector<DataPointType>&);
     void initialize_cum_weights();
+    void update_cum_weights(size_t, FloatType);
+    size_t find_cum_weight(FloatType) const;
+    void initialize_point_arrays();
+    void initialize_pool();
+    void refresh_node_moments(const TreeNodeType*);
+    void refresh_node_moments(const TreeNodeType*, const size_t*, const size_t*);
+    void compute_node_moments(const TreeNodeType*);
 
 
+    // returns 1 / weight_total(), the factor that turns the masses in 
+    // data_tree_ into those of a normalized density. evaluations apply it 
+    // along with the kernel normalization. 
+    FloatType weight_scale() const;
+
     // helper functions for direct kde evaluations
     // ------------------------------------------
 
+    // returns point i of data_tree_ as read from the structure-of-arrays mirror.
+    GeomPointType mirrored_point(size_t i) const;
+
     template<typename KernT> 
       FloatT direct_eval(const GeomPointType&, const KernT&) const;
 
@@ -241,11 +425,20 @@ class KernelDensity {
     template <typename KernT>
       FloatT eval(const GeomPointType&, const KernT&, FloatType, FloatType) const;
 
+    template <typename KernT>
+      FloatT single_tree_eval(const GeomPointType&, const KernT&, FloatType, FloatType, 
+                              FloatType&, FloatType&) const;
+
     template <typename KernT>
       void single_tree(
           const TreeNodeType*, const GeomPointType&, const KernT&, 
           FloatType&, FloatType&, FloatType, FloatType, FloatType, FloatType) const;
 
+    template <typename KernT>
+      void moment_single_tree(
+          const TreeNodeType*, const GeomPointType&, const KernT&, 
+          FloatType&, FloatType&, FloatType, FloatType, FloatType, FloatType) const;
+
     template <typename KernT>
       void single_tree_base(
           const TreeNodeType*, const GeomPointType&, const KernT&,
@@ -253,31 +446,112 @@ class KernelDensity {
 
 
     // dual tree
+
+    // the query side of a dual tree evaluation: the query tree, and the 
+    // upper/lower bounds of its nodes and points. 
+    //
+    // + TreeQueryState: the bounds are the attributes of the query tree. 
+    // + SelfQueryState: the query tree is data_tree_, whose attributes must 
+    //   not change. the bounds live in arrays of their own instead, indexed 
+    //   as the node and point arrays of data_tree_. 
+    class TreeQueryState {
+      public:
+        TreeQueryState(KdtreeType &tree) : tree_(tree) {}
+        const KdtreeType& tree() const { return tree_; }
+        void reset(FloatType upper, FloatType lower);
+
+        FloatType node_upper(const TreeNodeType *q) const { return q->attr_.upper(); }
+        FloatType node_lower(const TreeNodeType *q) const { return q->attr_.lower(); }
+        void set_node_bounds(const TreeNodeType *q, FloatType upper, FloatType lower) {
+          TreeNodeType &node = tree_.nodes_[q - tree_.root_];
+          node.attr_.set_upper(upper); node.attr_.set_lower(lower);
+        }
+
+        FloatType upper(size_t i) const { return tree_.points_[i].attributes().upper(); }
+        FloatType lower(size_t i) const { return tree_.points_[i].attributes().lower(); }
+        void set_bounds(size_t i, FloatType upper, FloatType lower) {
+          tree_.points_[i].attributes().set_upper(upper);
+          tree_.points_[i].attributes().set_lower(lower);
+        }
+
+      private:
+        KdtreeType &tree_;
+    };
+
+    class SelfQueryState {
+      public:
+        SelfQueryState(const KdtreeType &tree) : tree_(tree) {}
+        const KdtreeType& tree() const { return tree_; }
+        void reset(FloatType upper, FloatType lower);
+
+        FloatType node_upper(const TreeNodeType *q) const { return node_upper_[q - tree_.root_]; }
+        FloatType node_lower(const TreeNodeType *q) const { return node_lower_[q - tree_.root_]; }
+        void set_node_bounds(const TreeNodeType *q, FloatType upper, FloatType lower) {
+          node_upper_[q - tree_.root_] = upper; node_lower_[q - tree_.root_] = lower;
+        }
+
+        FloatType upper(size_t i) const { return upper_[i]; }
+        FloatType lower(size_t i) const { return lower_[i]; }
+        void set_bounds(size_t i, FloatType upper, FloatType lower) {
+          upper_[i] = upper; lower_[i] = lower;
+        }
+
+      private:
+        const KdtreeType &tree_;
+        std::vector<FloatType> node_upper_, node_lower_;
+        std::vector<FloatType> upper_, lower_;
+    };
+
 #ifndef __CUDACC__ 
     template<typename KernT>
       void eval(KdtreeType&, const KernT&, FloatType, FloatType) const;
 
     template<typename KernT>
-      void dual_tree(const TreeNodeType*, TreeNodeType*, const KernT&,
-          FloatType, FloatType, FloatType, FloatType, KdtreeType&) const;
+      void self_eval(std::vector<FloatType>&, const KernT&, FloatType, FloatType) const;
 
-    template<typename KernT>
-      void dual_tree_base(const TreeNodeType*, TreeNodeType*, const KernT&,
-          FloatType, FloatType, KdtreeType&) const;
+    template<typename KernT, typename QueryStateT>
+      void dual_tree_eval(QueryStateT&, const KernT&, FloatType, FloatType) const;
+
+    // (data leaf, query leaf) pairs whose base cases are deferred; see 
+    // set_defer_base_cases(). each forked task of the traversal records into 
+    // its own list, which is appended to its parent's after the join. 
+    using LeafPair = std::pair<const TreeNodeType*, const TreeNodeType*>;
+    using LeafPairList = std::vector<LeafPair>;
+
+    template<typename KernT, typename QueryStateT>
+      void dual_tree(const TreeNodeType*, const TreeNodeType*, const KernT&,
+          FloatType, FloatType, FloatType, FloatType, QueryStateT&, 
+          ThreadPool*, LeafPairList*) const;
+
+    template<typename KernT, typename QueryStateT>
+      void dual_tree_base(const TreeNodeType*, const TreeNodeType*, const KernT&,
+          FloatType, FloatType, QueryStateT&) const;
+
+    template<typename KernT, typename QueryStateT>
+      void run_leaf_pairs(LeafPairList&, const KernT&, QueryStateT&, ThreadPool*) const;
+
+    template<typename QueryStateT>
+      void refresh_node_bounds(const TreeNodeType*, QueryStateT&) const;
 #else
 
     template<typename KernT>
       void eval(KdtreeType&, const KernT&, FloatType, FloatType, size_t) const;
 
     template<typename KernT>
-      void dual_tree(const TreeNodeType*, TreeNodeType*, const KernT&,
-          FloatType, FloatType, FloatType, FloatType, KdtreeType&, 
+      void self_eval(std::vector<FloatType>&, const KernT&, FloatType, FloatType, size_t) const;
+
+    template<typename KernT, typename QueryStateT>
+      void dual_tree_eval(QueryStateT&, const KernT&, FloatType, FloatType, size_t) const;
+
+    template<typename KernT, typename QueryStateT>
+      void dual_tree(const TreeNodeType*, const TreeNodeType*, const KernT&,
+          FloatType, FloatType, FloatType, FloatType, QueryStateT&, 
           CudaDirectKde<D,KernelFloatType,KernT>&, 
           std::vector<KernelFloatType>&,size_t) const;
 
-    template<typename KernT>
-      void dual_tree_base(const TreeNodeType*, TreeNodeType*, const KernT&,
-          FloatType, FloatType, KdtreeType&, 
+    template<typename KernT, typename QueryStateT>
+      void dual_tree_base(const TreeNodeType*, const TreeNodeType*, const KernT&,
+          FloatType, FloatType, QueryStateT&, 
           CudaDirectKde<D,KernelFloatType,KernT>&, 
           std::vector<KernelFloatType>&,size_t) const;
 #endif
@@ -285,25 +559,54 @@ class KernelDensity {
     // general
     bool can_approximate(const TreeNodeType*,
         FloatType,FloatType,FloatType,FloatType,
-        FloatType,FloatType,FloatType,FloatType) const;
-    bool can_approximate(const TreeNodeType*, const TreeNodeType*,
-        FloatType,FloatType, FloatType, FloatType, 
-        FloatType, FloatType) const;
+        FloatType,FloatType,FloatType,FloatType, bool) const;
 
     void tighten_bounds(const TreeNodeType*, FloatType, FloatType,
         FloatType,FloatType, FloatType&,FloatType&) const;
-    void tighten_bounds(const TreeNodeType*, TreeNodeType*, 
+    template<typename QueryStateT>
+    void tighten_bounds(const TreeNodeType*, const TreeNodeType*, QueryStateT&,
         FloatType, FloatType, FloatType, FloatType) const;
 
     template<typename ObjT>
     void apply_closer_heuristic(
-        TreeNodeType**, TreeNodeType**, const ObjT &) const;
+        const TreeNodeType**, const TreeNodeType**, const ObjT &) const;
 
     template<typename ObjT, typename KernT> 
     void estimate_contributions(
         const TreeNodeType*, const ObjT&, const KernT&,
         FloatType&, FloatType&) const;
 
+    template<typename ObjT, typename KernT> 
+    void estimate_mean_contributions(
+        const TreeNodeType*, const ObjT&, const KernT&,
+        FloatType&, FloatType&) const;
+
+    template<typename ObjT, typename KernT> 
+    void estimate_node_contributions(
+        const TreeNodeType*, const ObjT&, const KernT&,
+        FloatType&, FloatType&) const;
+
+    template<typename BoundT> 
+    static void centroid_distances(
+        const BoundT&, const GeomPointType&, FloatType&, FloatType&);
+    static void centroid_distances(
+        const GeomPointType&, const GeomPointType&, FloatType&, FloatType&);
+
+    template<typename ObjT, typename KernT> 
+    static void distance_proxies(
+        const Rectangle<D,FloatT>&, const ObjT&, const KernT&, 
+        GeomPointType&, GeomPointType&);
+
+    template<typename ObjT, typename KernT> 
+    static void distance_proxies(
+        const CompactRectangle<D,FloatT>&, const ObjT&, const KernT&, 
+        GeomPointType&, GeomPointType&);
+
+    template<typename ObjT, typename KernT> 
+    static void distance_proxies(
+        const Ball<D,FloatT>&, const ObjT&, const KernT&, 
+        GeomPointType&, GeomPointType&);
+
     void report_error(std::ostream&, const GeomPointType&,
         FloatType, FloatType, FloatType, FloatType) const;
 
@@ -4,22 +4,24 @@
 #include <iomanip>
 #include <random>
 #include <stdexcept>
+#include <chrono>
 
 #include <Kernels/ConvKernelAssociator.h>
 #include <Kernels/KernelTraits.h>
 #include <KdeTraits.h>
+#include <KernelBlockSum.h>
 
 namespace bbrcit {
 
-template<typename KT, typename FT, typename AT>
+template<typename KT, typename FT, typename AT, typename TT>
 FT lsq_numint_cross_validate( 
 #ifndef __CUDACC__
-  const KernelDensity<2,KT,FT,AT> &kde, 
+  const KernelDensity<2,KT,FT,AT,TT> &kde, 
   FT start_x, FT end_x, int steps_x, 
   FT start_y, FT end_y, int steps_y,
   FT rel_err, FT abs_err, int qtree_leaf_nmax
 #else 
-  const KernelDensity<2,KT,FT,AT> &kde, 
+  const KernelDensity<2,KT,FT,AT,TT> &kde, 
   FT start_x, FT end_x, int steps_x, 
   FT start_y, FT end_y, int steps_y,
   FT rel_err, FT abs_err, int qtree_leaf_nmax,
@@ -27,36 +29,35 @@ FT lsq_numint_cross_validate(
 #endif
   ) {
 
-  using KernelDensityType = KernelDensity<2,KT,FT,AT>;
+  using KernelDensityType = KernelDensity<2,KT,FT,AT,TT>;
   using KdtreeType = typename KernelDensityType::KdtreeType;
   using DataPointType = typename KernelDensityType::DataPointType;
 
   // compute leave one out contribution
   // ----------------------------------
 
-  // construct a reference query tree out of the data tree to perform 
-  // dual tree self-evaluation. we use copy-assignment since we would like
-  // to preserve the same ordering of points in both trees. 
-  KdtreeType rtree = kde.data_tree();
-
-  // all pairs self-evaluation
+  // all pairs self-evaluation. the values are in the order of the points 
+  // in the data tree. 
+  std::vector<FT> self_values;
 #ifndef __CUDACC__
-  kde.eval(rtree, rel_err, abs_err);
+  kde.self_eval(self_values, rel_err, abs_err);
 #else
-  kde.eval(rtree, rel_err, abs_err, block_size);
+  kde.self_eval(self_values, rel_err, abs_err, block_size);
 #endif
 
-  // compute leave one out score
+  // compute leave one out score. weights and masses are relative to 
+  // their total. 
+  FT weight_scale = 1 / kde.weight_total();
   FT llo_cv = ConstantTraits<FT>::zero(), val = ConstantTraits<FT>::zero();
-  for (size_t i = 0; i < rtree.points().size(); ++i) {
+  for (size_t i = 0; i < self_values.size(); ++i) {
 
     // the dual tree gives contributions from all points; must 
     // subtract away the self contribution
-    val = rtree.points()[i].attributes().value();
-    val -= kde.points()[i].attributes().mass() * kde.kernel().normalization();
+    val = self_values[i];
+    val -= kde.points()[i].attributes().mass() * weight_scale * kde.kernel().normalization();
 
     // contribution is weighted
-    llo_cv += kde.points()[i].attributes().weight() * val;
+    llo_cv += kde.points()[i].attributes().weight() * weight_scale * val;
   }
 
 
@@ -72,7 +73,10 @@ FT lsq_numint_cross_validate(
       q_grid.push_back({{start_x+i*delta_x, start_y+j*delta_y}});
     }
   }
-  KdtreeType qtree(std::move(q_grid), qtree_leaf_nmax);
+  KdtreeOptions qtree_options;
+  qtree_options.leaf_nmax = qtree_leaf_nmax;
+  qtree_options.dedup = KdtreeDedup::None;
+  KdtreeType qtree(std::move(q_grid), qtree_options);
 
   // evaluate the kernel density at every grid points
 #ifndef __CUDACC__
@@ -96,10 +100,10 @@ FT lsq_numint_cross_validate(
 
 }
 
-template<int D, typename KT, typename FT, typename AT>
+template<int D, typename KT, typename FT, typename AT, typename TT>
   template <typename RNG> 
-typename KernelDensity<D,KT,FT,AT>::DataPointType 
-KernelDensity<D,KT,FT,AT>::simulate(RNG &e) const {
+typename KernelDensity<D,KT,FT,AT,TT>::DataPointType 
+KernelDensity<D,KT,FT,AT,TT>::simulate(RNG &e) const {
   static std::vector<FloatType> p(D, 0.0);
   DataPointType q; 
   simulate(e, p);
@@ -108,20 +112,21 @@ KernelDensity<D,KT,FT,AT>::simulate(RNG &e) const {
 }
 
 
-template<int D, typename KT, typename FT, typename AT>
+template<int D, typename KT, typename FT, typename AT, typename TT>
   template <typename RNG> 
-void KernelDensity<D,KT,FT,AT>::simulate(RNG &e, std::vector<FloatType> &p) const {
+void KernelDensity<D,KT,FT,AT,TT>::simulate(RNG &e, std::vector<FloatType> &p) const {
   
   // Step 1: choose a random point from the reference tree, but weighted by `weight`
-  // i.e. choose point `i` if `i` is the smallest index such that `cum_sum[i]` 
-  // is strictly larger than `d(e)`, a random number sampled from uniform(0,1). 
+  // i.e. choose point `i` if `i` is the smallest index such that the sum of 
+  // weights up to and including point `i` is strictly larger than `d(e)` times 
+  // the weight total, with `d(e)` a random number sampled from uniform(0,1). 
 
   static std::uniform_real_distribution<FloatType> d(0, 1);
 
-  auto it = std::upper_bound(cum_weights_.begin(), cum_weights_.end(), d(e));
-  assert(it != cum_weights_.end());
+  size_t i = find_cum_weight(d(e) * weight_total());
+  assert(i < data_tree_.size());
 
-  const DataPointType &ref_pt = data_tree_.points()[it - cum_weights_.begin()];
+  const DataPointType &ref_pt = data_tree_.points()[i];
 
   // Step 2: choose a random point from the kernel, but accounting for the local
   // adaptive bandwidth correction. 
@@ -139,9 +144,9 @@ void KernelDensity<D,KT,FT,AT>::simulate(RNG &e, std::vector<FloatType> &p) cons
 
 // perform least squares cross validation on the current kernel
 // configuration. 
-template<int D, typename KT, typename FT, typename AT>
-typename KernelDensity<D,KT,FT,AT>::FloatType
-KernelDensity<D,KT,FT,AT>::lsq_convolution_cross_validate( 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+typename KernelDensity<D,KT,FT,AT,TT>::FloatType
+KernelDensity<D,KT,FT,AT,TT>::lsq_convolution_cross_validate( 
 #ifndef __CUDACC__ 
     FloatType rel_err, FloatType abs_err
 #else
@@ -150,34 +155,31 @@ KernelDensity<D,KT,FT,AT>::lsq_convolution_cross_validate(
     ) const {
 
 
-  // construct a query tree out of the data tree to perform 
-  // dual tree self-evaluation. we use copy-assignment since we would like
-  // to preserve the same ordering of points in both trees. 
-  KdtreeType query_tree = data_tree_;
-
   // compute the leave one out contribution
   // --------------------------------------
 
-  // all pairs computation using the default kernel
+  // all pairs self-evaluation using the default kernel. the values are in 
+  // the order of the points in the data tree. 
+  std::vector<FloatType> self_values;
 #ifndef __CUDACC__
-  eval(query_tree, kernel_, rel_err, abs_err);
+  self_eval(self_values, kernel_, rel_err, abs_err);
 #else
-  eval(query_tree, kernel_, rel_err, abs_err, block_size);
+  self_eval(self_values, kernel_, rel_err, abs_err, block_size);
 #endif
 
   FloatType val = 0.0;
 
   // compute leave one out score
   FloatType llo_cv = ConstantTraits<FloatType>::zero();
-  for (size_t i = 0; i < query_tree.points_.size(); ++i) {
+  for (size_t i = 0; i < self_values.size(); ++i) {
 
     // the dual tree gives contributions from all points; must 
     // subtract away the self contribution
-    val = query_tree.points_[i].attributes().value();
-    val -= data_tree_.points_[i].attributes().mass() * kernel_.normalization();
+    val = self_values[i];
+    val -= data_tree_.points_[i].attributes().mass() * weight_scale() * kernel_.normalization();
 
     // contribution is weighted
-    llo_cv += data_tree_.points_[i].attributes().weight() * val;
+    llo_cv += data_tree_.points_[i].attributes().weight() * weight_scale() * val;
   }
 
   // compute the square integral contribution
@@ -187,21 +189,21 @@ KernelDensity<D,KT,FT,AT>::lsq_convolution_cross_validate(
   typename ConvKernelAssociator<KernelType>::ConvKernelType conv_kernel = 
     ConvKernelAssociator<KernelType>::make_convolution_kernel(kernel_);
 
-  // all pairs computation using the convolution kernel
+  // all pairs self-evaluation using the convolution kernel
 #ifndef __CUDACC__
-  eval(query_tree, conv_kernel, rel_err, abs_err);
+  self_eval(self_values, conv_kernel, rel_err, abs_err);
 #else
-  eval(query_tree, conv_kernel, rel_err, abs_err, block_size);
+  self_eval(self_values, conv_kernel, rel_err, abs_err, block_size);
 #endif
 
   // compute square integral score
   FloatType sq_cv = ConstantTraits<FloatType>::zero();
-  for (size_t i = 0; i < query_tree.points_.size(); ++i) {
+  for (size_t i = 0; i < self_values.size(); ++i) {
 
-    val = query_tree.points_[i].attributes().value();
+    val = self_values[i];
 
     // contribution is weighted
-    sq_cv += data_tree_.points_[i].attributes().weight() * val;
+    sq_cv += data_tree_.points_[i].attributes().weight() * weight_scale() * val;
   }
 
   return sq_cv - 2*llo_cv;
@@ -212,9 +214,9 @@ KernelDensity<D,KT,FT,AT>::lsq_convolution_cross_validate(
 
 // perform likelihood cross validation on the current kernel
 // configuration. 
-template<int D, typename KT, typename FT, typename AT>
-typename KernelDensity<D,KT,FT,AT>::FloatType
-KernelDensity<D,KT,FT,AT>::likelihood_cross_validate( 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+typename KernelDensity<D,KT,FT,AT,TT>::FloatType
+KernelDensity<D,KT,FT,AT,TT>::likelihood_cross_validate( 
 #ifndef __CUDACC__ 
     FloatType rel_err, FloatType abs_err
 #else
@@ -222,37 +224,35 @@ KernelDensity<D,KT,FT,AT>::likelihood_cross_validate(
 #endif
     ) const {
 
-  // construct a query tree out of the data tree to perform 
-  // dual tree self-evaluation. we use copy-assignment since we would like
-  // to preserve the same ordering of points in both trees. 
-  KdtreeType query_tree = data_tree_;
-
+  // all pairs self-evaluation. the values are in the order of the points 
+  // in the data tree. 
+  std::vector<FloatType> self_values;
 #ifndef __CUDACC__
-  eval(query_tree, kernel_, rel_err, abs_err);
+  self_eval(self_values, kernel_, rel_err, abs_err);
 #else
-  eval(query_tree, kernel_, rel_err, abs_err, block_size);
+  self_eval(self_values, kernel_, rel_err, abs_err, block_size);
 #endif
 
   // compute the cross validation score
   FloatType cv = ConstantTraits<FloatType>::zero();
 
   FloatType cv_i;
-  for (size_t i = 0; i < query_tree.points_.size(); ++i) {
+  for (size_t i = 0; i < self_values.size(); ++i) {
 
     // the dual tree gives contributions from all points; must 
     // subtract away the self contribution
-    cv_i = query_tree.points_[i].attributes().value();
-    cv_i -= data_tree_.points_[i].attributes().mass() * kernel_.normalization();
+    cv_i = self_values[i];
+    cv_i -= data_tree_.points_[i].attributes().mass() * weight_scale() * kernel_.normalization();
 
     // the cross validation score is the log of the leave one out contribution
-    cv += data_tree_.points_[i].attributes().weight() * std::log(cv_i);
+    cv += data_tree_.points_[i].attributes().weight() * weight_scale() * std::log(cv_i);
   }
 
   return cv;
 }
 
-template<int D, typename KT, typename FT, typename AT>
-void KernelDensity<D,KT,FT,AT>::unadapt_density() {
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::unadapt_density() {
 
   // reset reference data point attributes
   for (size_t i = 0; i < data_tree_.points_.size(); ++i) {
@@ -270,6 +270,7 @@ void KernelDensity<D,KT,FT,AT>::unadapt_density() {
 
   // update node attributes
   data_tree_.refresh_node_attributes(data_tree_.root_);
+  initialize_point_arrays();
 }
 
 
@@ -288,8 +289,8 @@ void KernelDensity<D,KT,FT,AT>::unadapt_density() {
 //
 // This prescription is described in page 101 of Silverman's book
 // `Density Estimation for Statistics and Data Analysis`. 
-template<int D, typename KT, typename FT, typename AT>
-void KernelDensity<D,KT,FT,AT>::adapt_density(
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::adapt_density(
 #ifndef __CUDACC__
     FloatType alpha, FloatType rel_err, FloatType abs_err
 #else
@@ -313,27 +314,23 @@ void KernelDensity<D,KT,FT,AT>::adapt_density(
   // compute pilot estimate
   // ----------------------
 
-  // construct a query tree out of the data tree to perform 
-  // dual tree self-evaluation. we use copy-assignment since we would like
-  // to preserve the same ordering of points in both trees. 
-  KdtreeType query_tree = data_tree_;
-
+  // all pairs self-evaluation. the pilot estimates are in the order of 
+  // the points in the data tree. 
+  std::vector<FloatType> local_bw;
 #ifndef __CUDACC__
-  eval(query_tree, kernel_, rel_err, abs_err);
+  self_eval(local_bw, kernel_, rel_err, abs_err);
 #else
-  eval(query_tree, kernel_, rel_err, abs_err, block_size);
+  self_eval(local_bw, kernel_, rel_err, abs_err, block_size);
 #endif
 
   // compute local bandwidth corrections
   // -----------------------------------
 
   FloatType g = 0;
-  std::vector<FloatType> local_bw(query_tree.points_.size());
-  for (size_t i = 0; i < query_tree.points_.size(); ++i) {
-    local_bw[i] = query_tree.points_[i].attributes().value();
+  for (size_t i = 0; i < local_bw.size(); ++i) {
     g += data_tree_.points_[i].attributes().weight() * std::log(local_bw[i]);
   }
-  g = std::exp(g);
+  g = std::exp(g * weight_scale());
 
   for (auto &bw : local_bw) {
     bw = std::pow(bw/g, -alpha);
@@ -354,39 +351,101 @@ void KernelDensity<D,KT,FT,AT>::adapt_density(
 
   // update node attributes
   data_tree_.refresh_node_attributes(data_tree_.root_);
+  initialize_point_arrays();
 
   return;
 }
 
-template<int D, typename KT, typename FT, typename AT>
-inline size_t KernelDensity<D,KT,FT,AT>::size() const { return data_tree_.size(); }
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::update_points(
+    const std::vector<size_t> &indices, 
+    const std::vector<FloatType> &weights, 
+    const std::vector<FloatType> &abws) {
+
+  if (indices.size() != weights.size() || indices.size() != abws.size()) {
+    throw std::invalid_argument("KernelDensity<>: update_points(): "
+                                "indices, weights, and abws must have equal lengths. ");
+  }
+
+  // update the points and their cumulative weights. 
+  for (size_t k = 0; k < indices.size(); ++k) {
+
+    if (indices[k] >= data_tree_.points_.size()) {
+      throw std::out_of_range("KernelDensity<>: update_points(): "
+                              "point index out of range. ");
+    }
+
+    auto &attr = data_tree_.points_[indices[k]].attributes();
+    update_cum_weights(indices[k], weights[k] - attr.weight());
+    attr.set_weight(weights[k]);
+    attr.set_lower_abw(abws[k]);
+    attr.set_upper_abw(abws[k]);
+    attr.set_mass(weights[k] * pow(abws[k], -D));
+
+    point_masses_[indices[k]] = attr.mass();
+    point_abws_[indices[k]] = attr.abw();
+  }
+
+  // refresh the affected paths only. the weight total follows at the root. 
+  data_tree_.refresh_node_attributes(
+      std::vector<typename KdtreeType::IndexType>(indices.begin(), indices.end()));
+
+  if (!node_moments_.empty()) { 
+    std::vector<size_t> sorted(indices);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    refresh_node_moments(data_tree_.root_, sorted.data(), sorted.data() + sorted.size()); 
+  }
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline size_t KernelDensity<D,KT,FT,AT,TT>::size() const { return data_tree_.size(); }
 
-template<int D, typename KT, typename FT, typename AT>
-inline const std::vector<typename KernelDensity<D,KT,FT,AT>::DataPointType>& 
-KernelDensity<D,KT,FT,AT>::points() const {
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline const std::vector<typename KernelDensity<D,KT,FT,AT,TT>::DataPointType>& 
+KernelDensity<D,KT,FT,AT,TT>::points() const {
   return data_tree_.points();
 }
 
-template<int D, typename KT, typename FT, typename AT>
-inline const typename KernelDensity<D,KT,FT,AT>::KdtreeType&
-KernelDensity<D,KT,FT,AT>::data_tree() const {
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline const typename KernelDensity<D,KT,FT,AT,TT>::KdtreeType&
+KernelDensity<D,KT,FT,AT,TT>::data_tree() const {
   return data_tree_;
 }
 
-template<int D, typename KT, typename FT, typename AT>
-void swap(KernelDensity<D,KT,FT,AT> &lhs, KernelDensity<D,KT,FT,AT> &rhs) {
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline typename KernelDensity<D,KT,FT,AT,TT>::FloatType
+KernelDensity<D,KT,FT,AT,TT>::weight_total() const {
+  return data_tree_.root_ ? data_tree_.root_->attr_.weight() : ConstantTraits<FloatType>::zero();
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline typename KernelDensity<D,KT,FT,AT,TT>::FloatType
+KernelDensity<D,KT,FT,AT,TT>::weight_scale() const {
+  return data_tree_.root_ ? 1 / data_tree_.root_->attr_.weight() : ConstantTraits<FloatType>::one();
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void swap(KernelDensity<D,KT,FT,AT,TT> &lhs, KernelDensity<D,KT,FT,AT,TT> &rhs) {
   using std::swap;
   swap(lhs.kernel_, rhs.kernel_);
   swap(lhs.data_tree_, rhs.data_tree_);
+  swap(lhs.cum_weights_, rhs.cum_weights_);
+  for (int d = 0; d < D; ++d) { swap(lhs.point_coords_[d], rhs.point_coords_[d]); }
+  swap(lhs.point_masses_, rhs.point_masses_);
+  swap(lhs.point_abws_, rhs.point_abws_);
+  swap(lhs.node_moments_, rhs.node_moments_);
+  swap(lhs.pool_, rhs.pool_);
+  swap(lhs.defer_base_cases_, rhs.defer_base_cases_);
   return;
 }
 
-template<int D, typename KT, typename FT, typename AT>
-KernelDensity<D,KT,FT,AT>::KernelDensity() : 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+KernelDensity<D,KT,FT,AT,TT>::KernelDensity() : 
   kernel_(), data_tree_(), cum_weights_() {}
 
-template<int D, typename KT, typename FT, typename AT>
-KernelDensity<D,KT,FT,AT>::KernelDensity(
+template<int D, typename KT, typename FT, typename AT, typename TT>
+KernelDensity<D,KT,FT,AT,TT>::KernelDensity(
     const std::vector<DataPointType> &pts, int leaf_max) 
   : kernel_() {
 
@@ -394,41 +453,82 @@ KernelDensity<D,KT,FT,AT>::KernelDensity(
   initialize_attributes(ref_pts);
   data_tree_ = KdtreeType(std::move(ref_pts), leaf_max);
   initialize_cum_weights();
+  initialize_point_arrays();
+  initialize_pool();
 
 }
 
-template<int D, typename KT, typename FT, typename AT>
-KernelDensity<D,KT,FT,AT>::KernelDensity(
+template<int D, typename KT, typename FT, typename AT, typename TT>
+KernelDensity<D,KT,FT,AT,TT>::KernelDensity(
     std::vector<DataPointType> &&pts, int leaf_max) 
   : kernel_() {
 
   initialize_attributes(pts);
   data_tree_ = KdtreeType(std::move(pts), leaf_max);
   initialize_cum_weights();
+  initialize_point_arrays();
+  initialize_pool();
+
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+KernelDensity<D,KT,FT,AT,TT>::KernelDensity(
+    const std::vector<DataPointType> &pts, const KdtreeOptions &options) 
+  : kernel_() {
+
+  std::vector<DataPointType> ref_pts = pts;
+  initialize_attributes(ref_pts);
+  data_tree_ = KdtreeType(std::move(ref_pts), options);
+  initialize_cum_weights();
+  initialize_point_arrays();
+  initialize_pool();
 
 }
 
-template<int D, typename KT, typename FT, typename AT>
-inline const typename KernelDensity<D,KT,FT,AT>::KernelType& 
-KernelDensity<D,KT,FT,AT>::kernel() const {
+template<int D, typename KT, typename FT, typename AT, typename TT>
+KernelDensity<D,KT,FT,AT,TT>::KernelDensity(
+    std::vector<DataPointType> &&pts, const KdtreeOptions &options) 
+  : kernel_() {
+
+  initialize_attributes(pts);
+  data_tree_ = KdtreeType(std::move(pts), options);
+  initialize_cum_weights();
+  initialize_point_arrays();
+  initialize_pool();
+
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline const typename KernelDensity<D,KT,FT,AT,TT>::KernelType& 
+KernelDensity<D,KT,FT,AT,TT>::kernel() const {
   return kernel_;
 }
 
-template<int D, typename KT, typename FT, typename AT>
-inline typename KernelDensity<D,KT,FT,AT>::KernelType& 
-KernelDensity<D,KT,FT,AT>::kernel() {
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline typename KernelDensity<D,KT,FT,AT,TT>::KernelType& 
+KernelDensity<D,KT,FT,AT,TT>::kernel() {
   return const_cast<KernelType&>(
-           static_cast<const KernelDensity<D,KT,FT,AT>&>(*this).kernel()
+           static_cast<const KernelDensity<D,KT,FT,AT,TT>&>(*this).kernel()
       );
 }
 
-template<int D, typename KT, typename FT, typename AT>
-inline void KernelDensity<D,KT,FT,AT>::set_kernel(const KernelType &k) {
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline void KernelDensity<D,KT,FT,AT,TT>::set_kernel(const KernelType &k) {
   kernel_ = k;
 }
 
-template<int D, typename KT, typename FT, typename AT>
-void KernelDensity<D,KT,FT,AT>::initialize_attributes(
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline bool KernelDensity<D,KT,FT,AT,TT>::defer_base_cases() const {
+  return defer_base_cases_;
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline void KernelDensity<D,KT,FT,AT,TT>::set_defer_base_cases(bool defer) {
+  defer_base_cases_ = defer;
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::initialize_attributes(
     std::vector<DataPointType> &pts) {
 
   // normalize point weights
@@ -441,8 +541,8 @@ void KernelDensity<D,KT,FT,AT>::initialize_attributes(
   }
 }
 
-template<int D, typename KT, typename FT, typename AT>
-void KernelDensity<D,KT,FT,AT>::normalize_weights(std::vector<DataPointType> &pts) {
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::normalize_weights(std::vector<DataPointType> &pts) {
 
   FloatType weight_total = ConstantTraits<FloatType>::zero();
   for (const auto &p : pts) { weight_total += p.attributes().weight(); }
@@ -454,37 +554,166 @@ void KernelDensity<D,KT,FT,AT>::normalize_weights(std::vector<DataPointType> &pt
 
 }
 
-// note: points weights in the data tree should have already been 
-// normalized; i.e. sum over all weights is 1.0
-template<int D, typename KT, typename FT, typename AT>
-void KernelDensity<D,KT,FT,AT>::initialize_cum_weights() {
+// builds the Fenwick tree in linear time: each element passes its 
+// partial sum on to the next element whose range covers its own. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::initialize_cum_weights() {
+
+  size_t n = data_tree_.size();
+  cum_weights_.resize(n);
+  for (size_t i = 0; i < n; ++i) { cum_weights_[i] = data_tree_.points_[i].attributes().weight(); }
+  for (size_t i = 1; i <= n; ++i) {
+    size_t parent = i + (i & (~i + 1));
+    if (parent <= n) { cum_weights_[parent-1] += cum_weights_[i-1]; }
+  }
+}
+
+// copy the coordinates, masses, and local bandwidth corrections of
+// data_tree_.points_ into the structure-of-arrays mirror. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::initialize_point_arrays() {
+
+  size_t n = data_tree_.points_.size();
+  for (int d = 0; d < D; ++d) { point_coords_[d].resize(n); }
+  point_masses_.resize(n); point_abws_.resize(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    const auto &p = data_tree_.points_[i];
+    for (int d = 0; d < D; ++d) { point_coords_[d][i] = p[d]; }
+    point_masses_[i] = p.attributes().mass();
+    point_abws_[i] = p.attributes().abw();
+  }
+
+  // the node moments are derived from the mirror. they only serve kernels 
+  // with MomentBoundTraits<>. 
+  if (MomentBoundTraits<KernelType>::value) {
+    node_moments_.assign(data_tree_.nodes_.size(), NodeMoments());
+    refresh_node_moments(data_tree_.root_);
+  } else {
+    node_moments_.clear();
+  }
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::initialize_pool() {
+  pool_.reset();
+  if (data_tree_.options().n_threads != 1) {
+    pool_ = std::make_shared<ThreadPool>(data_tree_.options().n_threads);
+    if (pool_->size() == 1) { pool_.reset(); }
+  }
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::refresh_node_moments(const TreeNodeType *p) {
+  if (p == nullptr) { return; }
+  if (!p->is_leaf()) {
+    refresh_node_moments(p->left());
+    refresh_node_moments(p->right());
+  }
+  compute_node_moments(p);
+}
+
+// refresh the moments of the nodes on the paths to the points at the 
+// sorted indices [first, last), as Kdtree<>::refresh_node_attributes(). 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::refresh_node_moments(
+    const TreeNodeType *p, const size_t *first, const size_t *last) {
+  if (first == last) { return; }
+  if (!p->is_leaf()) {
+    const size_t *mid = std::upper_bound(first, last, p->left()->end_idx_);
+    refresh_node_moments(p->left(), first, mid);
+    refresh_node_moments(p->right(), mid, last);
+  }
+  compute_node_moments(p);
+}
+
+// leaves sum over their points. internal nodes combine the moments of 
+// their daughters, which must be up to date, by the parallel axis theorem. 
+// massless nodes contribute nothing; their points are weighted equally. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::compute_node_moments(const TreeNodeType *p) {
+
+  NodeMoments &m = node_moments_[p - data_tree_.root_];
+  m = NodeMoments();
+
+  auto sq_dist = [] (const GeomPointType &a, const GeomPointType &b) {
+    FloatType total = ConstantTraits<FloatType>::zero();
+    for (int d = 0; d < D; ++d) { total += (a[d] - b[d]) * (a[d] - b[d]); }
+    return total;
+  };
 
-  // start with a clean slate 
-  cum_weights_.clear(); cum_weights_.reserve(data_tree_.size());
+  if (p->is_leaf()) {
 
-  // cum_weights_[i] contains the sum of weights up to and including 
-  // the weight at point i. 
-  FloatType cum_sum = 0.0;
-  for (const auto &p : data_tree_.points()) {
-    cum_sum += p.attributes().weight();
-    cum_weights_.push_back(cum_sum);
+    FloatType mass_total = ConstantTraits<FloatType>::zero();
+    for (auto i = p->start_idx_; i <= p->end_idx_; ++i) { mass_total += point_masses_[i]; }
+    auto weight = [&] (size_t i) {
+      return mass_total > 0 ? point_masses_[i] / mass_total : FloatType(1) / p->size();
+    };
+
+    for (auto i = p->start_idx_; i <= p->end_idx_; ++i) {
+      for (int d = 0; d < D; ++d) { m.centroid_[d] += weight(i) * point_coords_[d][i]; }
+    }
+    for (auto i = p->start_idx_; i <= p->end_idx_; ++i) {
+      m.spread_ += weight(i) * sq_dist(mirrored_point(i), m.centroid_);
+    }
+
+  } else {
+
+    const NodeMoments &l = node_moments_[p->left() - data_tree_.root_];
+    const NodeMoments &r = node_moments_[p->right() - data_tree_.root_];
+    FloatType l_mass = p->left()->attr_.mass(), r_mass = p->right()->attr_.mass();
+    FloatType wl = 0.5, wr = 0.5;
+    if (l_mass + r_mass > 0) { wl = l_mass / (l_mass + r_mass); wr = 1 - wl; }
+
+    for (int d = 0; d < D; ++d) { m.centroid_[d] = wl * l.centroid_[d] + wr * r.centroid_[d]; }
+    m.spread_ = wl * (l.spread_ + sq_dist(l.centroid_, m.centroid_)) + 
+                wr * (r.spread_ + sq_dist(r.centroid_, m.centroid_));
   }
+}
 
-  // assign roundoff errors to the last element... for lack 
-  // of a better idea
-  if (data_tree_.size()) { cum_weights_[data_tree_.size()-1] = 1.0; }
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline typename KernelDensity<D,KT,FT,AT,TT>::GeomPointType
+KernelDensity<D,KT,FT,AT,TT>::mirrored_point(size_t i) const {
+  GeomPointType q;
+  for (int d = 0; d < D; ++d) { q[d] = point_coords_[d][i]; }
+  return q;
+}
+
+// add `delta` to the weight of point i in cum_weights_. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::update_cum_weights(size_t i, FloatType delta) {
+  for (++i; i <= cum_weights_.size(); i += i & (~i + 1)) { cum_weights_[i-1] += delta; }
 }
 
-template<int D, typename KT, typename FT, typename AT>
-KernelDensity<D,KT,FT,AT>::~KernelDensity() {}
+// returns the smallest index i such that the sum of the weights of points 
+// 0 through i is strictly larger than `target`, or the last index if there 
+// is none, e.g. through roundoff. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+size_t KernelDensity<D,KT,FT,AT,TT>::find_cum_weight(FloatType target) const {
+
+  size_t n = cum_weights_.size(), step = 1;
+  while (2 * step <= n) { step *= 2; }
+
+  // i is the number of points whose cumulative weight is at most target. 
+  size_t i = 0;
+  for (; step; step /= 2) {
+    if (i + step <= n && cum_weights_[i+step-1] <= target) { 
+      i += step; target -= cum_weights_[i-1]; 
+    }
+  }
+  return std::min(i, n ? n-1 : 0);
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+KernelDensity<D,KT,FT,AT,TT>::~KernelDensity() {}
 
 
 
 // user wrapper for single tree kde evaluation. 
 // computes with the default kernel. 
-template<int D, typename KT, typename FT, typename AT>
-typename KernelDensity<D,KT,FT,AT>::FloatType
-KernelDensity<D,KT,FT,AT>::eval(DataPointType &p, 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+typename KernelDensity<D,KT,FT,AT,TT>::FloatType
+KernelDensity<D,KT,FT,AT,TT>::eval(DataPointType &p, 
     FloatType rel_err, FloatType abs_err) const {
 
   FloatType result = eval(p.point(), kernel_, rel_err, abs_err);
@@ -496,18 +725,74 @@ KernelDensity<D,KT,FT,AT>::eval(DataPointType &p,
 
 }
 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::eval_parallel(
+    std::vector<DataPointType> &queries, 
+    FloatType rel_err, FloatType abs_err, int n_threads) const {
+  ThreadPool pool(n_threads);
+  eval_parallel(queries, rel_err, abs_err, pool);
+}
+
+// single tree evaluations share nothing but the data tree, which is only 
+// read. their cost varies with the local density, so the queries are 
+// handed out in small grains that idle threads steal. 
+//
+// the bounds of each query are kept so that any loss of precision is 
+// reported afterwards, in query order, from the calling thread. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::eval_parallel(
+    std::vector<DataPointType> &queries, 
+    FloatType rel_err, FloatType abs_err, ThreadPool &pool) const {
+
+  std::vector<FloatType> upper(queries.size()), lower(queries.size());
+
+  const size_t grain = 64;
+  pool.parallel_for(0, queries.size(), grain, [&] (size_t b, size_t e) {
+    for (size_t i = b; i < e; ++i) { 
+      FloatType result = single_tree_eval(queries[i].point(), kernel_, 
+                                          rel_err, abs_err, upper[i], lower[i]);
+      queries[i].attributes().set_upper(result); 
+      queries[i].attributes().set_lower(result);
+    }
+  });
+
+  for (size_t i = 0; i < queries.size(); ++i) {
+    report_error(std::cerr, queries[i].point(), upper[i], lower[i], rel_err, abs_err);
+  }
+}
+
 // single point kde evaluation. based on the following algorithms:
 // + ''Multiresolution Instance-Based Learning'' by Deng and Moore
 // + ''Nonparametric Density Estimation: Toward Computational Tractability'' 
 //   by Gray and Moore
-template<int D, typename KT, typename FT, typename AT>
+template<int D, typename KT, typename FT, typename AT, typename TT>
   template<typename KernT>
-typename KernelDensity<D,KT,FT,AT>::FloatType
-KernelDensity<D,KT,FT,AT>::eval(
+typename KernelDensity<D,KT,FT,AT,TT>::FloatType
+KernelDensity<D,KT,FT,AT,TT>::eval(
     const GeomPointType &p, 
     const KernT &kernel,
     FloatType rel_err, FloatType abs_err) const {
 
+  FloatType upper, lower;
+  FloatType result = single_tree_eval(p, kernel, rel_err, abs_err, upper, lower);
+
+  // error reporting: notify the user of any loss of precision
+  report_error(std::cerr, p, upper, lower, rel_err, abs_err);
+
+  return result;
+}
+
+// eval() without the error reporting. `upper_out` and `lower_out` are set 
+// to the final bounds on the kde value. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename KernT>
+typename KernelDensity<D,KT,FT,AT,TT>::FloatType
+KernelDensity<D,KT,FT,AT,TT>::single_tree_eval(
+    const GeomPointType &p, 
+    const KernT &kernel,
+    FloatType rel_err, FloatType abs_err, 
+    FloatType &upper_out, FloatType &lower_out) const {
+
   // each reference point `d` contributes some proportion of its mass 
   // towards the kde at point `p`. 
   // Note: we factor out the overall normalization during the tree traversal 
@@ -524,28 +809,35 @@ KernelDensity<D,KT,FT,AT>::eval(
 
   // tighten the bounds by the single_tree algorithm. since we include the
   // overall normalization afterwards, we need to scale abs_err accordingly
-  FloatType normalization = kernel.normalization();
-  single_tree(data_tree_.root_, p, kernel,
-              upper, lower, du, dl, 
-              rel_err, abs_err / normalization);
+  FloatType normalization = kernel.normalization() * weight_scale();
+  if (MomentBoundTraits<KernT>::value) {
+
+    // moment_single_tree() expects the root's own bounds already credited. 
+    estimate_node_contributions(data_tree_.root_, p, kernel, du, dl);
+    tighten_bounds(data_tree_.root_, du, dl, 1.0, 0.0, upper, lower);
+    moment_single_tree(data_tree_.root_, p, kernel,
+                       upper, lower, du, dl, 
+                       rel_err, abs_err / normalization);
+
+  } else {
+    single_tree(data_tree_.root_, p, kernel,
+                upper, lower, du, dl, 
+                rel_err, abs_err / normalization);
+  }
 
   // take the mean of the bounds and remember to include the normalization
   FloatType result = normalization * (lower + (upper - lower) / 2);
-
-  // error reporting: notify the user of any loss of precision
-  report_error(std::cerr, p, 
-               normalization*upper, 
-               normalization*lower, 
-               rel_err, abs_err);
+  upper_out = normalization * upper; 
+  lower_out = normalization * lower;
 
   return result;
 
 }
 
 
-template<int D, typename KT, typename FT, typename AT>
+template<int D, typename KT, typename FT, typename AT, typename TT>
   template<typename KernT>
-void KernelDensity<D,KT,FT,AT>::single_tree(
+void KernelDensity<D,KT,FT,AT,TT>::single_tree(
     const TreeNodeType *D_node, const GeomPointType &p, const KernT &kernel,
     FloatType &upper, FloatType &lower, 
     FloatType du, FloatType dl, 
@@ -559,7 +851,7 @@ void KernelDensity<D,KT,FT,AT>::single_tree(
   // bound: approximate the total contribution due to `D_node` and 
   // decide whether to prune. 
   if (can_approximate(D_node, du_new, dl_new, du, dl, 
-                      upper, lower, rel_err, abs_err)) { 
+                      upper, lower, rel_err, abs_err, false)) { 
 
     // prune: still need to tighten the lower/upper bounds
     tighten_bounds(D_node, du_new, dl_new, du, dl, upper, lower);
@@ -579,7 +871,7 @@ void KernelDensity<D,KT,FT,AT>::single_tree(
     tighten_bounds(D_node, du_new, dl_new, du, dl, upper, lower);
 
     // decide which halfspace is closer to the query
-    TreeNodeType *closer = D_node->left_, *further = D_node->right_;
+    const TreeNodeType *closer = D_node->left(), *further = D_node->right();
     apply_closer_heuristic(&closer, &further, p);
     
     // recursively tighten the bounds, closer halfspace first 
@@ -589,27 +881,71 @@ void KernelDensity<D,KT,FT,AT>::single_tree(
   }
 }
 
+// single_tree() for kernels with MomentBoundTraits<>. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename KernT>
+void KernelDensity<D,KT,FT,AT,TT>::moment_single_tree(
+    const TreeNodeType *D_node, const GeomPointType &p, const KernT &kernel,
+    FloatType &upper, FloatType &lower, 
+    FloatType du, FloatType dl, 
+    FloatType rel_err, FloatType abs_err) const {
+
+  // bound: `du` and `dl` bound the contribution due to `D_node`, and are 
+  // already credited to the upper/lower bounds. decide whether to prune. 
+  if (can_approximate(D_node, du, dl, du, dl, 
+                      upper, lower, rel_err, abs_err, true)) { 
+    return; 
+  }
+
+  // branch: case 1: reached a leaf. brute force computation. 
+  if (D_node->is_leaf()) {
+
+    single_tree_base(D_node, p, kernel, du, dl, upper, lower);
+
+  // branch: case 2: non-leaf. recursively tighten the bounds. 
+  } else {
+
+    // decide which halfspace is closer to the query
+    const TreeNodeType *closer = D_node->left(), *further = D_node->right();
+    apply_closer_heuristic(&closer, &further, p);
+
+    // credit both daughters with their own bounds before descending into 
+    // either. each bound holds for its daughter as a whole; see 
+    // estimate_mean_contributions(). 
+    FloatType du_closer, dl_closer, du_further, dl_further;
+    estimate_node_contributions(closer, p, kernel, du_closer, dl_closer);
+    estimate_node_contributions(further, p, kernel, du_further, dl_further);
+    tighten_bounds(closer, du_closer, dl_closer, du, dl, upper, lower);
+    tighten_bounds(further, du_further, dl_further, du, dl, upper, lower);
+
+    // recursively tighten the bounds, closer halfspace first 
+    moment_single_tree(closer, p, kernel, upper, lower, du_closer, dl_closer, rel_err, abs_err);
+    moment_single_tree(further, p, kernel, upper, lower, du_further, dl_further, rel_err, abs_err);
+
+  }
+}
+
 // input invariants:
 // + lower <= upper, dl <= du
 //
 // output invariants:
 // + lower <= upper
-template<int D, typename KT, typename FT, typename AT>
+template<int D, typename KT, typename FT, typename AT, typename TT>
   template<typename KernT>
-void KernelDensity<D,KT,FT,AT>::single_tree_base(
+void KernelDensity<D,KT,FT,AT,TT>::single_tree_base(
     const TreeNodeType *D_node, const GeomPointType &p, const KernT &kernel,
     FloatType du, FloatType dl, 
     FloatType &upper, FloatType &lower) const {
 
-  FloatType delta;
-  for (auto i = D_node->start_idx_; i <= D_node->end_idx_; ++i) {
-
-    delta = kernel.unnormalized_eval(p, data_tree_.points_[i].point(), 
-                                        data_tree_.points_[i].attributes().abw());
+  // streams the node's points through the vectorized block sums; see
+  // KernelBlockSum.h. 
+  const FloatType *coords[D];
+  for (int d = 0; d < D; ++d) { coords[d] = point_coords_[d].data() + D_node->start_idx_; }
+  FloatType delta = kernel_block_sum(
+      kernel, p, coords, point_abws_.data() + D_node->start_idx_, 
+      point_masses_.data() + D_node->start_idx_, D_node->size());
+  upper += delta; lower += delta;
 
-    delta *= data_tree_.points_[i].attributes().mass();
-    upper += delta; lower += delta;
-  }
   upper -= D_node->attr_.mass() * du; 
   lower -= D_node->attr_.mass() * dl;
 
@@ -621,8 +957,8 @@ void KernelDensity<D,KT,FT,AT>::single_tree_base(
 
 // user wrapper for tree multi-point kernel density evaluation.
 // computes with the default kernel. 
-template<int D, typename KT, typename FT, typename AT>
-void KernelDensity<D,KT,FT,AT>::eval(
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::eval(
 
 #ifndef __CUDACC__
     std::vector<DataPointType> &queries, 
@@ -638,8 +974,13 @@ void KernelDensity<D,KT,FT,AT>::eval(
     ) const {
 
 
-  // construct a query tree
-  KdtreeType query_tree(std::move(queries), leaf_nmax);
+  // construct a query tree. it is built on the estimator's threads, and 
+  // its points follow the same curve as the reference tree. 
+  KdtreeOptions qtree_options;
+  qtree_options.leaf_nmax = leaf_nmax;
+  qtree_options.n_threads = data_tree_.options().n_threads;
+  qtree_options.curve = data_tree_.options().curve;
+  KdtreeType query_tree(std::move(queries), qtree_options, pool_.get());
 
 #ifndef __CUDACC__
   eval(query_tree, kernel_, rel_err, abs_err);
@@ -652,10 +993,45 @@ void KernelDensity<D,KT,FT,AT>::eval(
 
 }
 
+// as above, but the query tree is rebuilt within `context`. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::eval(
+
+#ifndef __CUDACC__
+    std::vector<DataPointType> &queries, 
+    FloatType rel_err, FloatType abs_err, 
+    EvalContext &context
+#else
+    std::vector<DataPointType> &queries, 
+    FloatType rel_err, FloatType abs_err, 
+    EvalContext &context, 
+    size_t block_size
+#endif
+    
+    ) const {
+
+  KdtreeOptions qtree_options;
+  qtree_options.leaf_nmax = context.leaf_nmax_;
+  qtree_options.n_threads = data_tree_.options().n_threads;
+  qtree_options.curve = data_tree_.options().curve;
+  context.query_tree_.rebuild(queries, qtree_options, pool_.get());
+
+#ifndef __CUDACC__
+  eval(context.query_tree_, kernel_, rel_err, abs_err);
+#else
+  eval(context.query_tree_, kernel_, rel_err, abs_err, block_size);
+#endif
+
+  // copy the results back; the context keeps its points. 
+  queries.assign(context.query_tree_.points_.begin(), 
+                 context.query_tree_.points_.end());
+
+}
+
 // user wrapper for tree multi-point kernel density evaluation.
 // computes with the default kernel. 
-template<int D, typename KT, typename FT, typename AT>
-inline void KernelDensity<D,KT,FT,AT>::eval(
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline void KernelDensity<D,KT,FT,AT,TT>::eval(
 
 #ifndef __CUDACC__
     KdtreeType &query_tree, 
@@ -678,9 +1054,9 @@ inline void KernelDensity<D,KT,FT,AT>::eval(
 
 
 // tree multi-point kde evaluation. computes with arbitrary kernels.
-template<int D, typename KT, typename FT, typename AT>
+template<int D, typename KT, typename FT, typename AT, typename TT>
   template<typename KernT>
-void KernelDensity<D,KT,FT,AT>::eval(
+inline void KernelDensity<D,KT,FT,AT,TT>::eval(
 
 #ifndef __CUDACC__
     KdtreeType &query_tree, const KernT &kernel,
@@ -693,23 +1069,181 @@ void KernelDensity<D,KT,FT,AT>::eval(
     
     ) const {
 
+  TreeQueryState query_state(query_tree);
+
+#ifndef __CUDACC__
+  dual_tree_eval(query_state, kernel, rel_err, abs_err);
+#else
+  dual_tree_eval(query_state, kernel, rel_err, abs_err, block_size);
+#endif
+
+}
+
+// user wrapper for all pairs self-evaluation. computes with the default kernel. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline void KernelDensity<D,KT,FT,AT,TT>::self_eval(
+
+#ifndef __CUDACC__
+    std::vector<FloatType> &values, 
+    FloatType rel_err, FloatType abs_err
+#else
+    std::vector<FloatType> &values, 
+    FloatType rel_err, FloatType abs_err, 
+    size_t block_size
+#endif
+    
+    ) const {
+
+#ifndef __CUDACC__
+  self_eval(values, kernel_, rel_err, abs_err);
+#else
+  self_eval(values, kernel_, rel_err, abs_err, block_size);
+#endif
+
+}
+
+// the candidates are timed in increasing order, and the scan stops once a 
+// candidate takes more than twice as long as the fastest one so far. the 
+// largest candidate leaves the sample at least 64 leaves. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+int KernelDensity<D,KT,FT,AT,TT>::calibrate_leaf_nmax(
+
+#ifndef __CUDACC__
+    FloatType rel_err, FloatType abs_err, size_t sample_size, 
+    int min_leaf_nmax, int max_leaf_nmax, std::ostream *os
+#else
+    FloatType rel_err, FloatType abs_err, size_t sample_size, 
+    int min_leaf_nmax, int max_leaf_nmax, std::ostream *os, 
+    size_t block_size
+#endif
+    
+    ) const {
+
+  if (min_leaf_nmax < 1 || max_leaf_nmax < min_leaf_nmax) {
+    throw std::invalid_argument("KernelDensity<>: calibrate_leaf_nmax(): "
+                                "requires 1 <= min_leaf_nmax <= max_leaf_nmax. ");
+  }
+  if (data_tree_.empty()) { return min_leaf_nmax; }
+
+  // the sample: the nearest neighbors of the middle point in leaf order. 
+  std::vector<typename KdtreeType::IndexType> indices; 
+  std::vector<FloatType> dists;
+  sample_size = std::max(size_t(1), std::min(sample_size, data_tree_.size()));
+  data_tree_.knn_search(data_tree_.points_[data_tree_.size()/2], sample_size, indices, dists);
+
+  std::vector<DataPointType> sample; sample.reserve(sample_size);
+  for (auto i : indices) { sample.push_back(data_tree_.points_[i]); }
+
+  KdtreeOptions options = data_tree_.options();
+  std::vector<FloatType> values;
+
+  long max_candidate = std::min(static_cast<long>(max_leaf_nmax), 
+                                std::max(static_cast<long>(min_leaf_nmax), 
+                                         static_cast<long>(sample_size / 64)));
+
+  int best_leaf_nmax = min_leaf_nmax;
+  double best_time = std::numeric_limits<double>::max();
+  for (long leaf_nmax = min_leaf_nmax; leaf_nmax <= max_candidate; leaf_nmax *= 2) {
+
+    options.leaf_nmax = leaf_nmax;
+    KernelDensityType sample_kde(sample, options);
+    sample_kde.kernel_ = kernel_;
+
+    // best of two runs. 
+    double elapsed = std::numeric_limits<double>::max();
+    for (int run = 0; run < 2; ++run) {
+      auto start = std::chrono::steady_clock::now();
+#ifndef __CUDACC__
+      sample_kde.self_eval(values, rel_err, abs_err);
+#else
+      sample_kde.self_eval(values, rel_err, abs_err, block_size);
+#endif
+      auto end = std::chrono::steady_clock::now();
+      elapsed = std::min(elapsed, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    if (os) { *os << "leaf_nmax " << leaf_nmax << ": " << elapsed << " ms. " << std::endl; }
+
+    if (elapsed < best_time) { best_time = elapsed; best_leaf_nmax = leaf_nmax; }
+    if (elapsed > 2 * best_time) { break; }
+  }
+
+  if (os) { *os << "calibrated leaf_nmax: " << best_leaf_nmax << std::endl; }
+
+  return best_leaf_nmax;
+}
+
+// all pairs self-evaluation. computes with arbitrary kernels. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename KernT>
+void KernelDensity<D,KT,FT,AT,TT>::self_eval(
+
+#ifndef __CUDACC__
+    std::vector<FloatType> &values, const KernT &kernel,
+    FloatType rel_err, FloatType abs_err
+#else
+    std::vector<FloatType> &values, const KernT &kernel,
+    FloatType rel_err, FloatType abs_err, 
+    size_t block_size
+#endif
+    
+    ) const {
+
+  SelfQueryState query_state(data_tree_);
+
+#ifndef __CUDACC__
+  dual_tree_eval(query_state, kernel, rel_err, abs_err);
+#else
+  dual_tree_eval(query_state, kernel, rel_err, abs_err, block_size);
+#endif
+
+  values.resize(data_tree_.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = query_state.lower(i) + (query_state.upper(i) - query_state.lower(i)) / 2;
+  }
+
+}
+
+// dual tree evaluation at the points of the query tree in `query_state`. 
+// on return, the query point bounds are normalized. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename KernT, typename QueryStateT>
+void KernelDensity<D,KT,FT,AT,TT>::dual_tree_eval(
+
+#ifndef __CUDACC__
+    QueryStateT &query_state, const KernT &kernel,
+    FloatType rel_err, FloatType abs_err
+#else
+    QueryStateT &query_state, const KernT &kernel,
+    FloatType rel_err, FloatType abs_err, 
+    size_t block_size
+#endif
+    
+    ) const {
+
   // initialize upper/lower bounds of individual queries to be
   // such that all data points contribute maximally/minimally
-  for (auto &q : query_tree.points_) { 
-    q.attributes().set_lower(0);
-    q.attributes().set_upper(data_tree_.root_->attr_.mass());
-  }
-  query_tree.refresh_node_attributes(query_tree.root_);
+  query_state.reset(data_tree_.root_->attr_.mass(), 0);
 
   FloatType du = 1.0, dl = 0.0;
 
+  const KdtreeType &query_tree = query_state.tree();
 
   // dual tree algorithm
-  FloatType normalization = kernel.normalization(); 
+  FloatType normalization = kernel.normalization() * weight_scale(); 
 
 #ifndef __CUDACC__
+  LeafPairList leaf_pairs;
   dual_tree(data_tree_.root_, query_tree.root_, kernel,
-            du, dl, rel_err, abs_err/normalization, query_tree);
+            du, dl, rel_err, abs_err/normalization, query_state, pool_.get(), 
+            defer_base_cases_ ? &leaf_pairs : nullptr);
+
+  // run the deferred base cases, then restore the node bounds as the min/max
+  // of the bounds below them. 
+  if (defer_base_cases_) {
+    run_leaf_pairs(leaf_pairs, kernel, query_state, pool_.get());
+    refresh_node_bounds(query_tree.root_, query_state);
+  }
 #else
   CudaDirectKde<D,KernelFloatType,KernT> 
     cu_kde(data_tree_.points(), query_tree.points());
@@ -718,24 +1252,43 @@ void KernelDensity<D,KT,FT,AT>::eval(
   std::vector<KernelFloatType> host_result_cache(query_tree.size());
 
   dual_tree(data_tree_.root_, query_tree.root_, kernel,
-            du, dl, rel_err, abs_err/normalization, query_tree,
+            du, dl, rel_err, abs_err/normalization, query_state,
             cu_kde, host_result_cache, block_size);
 #endif
 
   // remember to normalize
-  for (auto &q : query_tree.points_) { 
+  for (size_t i = 0; i < query_tree.size(); ++i) { 
 
-    q.attributes().set_lower(q.attributes().lower()*normalization);
-    q.attributes().set_upper(q.attributes().upper()*normalization);
+    query_state.set_bounds(i, query_state.upper(i)*normalization, 
+                              query_state.lower(i)*normalization);
 
-    report_error(std::cerr, q.point(), 
-                 q.attributes().upper(), q.attributes().lower(), 
+    report_error(std::cerr, query_tree.points_[i].point(), 
+                 query_state.upper(i), query_state.lower(i), 
                  rel_err, abs_err);
   }
 
   return;
 }
 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::TreeQueryState::reset(
+    FloatType upper, FloatType lower) {
+  for (auto &q : tree_.points_) { 
+    q.attributes().set_lower(lower);
+    q.attributes().set_upper(upper);
+  }
+  tree_.refresh_node_attributes(tree_.root_);
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::SelfQueryState::reset(
+    FloatType upper, FloatType lower) {
+  node_upper_.assign(tree_.nodes_.size(), upper);
+  node_lower_.assign(tree_.nodes_.size(), lower);
+  upper_.assign(tree_.size(), upper);
+  lower_.assign(tree_.size(), lower);
+}
+
 
 // tighten the contribution from all points in D_node to the upper/lower
 // bounds of Q_node as well as each individual queries in Q_node.
@@ -744,18 +1297,24 @@ void KernelDensity<D,KT,FT,AT>::eval(
 //
 // the lower/upper bounds of Q_node is the min/max of all lower/upper 
 // bounds of the individual queries 
-template<int D, typename KT, typename FT, typename AT>
-  template<typename KernT>
-void KernelDensity<D,KT,FT,AT>::dual_tree(
+//
+// if `pool` is not null, the recursions into Q_node's daughters are forked 
+// for large enough Q_node's. they touch disjoint parts of `query_state`. 
+//
+// if `leaf_pairs` is not null, the base cases are recorded there instead of 
+// run; see run_leaf_pairs(). 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename KernT, typename QueryStateT>
+void KernelDensity<D,KT,FT,AT,TT>::dual_tree(
 
 #ifndef __CUDACC__
-    const TreeNodeType *D_node, TreeNodeType *Q_node, const KernT &kernel,
+    const TreeNodeType *D_node, const TreeNodeType *Q_node, const KernT &kernel,
     FloatType du, FloatType dl, FloatType rel_err, FloatType abs_err,
-    KdtreeType &query_tree
+    QueryStateT &query_state, ThreadPool *pool, LeafPairList *leaf_pairs
 #else
-    const TreeNodeType *D_node, TreeNodeType *Q_node, const KernT &kernel,
+    const TreeNodeType *D_node, const TreeNodeType *Q_node, const KernT &kernel,
     FloatType du, FloatType dl, FloatType rel_err, FloatType abs_err,
-    KdtreeType &query_tree,
+    QueryStateT &query_state,
     CudaDirectKde<D,KernelFloatType,KernT> &cu_kde,
     std::vector<KernelFloatType> &host_result_cache,
     size_t block_size
@@ -767,26 +1326,33 @@ void KernelDensity<D,KT,FT,AT>::dual_tree(
   FloatType du_new, dl_new;
   estimate_contributions(D_node, Q_node->bbox_, kernel, du_new, dl_new);
 
+  // see estimate_mean_contributions(). 
+  FloatType du_mean = du_new, dl_mean = dl_new;
+  if (MomentBoundTraits<KernT>::value) {
+    estimate_mean_contributions(D_node, Q_node->bbox_, kernel, du_mean, dl_mean);
+  }
+
   // BOUND: decide whether the approximation satsifies the error guarantees
-  if (can_approximate(D_node, Q_node, 
-        du_new, dl_new, du, dl, rel_err, abs_err)) {
+  // safe to approximate only if all points can be approximated
+  if (can_approximate(D_node, du_mean, dl_mean, du, dl, 
+        query_state.node_upper(Q_node), query_state.node_lower(Q_node),
+        rel_err, abs_err, MomentBoundTraits<KernT>::value)) {
 
     // tighten the lower/upper bound of Q_node itself
-    tighten_bounds(D_node, Q_node, du_new, dl_new, du, dl);
+    tighten_bounds(D_node, Q_node, query_state, du_mean, dl_mean, du, dl);
 
     // tighten the individual queries
     FloatType upper_q, lower_q;
     for (auto i = Q_node->start_idx_; i <= Q_node->end_idx_; ++i) {
 
-      upper_q = query_tree.points_[i].attributes().upper();
-      lower_q = query_tree.points_[i].attributes().lower();
+      upper_q = query_state.upper(i);
+      lower_q = query_state.lower(i);
 
       // du/dl are set to 1.0/0.0 because they were never 
       // updated since initialization
-      tighten_bounds(D_node, du_new, dl_new, 1.0, 0.0, upper_q, lower_q);
+      tighten_bounds(D_node, du_mean, dl_mean, 1.0, 0.0, upper_q, lower_q);
 
-      query_tree.points_[i].attributes().set_upper(upper_q);
-      query_tree.points_[i].attributes().set_lower(lower_q);
+      query_state.set_bounds(i, upper_q, lower_q);
     }
 
     return;
@@ -799,9 +1365,10 @@ void KernelDensity<D,KT,FT,AT>::dual_tree(
   if (Q_node->is_leaf() && D_node->is_leaf()) {
 
 #ifndef __CUDACC__
-    dual_tree_base(D_node, Q_node, kernel, du, dl, query_tree);
+    if (leaf_pairs) { leaf_pairs->emplace_back(D_node, Q_node); }
+    else { dual_tree_base(D_node, Q_node, kernel, du, dl, query_state); }
 #else
-    dual_tree_base(D_node, Q_node, kernel, du, dl, query_tree, 
+    dual_tree_base(D_node, Q_node, kernel, du, dl, query_state, 
                    cu_kde, host_result_cache, block_size);
 #endif
     
@@ -814,23 +1381,23 @@ void KernelDensity<D,KT,FT,AT>::dual_tree(
 
       // tighten Q_node bounds for faster convergence. 
       // this is just an optimization. 
-      tighten_bounds(D_node, Q_node, du_new, dl_new, du, dl);
+      tighten_bounds(D_node, Q_node, query_state, du_new, dl_new, du, dl);
 
       // closer heuristic
-      TreeNodeType *closer = D_node->left_, *further = D_node->right_;
+      const TreeNodeType *closer = D_node->left(), *further = D_node->right();
       apply_closer_heuristic(&closer, &further, Q_node->bbox_);
 
 #ifndef __CUDACC__
       dual_tree(closer, Q_node, kernel, 
-          du_new, dl_new, rel_err, abs_err, query_tree);
+          du_new, dl_new, rel_err, abs_err, query_state, pool, leaf_pairs);
       dual_tree(further, Q_node, kernel, 
-          du_new, dl_new, rel_err, abs_err, query_tree);
+          du_new, dl_new, rel_err, abs_err, query_state, pool, leaf_pairs);
 #else
       dual_tree(closer, Q_node, kernel,
-          du_new, dl_new, rel_err, abs_err, query_tree,
+          du_new, dl_new, rel_err, abs_err, query_state,
           cu_kde, host_result_cache, block_size);
       dual_tree(further, Q_node, kernel,
-          du_new, dl_new, rel_err, abs_err, query_tree,
+          du_new, dl_new, rel_err, abs_err, query_state,
           cu_kde, host_result_cache, block_size);
 #endif
 
@@ -845,90 +1412,107 @@ void KernelDensity<D,KT,FT,AT>::dual_tree(
 
       // tighten bounds for faster convergence. this is just an optimization; 
       // one still needs to combine after recursion finishes.
-      tighten_bounds(D_node, Q_node->left_, du_new, dl_new, du, dl);
-      tighten_bounds(D_node, Q_node->right_, du_new, dl_new, du, dl);
+      tighten_bounds(D_node, Q_node->left(), query_state, du_new, dl_new, du, dl);
+      tighten_bounds(D_node, Q_node->right(), query_state, du_new, dl_new, du, dl);
+
+#ifndef __CUDACC__
+      // query subtrees smaller than this are not worth forking. 
+      const int fork_nmin = 1 << 10;
+      ThreadPool *fork_pool = Q_node->size() >= fork_nmin ? pool : nullptr;
+
+      // a forked task records its deferred leaf pairs apart; see LeafPairList. 
+      LeafPairList forked_pairs;
+      LeafPairList *forked_list = fork_pool && leaf_pairs ? &forked_pairs : leaf_pairs;
+#endif
 
       // case 2: D is a leaf
       if (D_node->is_leaf()) {
 
 #ifndef __CUDACC__
-        dual_tree(D_node, Q_node->left_, kernel, 
-            du_new, dl_new, rel_err, abs_err, query_tree);
-        dual_tree(D_node, Q_node->right_, kernel, 
-            du_new, dl_new, rel_err, abs_err, query_tree);
+        fork_join(fork_pool, 
+          [&] { dual_tree(D_node, Q_node->left(), kernel, 
+                    du_new, dl_new, rel_err, abs_err, query_state, pool, forked_list); },
+          [&] { dual_tree(D_node, Q_node->right(), kernel, 
+                    du_new, dl_new, rel_err, abs_err, query_state, pool, leaf_pairs); });
 #else 
-        dual_tree(D_node, Q_node->left_, kernel,
-            du_new, dl_new, rel_err, abs_err, query_tree,
+        dual_tree(D_node, Q_node->left(), kernel,
+            du_new, dl_new, rel_err, abs_err, query_state,
             cu_kde, host_result_cache, block_size);
-        dual_tree(D_node, Q_node->right_, kernel,
-            du_new, dl_new, rel_err, abs_err, query_tree,
+        dual_tree(D_node, Q_node->right(), kernel,
+            du_new, dl_new, rel_err, abs_err, query_state,
             cu_kde, host_result_cache, block_size);
 #endif
 
       // case 3: neither Q nor D are leaves
       } else {
 
-        // tighten Q->left
-        TreeNodeType *closer = D_node->left_, *further = D_node->right_;
-        apply_closer_heuristic(&closer, &further, Q_node->left_->bbox_);
-
 #ifndef __CUDACC__
-        dual_tree(closer, Q_node->left_, kernel, 
-            du_new, dl_new, rel_err, abs_err, query_tree);
-        dual_tree(further, Q_node->left_, kernel, 
-            du_new, dl_new, rel_err, abs_err, query_tree);
+        // tighten Q->left and Q->right
+        auto tighten_daughter = [&] (const TreeNodeType *Q_daughter, LeafPairList *pairs) {
+          const TreeNodeType *closer = D_node->left(), *further = D_node->right();
+          apply_closer_heuristic(&closer, &further, Q_daughter->bbox_);
+          dual_tree(closer, Q_daughter, kernel, 
+              du_new, dl_new, rel_err, abs_err, query_state, pool, pairs);
+          dual_tree(further, Q_daughter, kernel, 
+              du_new, dl_new, rel_err, abs_err, query_state, pool, pairs);
+        };
+        fork_join(fork_pool, 
+                  [&] { tighten_daughter(Q_node->left(), forked_list); }, 
+                  [&] { tighten_daughter(Q_node->right(), leaf_pairs); });
 #else
-        dual_tree(closer, Q_node->left_, kernel,
-            du_new, dl_new, rel_err, abs_err, query_tree,
+        // tighten Q->left
+        const TreeNodeType *closer = D_node->left(), *further = D_node->right();
+        apply_closer_heuristic(&closer, &further, Q_node->left()->bbox_);
+
+        dual_tree(closer, Q_node->left(), kernel,
+            du_new, dl_new, rel_err, abs_err, query_state,
             cu_kde, host_result_cache, block_size);
-        dual_tree(further, Q_node->left_, kernel,
-            du_new, dl_new, rel_err, abs_err, query_tree,
+        dual_tree(further, Q_node->left(), kernel,
+            du_new, dl_new, rel_err, abs_err, query_state,
             cu_kde, host_result_cache, block_size);
-#endif
 
         // tighten Q->right
-        closer = D_node->left_; further = D_node->right_;
-        apply_closer_heuristic(&closer, &further, Q_node->right_->bbox_);
+        closer = D_node->left(); further = D_node->right();
+        apply_closer_heuristic(&closer, &further, Q_node->right()->bbox_);
 
-#ifndef __CUDACC__
-        dual_tree(closer, Q_node->right_, kernel, 
-            du_new, dl_new, rel_err, abs_err, query_tree);
-        dual_tree(further, Q_node->right_, kernel, 
-            du_new, dl_new, rel_err, abs_err, query_tree);
-#else
-        dual_tree(closer, Q_node->right_, kernel,
-            du_new, dl_new, rel_err, abs_err, query_tree,
+        dual_tree(closer, Q_node->right(), kernel,
+            du_new, dl_new, rel_err, abs_err, query_state,
             cu_kde, host_result_cache, block_size);
-        dual_tree(further, Q_node->right_, kernel,
-            du_new, dl_new, rel_err, abs_err, query_tree,
+        dual_tree(further, Q_node->right(), kernel,
+            du_new, dl_new, rel_err, abs_err, query_state,
             cu_kde, host_result_cache, block_size);
 #endif
 
       }
 
+#ifndef __CUDACC__
+      if (forked_list != leaf_pairs) { 
+        leaf_pairs->insert(leaf_pairs->end(), forked_pairs.begin(), forked_pairs.end()); 
+      }
+#endif
+
       // combine the daughters' bounds to update Q_node's bounds
-      Q_node->attr_.set_lower(
-          std::min(Q_node->left_->attr_.lower(), 
-                   Q_node->right_->attr_.lower()));
-      Q_node->attr_.set_upper(
-          std::max(Q_node->left_->attr_.upper(), 
-                   Q_node->right_->attr_.upper()));
+      query_state.set_node_bounds(Q_node, 
+          std::max(query_state.node_upper(Q_node->left()), 
+                   query_state.node_upper(Q_node->right())),
+          std::min(query_state.node_lower(Q_node->left()), 
+                   query_state.node_lower(Q_node->right())));
     }
   }
 }
 
 
-template<int D, typename KT, typename FT, typename AT>
-  template<typename KernT>
-void KernelDensity<D,KT,FT,AT>::dual_tree_base(
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename KernT, typename QueryStateT>
+void KernelDensity<D,KT,FT,AT,TT>::dual_tree_base(
 #ifndef __CUDACC__
-    const TreeNodeType *D_node, TreeNodeType *Q_node, const KernT &kernel,
+    const TreeNodeType *D_node, const TreeNodeType *Q_node, const KernT &kernel,
     FloatType du, FloatType dl, 
-    KdtreeType &query_tree
+    QueryStateT &query_state
 #else
-    const TreeNodeType *D_node, TreeNodeType *Q_node, const KernT &kernel,
+    const TreeNodeType *D_node, const TreeNodeType *Q_node, const KernT &kernel,
     FloatType du, FloatType dl, 
-    KdtreeType &query_tree,
+    QueryStateT &query_state,
     CudaDirectKde<D,KernelFloatType,KernT> &cu_kde,
     std::vector<KernelFloatType> &host_result_cache,
     size_t block_size
@@ -945,18 +1529,44 @@ void KernelDensity<D,KT,FT,AT>::dual_tree_base(
   FloatType min_q = std::numeric_limits<FloatType>::max();
   FloatType max_q = std::numeric_limits<FloatType>::min();
 
+#ifndef __CUDACC__
+  // the queries of Q_node sum over D_node's points together, a chunk at a 
+  // time; see kernel_block_sums(). each sum is what single_tree_base() 
+  // would compute for the query alone. 
+  const size_t chunk_size = 64;
+  GeomPointType chunk[chunk_size];
+  FloatType sums[chunk_size];
+  const FloatType *coords[D];
+  for (int d = 0; d < D; ++d) { coords[d] = point_coords_[d].data() + D_node->start_idx_; }
+#endif
+
   FloatType lower_q, upper_q;
   for (auto i = Q_node->start_idx_; i <= Q_node->end_idx_; ++i) {
 
     // update the contribution of each point due to D_node
-    upper_q = query_tree.points_[i].attributes().upper();
-    lower_q = query_tree.points_[i].attributes().lower();
+    upper_q = query_state.upper(i);
+    lower_q = query_state.lower(i);
 
 #ifndef __CUDACC__
 
-    single_tree_base(
-        D_node, query_tree.points_[i].point(), kernel,
-        1.0, 0.0, upper_q, lower_q);
+    size_t k = (i - Q_node->start_idx_) % chunk_size;
+    if (k == 0) {
+      size_t n_chunk = std::min<size_t>(chunk_size, Q_node->end_idx_ + 1 - i);
+      for (size_t c = 0; c < n_chunk; ++c) { 
+        chunk[c] = query_state.tree().points_[i+c].point(); 
+        sums[c] = ConstantTraits<FloatType>::zero();
+      }
+      kernel_block_sums(kernel, chunk, n_chunk, coords, 
+                        point_abws_.data() + D_node->start_idx_, 
+                        point_masses_.data() + D_node->start_idx_, 
+                        D_node->size(), sums);
+    }
+
+    upper_q += sums[k]; lower_q += sums[k];
+    upper_q -= D_node->attr_.mass();
+
+    // see comment in tighten_bounds. 
+    if (lower_q > upper_q) { upper_q = lower_q; }
 
 #else
 
@@ -969,33 +1579,136 @@ void KernelDensity<D,KT,FT,AT>::dual_tree_base(
 
 #endif
 
-    query_tree.points_[i].attributes().set_lower(lower_q);
-    query_tree.points_[i].attributes().set_upper(upper_q);
+    query_state.set_bounds(i, upper_q, lower_q);
 
     min_q = std::min(lower_q, min_q);
     max_q = std::max(upper_q, max_q);
 
   }
 
-  Q_node->attr_.set_lower(min_q);
-  Q_node->attr_.set_upper(max_q);
+  query_state.set_node_bounds(Q_node, max_q, min_q);
 
 }
 
 
-template<int D, typename KT, typename FT, typename AT>
-void KernelDensity<D,KT,FT,AT>::tighten_bounds(
-    const TreeNodeType *D_node, TreeNodeType *Q_node,
+#ifndef __CUDACC__
+// evaluates the deferred base cases in `leaf_pairs`. each group of pairs 
+// that share a query leaf runs on a single thread, so that groups update 
+// disjoint queries; within a group, the data leaves are visited in the 
+// order of the data points, and runs of adjacent leaves are summed as one 
+// range of the point arrays. the bounds are updated as dual_tree_base() 
+// would have, for all data leaves of a group at once. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename KernT, typename QueryStateT>
+void KernelDensity<D,KT,FT,AT,TT>::run_leaf_pairs(
+    LeafPairList &pairs, const KernT &kernel, 
+    QueryStateT &query_state, ThreadPool *pool) const {
+
+  if (pairs.empty()) { return; }
+
+  auto by_query_leaf = [] (const LeafPair &l, const LeafPair &r) {
+    return l.second->start_idx_ < r.second->start_idx_ || 
+           (l.second->start_idx_ == r.second->start_idx_ && 
+            l.first->start_idx_ < r.first->start_idx_);
+  };
+  if (pool) { parallel_sort(pairs.begin(), pairs.end(), by_query_leaf, *pool); }
+  else { std::sort(pairs.begin(), pairs.end(), by_query_leaf); }
+
+  // groups[g] is the first pair of the g'th query leaf. 
+  std::vector<size_t> groups;
+  for (size_t k = 0; k < pairs.size(); ++k) {
+    if (!k || pairs[k].second != pairs[k-1].second) { groups.push_back(k); }
+  }
+  groups.push_back(pairs.size());
+
+  const KdtreeType &query_tree = query_state.tree();
+
+  parallel_for(pool, 0, groups.size()-1, 16, 
+    [&] (size_t b, size_t e) {
+      std::vector<GeomPointType> points;
+      std::vector<FloatType> sums;
+      const FloatType *coords[D];
+      for (size_t g = b; g < e; ++g) {
+
+        const TreeNodeType *Q_node = pairs[groups[g]].second;
+        points.resize(Q_node->size());
+        for (auto i = Q_node->start_idx_; i <= Q_node->end_idx_; ++i) {
+          points[i-Q_node->start_idx_] = query_tree.points_[i].point();
+        }
+        sums.assign(Q_node->size(), ConstantTraits<FloatType>::zero());
+
+        FloatType mass = ConstantTraits<FloatType>::zero();
+        for (size_t k = groups[g]; k < groups[g+1]; ) {
+
+          size_t r_i = pairs[k].first->start_idx_, r_j = pairs[k].first->end_idx_;
+          mass += pairs[k].first->attr_.mass();
+          for (++k; k < groups[g+1] && pairs[k].first->start_idx_ == r_j+1; ++k) {
+            r_j = pairs[k].first->end_idx_;
+            mass += pairs[k].first->attr_.mass();
+          }
+
+          for (int d = 0; d < D; ++d) { coords[d] = point_coords_[d].data() + r_i; }
+          kernel_block_sums(kernel, points.data(), points.size(), coords, 
+                            point_abws_.data() + r_i, point_masses_.data() + r_i, 
+                            r_j+1-r_i, sums.data());
+        }
+
+        for (auto i = Q_node->start_idx_; i <= Q_node->end_idx_; ++i) {
+          FloatType upper_q = query_state.upper(i) + sums[i-Q_node->start_idx_] - mass;
+          FloatType lower_q = query_state.lower(i) + sums[i-Q_node->start_idx_];
+
+          // see comment in tighten_bounds. 
+          if (lower_q > upper_q) { upper_q = lower_q; }
+          query_state.set_bounds(i, upper_q, lower_q);
+        }
+      }
+    });
+
+}
+
+// sets the bounds of Q_node and of the nodes below it to the min/max 
+// bounds of their queries. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename QueryStateT>
+void KernelDensity<D,KT,FT,AT,TT>::refresh_node_bounds(
+    const TreeNodeType *Q_node, QueryStateT &query_state) const {
+
+  if (Q_node->is_leaf()) {
+    FloatType max_q = query_state.upper(Q_node->start_idx_);
+    FloatType min_q = query_state.lower(Q_node->start_idx_);
+    for (auto i = Q_node->start_idx_+1; i <= Q_node->end_idx_; ++i) {
+      max_q = std::max(query_state.upper(i), max_q);
+      min_q = std::min(query_state.lower(i), min_q);
+    }
+    query_state.set_node_bounds(Q_node, max_q, min_q);
+    return;
+  }
+
+  refresh_node_bounds(Q_node->left(), query_state);
+  refresh_node_bounds(Q_node->right(), query_state);
+  query_state.set_node_bounds(Q_node, 
+      std::max(query_state.node_upper(Q_node->left()), 
+               query_state.node_upper(Q_node->right())),
+      std::min(query_state.node_lower(Q_node->left()), 
+               query_state.node_lower(Q_node->right())));
+}
+#endif
+
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename QueryStateT>
+void KernelDensity<D,KT,FT,AT,TT>::tighten_bounds(
+    const TreeNodeType *D_node, const TreeNodeType *Q_node, 
+    QueryStateT &query_state,
     FloatType du_new, FloatType dl_new, 
     FloatType du, FloatType dl) const {
 
-  FloatType upper = Q_node->attr_.upper();
-  FloatType lower = Q_node->attr_.lower();
+  FloatType upper = query_state.node_upper(Q_node);
+  FloatType lower = query_state.node_lower(Q_node);
 
   tighten_bounds(D_node, du_new, dl_new, du, dl, upper, lower);
 
-  Q_node->attr_.set_upper(upper);
-  Q_node->attr_.set_lower(lower);
+  query_state.set_node_bounds(Q_node, upper, lower);
 }
 
 
@@ -1005,8 +1718,8 @@ void KernelDensity<D,KT,FT,AT>::tighten_bounds(
 //
 // output invariants:
 // + lower <= upper
-template<int D, typename KT, typename FT, typename AT>
-void KernelDensity<D,KT,FT,AT>::tighten_bounds(
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::tighten_bounds(
     const TreeNodeType *D_node,
     FloatType du_new, FloatType dl_new, 
     FloatType du, FloatType dl, 
@@ -1026,20 +1739,6 @@ void KernelDensity<D,KT,FT,AT>::tighten_bounds(
 
 
 
-template<int D, typename KT, typename FT, typename AT>
-inline bool KernelDensity<D,KT,FT,AT>::can_approximate(
-    const TreeNodeType *D_node, const TreeNodeType *Q_node,
-    FloatType du_new, FloatType dl_new, 
-    FloatType du, FloatType dl, 
-    FloatType rel_err, FloatType abs_err) const {
-
-  // safe to approximate only if all points can be approximated
-  return can_approximate(D_node, du_new, dl_new, du, dl, 
-                         Q_node->attr_.upper(), Q_node->attr_.lower(),
-                         rel_err, abs_err);
-}
-
-
 // decide whether the current updates allow a prune
 //
 // + For the condition that gurantees the absolute errors, see 
@@ -1047,13 +1746,13 @@ inline bool KernelDensity<D,KT,FT,AT>::can_approximate(
 //
 // + For the condition that gurantees the relative errors, see 
 //   Section 4.3. of Gray and Moore
-template<int D, typename KT, typename FT, typename AT>
-bool KernelDensity<D,KT,FT,AT>::can_approximate(
+template<int D, typename KT, typename FT, typename AT, typename TT>
+bool KernelDensity<D,KT,FT,AT,TT>::can_approximate(
     const TreeNodeType *D_node,
     FloatType du_new, FloatType dl_new, 
     FloatType du, FloatType dl, 
     FloatType upper, FloatType lower, 
-    FloatType rel_err, FloatType abs_err) const {
+    FloatType rel_err, FloatType abs_err, bool moment_bounds) const {
 
   FloatType abs_tol = 2 * abs_err / data_tree_.size();
 
@@ -1067,8 +1766,21 @@ bool KernelDensity<D,KT,FT,AT>::can_approximate(
 
   tighten_bounds(D_node, du_new, dl_new, du, dl, upper, lower);
 
-  if (std::abs(upper-lower) <= abs_err || 
-      std::abs(upper-lower) <= std::abs(lower)*rel_err) { return true; }
+  // with `moment_bounds`, every node is credited up front, so the bounds 
+  // gap closes early; require both tolerances, so that results stay within 
+  // abs_err as well. otherwise, either suffices. 
+  FloatType gap = std::abs(upper-lower);
+  if (moment_bounds) {
+    if (gap <= abs_err && gap <= std::abs(lower)*rel_err) { return true; }
+  } else if (gap <= abs_err || gap <= std::abs(lower)*rel_err) { return true; }
+
+  // condition 3: guarantee relative error <= rel_err and absolute error 
+  // <= abs_err by allotting each node a share of both tolerances in 
+  // proportion to its mass. only with `moment_bounds`, i.e. for kernels 
+  // with MomentBoundTraits<>, whose traversal credits every node. 
+  FloatType share_gap = std::abs(du_new - dl_new) * data_tree_.root_->attr_.mass();
+  if (moment_bounds && share_gap <= std::abs(lower)*rel_err && 
+      share_gap <= abs_err) { return true; }
 
   return false;
 
@@ -1077,10 +1789,10 @@ bool KernelDensity<D,KT,FT,AT>::can_approximate(
 
 
 
-template<int D, typename KT, typename FT, typename AT>
+template<int D, typename KT, typename FT, typename AT, typename TT>
   template<typename ObjT>
-inline void KernelDensity<D,KT,FT,AT>::apply_closer_heuristic(
-    TreeNodeType **closer, TreeNodeType **further, const ObjT &obj) const {
+inline void KernelDensity<D,KT,FT,AT,TT>::apply_closer_heuristic(
+    const TreeNodeType **closer, const TreeNodeType **further, const ObjT &obj) const {
 
   if ((*closer)->bbox_.min_dist(obj) > (*further)->bbox_.min_dist(obj)) {
     std::swap(*closer, *further);
@@ -1089,29 +1801,144 @@ inline void KernelDensity<D,KT,FT,AT>::apply_closer_heuristic(
 }
 
 
-template<int D, typename KT, typename FT, typename AT>
+template<int D, typename KT, typename FT, typename AT, typename TT>
   template<typename ObjT, typename KernT> 
-void KernelDensity<D,KT,FT,AT>::estimate_contributions(
+void KernelDensity<D,KT,FT,AT,TT>::estimate_contributions(
     const TreeNodeType *D_node, const ObjT &obj, const KernT &kernel,
     FloatType &du, FloatType &dl) const {
 
-  GeomPointType proxy;
+  GeomPointType near, far;
   const static GeomPointType origin;
 
-  // use the minimum(maximum) distance to the argument in each 
-  // dimension to bound the min/max kernel contributions
+  // evaluate the kernel at the nearest(farthest) displacement between the 
+  // node and the argument to bound the max/min kernel contributions. 
+  distance_proxies(D_node->bbox_, obj, kernel, near, far);
+  du = kernel.unnormalized_eval(near, origin, D_node->attr_.upper_abw());
+  dl = kernel.unnormalized_eval(far, origin, D_node->attr_.lower_abw());
+
+}
+
+// on input, `du` and `dl` bound the contribution per unit mass of every 
+// point in D_node towards every point of `obj`, as from 
+// estimate_contributions(). on output, they bound the mass weighted mean 
+// of these contributions, which is what prunes credit. 
+//
+// kernels with MomentBoundTraits<> are non-increasing and convex functions 
+// K(t) of the squared distance t. if every point of D_node 
+// has the same bandwidth correction, then with its centroid c and spread s: 
+// + the mean of t over D_node is |q-c|^2 + s, exactly. 
+// + lower: the mean of K(t) is at least K(mean of t) (Jensen). 
+// + upper: K(t) lies below its chord over [t_min, t_max], the range of t 
+//   spanned by the node bounds, and the chord is linear in t. 
+// the bounds are then extended from q to all of `obj` by the min/max 
+// distances from `obj` to c. otherwise, or if the estimator's own kernel 
+// keeps no moments, the input is left unchanged. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename ObjT, typename KernT> 
+void KernelDensity<D,KT,FT,AT,TT>::estimate_mean_contributions(
+    const TreeNodeType *D_node, const ObjT &obj, const KernT &kernel,
+    FloatType &du, FloatType &dl) const {
+
+  if (!MomentBoundTraits<KernT>::value || !RadialKernelTraits<KernT>::value || 
+      node_moments_.empty() || 
+      D_node->attr_.lower_abw() != D_node->attr_.upper_abw()) { return; }
+
+  const NodeMoments &m = node_moments_[D_node - data_tree_.root_];
+  FloatType abw = D_node->attr_.upper_abw();
+
+  GeomPointType near, far;
+  distance_proxies(D_node->bbox_, obj, kernel, near, far);
+  FloatType t_min = ConstantTraits<FloatType>::zero(), t_max = t_min;
+  for (int i = 0; i < D; ++i) { t_min += near[i] * near[i]; t_max += far[i] * far[i]; }
 
-  for (int i = 0; i < D; ++i) { proxy[i] = D_node->bbox_.min_dist(i, obj); }
-  du = kernel.unnormalized_eval(proxy, origin, D_node->attr_.upper_abw());
+  FloatType c_near, c_far;
+  centroid_distances(obj, m.centroid_, c_near, c_far);
 
-  for (int i = 0; i < D; ++i) { proxy[i] = D_node->bbox_.max_dist(i, obj); }
-  dl = kernel.unnormalized_eval(proxy, origin, D_node->attr_.lower_abw());
+  // K(t), as a radial kernel sees it. 
+  const static GeomPointType origin;
+  auto eval_sq_dist = [&] (FloatType t) {
+    GeomPointType r; r[0] = std::sqrt(t);
+    return kernel.unnormalized_eval(r, origin, abw);
+  };
+
+  FloatType du_chord = du;
+  if (t_max > t_min) {
+    FloatType t_near = std::min(std::max(c_near * c_near + m.spread_, t_min), t_max);
+    du_chord = du + (dl - du) * (t_near - t_min) / (t_max - t_min);
+  }
+  FloatType dl_jensen = eval_sq_dist(std::min(c_far * c_far + m.spread_, t_max));
 
+  du = std::min(du, du_chord);
+  dl = std::max(dl, dl_jensen);
+  if (dl > du) { du = dl; }
 }
 
+// the tightest available bounds on the contribution per unit mass of 
+// D_node as a whole. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename ObjT, typename KernT> 
+inline void KernelDensity<D,KT,FT,AT,TT>::estimate_node_contributions(
+    const TreeNodeType *D_node, const ObjT &obj, const KernT &kernel,
+    FloatType &du, FloatType &dl) const {
+  estimate_contributions(D_node, obj, kernel, du, dl);
+  estimate_mean_contributions(D_node, obj, kernel, du, dl);
+}
+
+// set `near` and `far` to the min/max distance from `obj` to the point c. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename BoundT> 
+inline void KernelDensity<D,KT,FT,AT,TT>::centroid_distances(
+    const BoundT &obj, const GeomPointType &c, FloatType &near, FloatType &far) {
+  near = obj.min_dist(c); far = obj.max_dist(c);
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline void KernelDensity<D,KT,FT,AT,TT>::centroid_distances(
+    const GeomPointType &obj, const GeomPointType &c, FloatType &near, FloatType &far) {
+  FloatType total = ConstantTraits<FloatType>::zero();
+  for (int i = 0; i < D; ++i) { total += (obj[i] - c[i]) * (obj[i] - c[i]); }
+  near = far = std::sqrt(total);
+}
 
-template<int D, typename KT, typename FT, typename AT>
-void KernelDensity<D,KT,FT,AT>::report_error(
+// use the minimum(maximum) distance to the argument in each dimension. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename ObjT, typename KernT> 
+inline void KernelDensity<D,KT,FT,AT,TT>::distance_proxies(
+    const Rectangle<D,FT> &bound, const ObjT &obj, const KernT&, 
+    GeomPointType &near, GeomPointType &far) {
+  for (int i = 0; i < D; ++i) { near[i] = bound.min_dist(i, obj); }
+  for (int i = 0; i < D; ++i) { far[i] = bound.max_dist(i, obj); }
+}
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename ObjT, typename KernT> 
+inline void KernelDensity<D,KT,FT,AT,TT>::distance_proxies(
+    const CompactRectangle<D,FT> &bound, const ObjT &obj, const KernT&, 
+    GeomPointType &near, GeomPointType &far) {
+  for (int i = 0; i < D; ++i) { near[i] = bound.min_dist(i, obj); }
+  for (int i = 0; i < D; ++i) { far[i] = bound.max_dist(i, obj); }
+}
+
+// radial kernels only see the euclidean distance, which balls bound 
+// directly. the others fall back to the projections of the ball onto 
+// each axis. 
+template<int D, typename KT, typename FT, typename AT, typename TT>
+  template<typename ObjT, typename KernT> 
+inline void KernelDensity<D,KT,FT,AT,TT>::distance_proxies(
+    const Ball<D,FT> &bound, const ObjT &obj, const KernT&, 
+    GeomPointType &near, GeomPointType &far) {
+  if (RadialKernelTraits<KernT>::value) {
+    near[0] = bound.min_dist(obj);
+    far[0] = bound.max_dist(obj);
+  } else {
+    for (int i = 0; i < D; ++i) { near[i] = bound.min_dist(i, obj); }
+    for (int i = 0; i < D; ++i) { far[i] = bound.max_dist(i, obj); }
+  }
+}
+
+
+template<int D, typename KT, typename FT, typename AT, typename TT>
+void KernelDensity<D,KT,FT,AT,TT>::report_error(
     std::ostream &os, const GeomPointType &p,
     FloatType upper, FloatType lower, 
     FloatType rel_err, FloatType abs_err) const {
@@ -1144,9 +1971,9 @@ void KernelDensity<D,KT,FT,AT>::report_error(
 
 // user wrapper for direct kernel density evaluation.
 // computes with the default kernel. 
-template<int D, typename KT, typename FT, typename AT>
-typename KernelDensity<D,KT,FT,AT>::FloatType
-KernelDensity<D,KT,FT,AT>::direct_eval(DataPointType &p) const {
+template<int D, typename KT, typename FT, typename AT, typename TT>
+typename KernelDensity<D,KT,FT,AT,TT>::FloatType
+KernelDensity<D,KT,FT,AT,TT>::direct_eval(DataPointType &p) const {
   FloatType result = direct_eval(p.point(), kernel_);
   p.attributes().set_upper(result);
   p.attributes().set_lower(result);
@@ -1154,20 +1981,17 @@ KernelDensity<D,KT,FT,AT>::direct_eval(DataPointType &p) const {
 }
 
 // direct kernel density evaluation. computes using arbitrary kernels. 
-template<int D, typename KT, typename FT, typename AT>
+template<int D, typename KT, typename FT, typename AT, typename TT>
   template<typename KernT>
-typename KernelDensity<D,KT,FT,AT>::FloatType
-KernelDensity<D,KT,FT,AT>::direct_eval(
+typename KernelDensity<D,KT,FT,AT,TT>::FloatType
+KernelDensity<D,KT,FT,AT,TT>::direct_eval(
     const GeomPointType &p, const KernT &kernel) const {
 
-  FloatType total = ConstantTraits<FloatType>::zero();
-  for (const auto &datum : data_tree_.points()) {
-    total += 
-      datum.attributes().mass() * 
-      kernel.unnormalized_eval(p, datum.point(), 
-                                  datum.attributes().abw() );
-  }
-  total *= kernel.normalization();
+  const FloatType *coords[D];
+  for (int d = 0; d < D; ++d) { coords[d] = point_coords_[d].data(); }
+  FloatType total = kernel_block_sum(
+      kernel, p, coords, point_abws_.data(), point_masses_.data(), point_masses_.size());
+  total *= kernel.normalization() * weight_scale();
   return total;
 
 }
@@ -1175,15 +1999,15 @@ KernelDensity<D,KT,FT,AT>::direct_eval(
 
 // user wrapper for direct kernel density evaluation.
 #ifndef __CUDACC__
-template<int D, typename KT, typename FT, typename AT>
-inline void KernelDensity<D,KT,FT,AT>::direct_eval(
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline void KernelDensity<D,KT,FT,AT,TT>::direct_eval(
     std::vector<DataPointType> &queries) const {
   direct_eval(queries, kernel_);
   return; 
 }
 #else 
-template<int D, typename KT, typename FT, typename AT>
-inline void KernelDensity<D,KT,FT,AT>::direct_eval(
+template<int D, typename KT, typename FT, typename AT, typename TT>
+inline void KernelDensity<D,KT,FT,AT,TT>::direct_eval(
     std::vector<DataPointType> &queries, size_t block_size
     ) const {
   direct_eval(queries, kernel_, block_size);
@@ -1194,9 +2018,9 @@ inline void KernelDensity<D,KT,FT,AT>::direct_eval(
 
 
 // direct kernel density evaluation. computes using arbitrary kernels. 
-template<int D, typename KT, typename FT, typename AT>
+template<int D, typename KT, typename FT, typename AT, typename TT>
   template<typename KernT>
-void KernelDensity<D,KT,FT,AT>::direct_eval(
+void KernelDensity<D,KT,FT,AT,TT>::direct_eval(
 
 #ifndef __CUDACC__
     std::vector<DataPointType> &queries, const KernT &kernel
@@ -1207,10 +2031,28 @@ void KernelDensity<D,KT,FT,AT>::direct_eval(
     ) const {
 
 #ifndef __CUDACC__
-  for (auto &q : queries) {
-    FloatType result = direct_eval(q.point(), kernel);
-    q.attributes().set_lower(result);
-    q.attributes().set_upper(result);
+  if (queries.empty() || !data_tree_.size()) { 
+    for (auto &q : queries) { q.attributes().set_lower(0); q.attributes().set_upper(0); }
+    return; 
+  }
+
+  std::vector<GeomPointType> query_points(queries.size());
+  for (size_t i = 0; i < queries.size(); ++i) { query_points[i] = queries[i].point(); }
+  std::vector<FloatType> host_results(queries.size());
+
+  // views the point arrays in place. 
+  const FloatType *coords[D];
+  for (int d = 0; d < D; ++d) { coords[d] = point_coords_[d].data(); }
+  CpuDirectKde<D,FloatType,KernT> cpu_kde(
+      coords, point_masses_.data(), point_abws_.data(), data_tree_.size(), pool_);
+  cpu_kde.kernel() = kernel;
+
+  cpu_kde.eval(0, data_tree_.size()-1, query_points.data(), query_points.size(), 
+               host_results.data());
+
+  for (size_t i = 0; i < queries.size(); ++i) {
+    queries[i].attributes().set_lower(host_results[i] * weight_scale());
+    queries[i].attributes().set_upper(host_results[i] * weight_scale());
   }
 #else
   std::vector<KernelFloatType> host_results(queries.size());
@@ -1222,8 +2064,8 @@ void KernelDensity<D,KT,FT,AT>::direct_eval(
                 host_results, block_size);
 
   for (size_t i = 0; i < queries.size(); ++i) {
-    queries[i].attributes().set_lower(host_results[i]);
-    queries[i].attributes().set_upper(host_results[i]);
+    queries[i].attributes().set_lower(host_results[i] * weight_scale());
+    queries[i].attributes().set_upper(host_results[i] * weight_scale());
   }
 #endif
 
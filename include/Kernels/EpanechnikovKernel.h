@@ -92,6 +92,29 @@ class EpanechnikovKernel {
     
 };
 
+template<int D, typename T>
+class RadialKernelTraits<EpanechnikovKernel<D,T>> {
+  public:
+    static constexpr bool value = true;
+};
+
+template<int D, typename T>
+class MomentBoundTraits<EpanechnikovKernel<D,T>> {
+  public:
+    static constexpr bool value = true;
+};
+
+template<int D>
+class KernelBlockTraits<EpanechnikovKernel<D,double>> {
+  public:
+    static constexpr bool value = true;
+    static constexpr int dim = D;
+    static constexpr KernelBlockShape shape = KernelBlockShape::Epanechnikov;
+    static void scales(const EpanechnikovKernel<D,double> &k, double *s) {
+      for (int d = 0; d < D; ++d) { s[d] = 1.0 / (k.bandwidth() * k.bandwidth()); }
+    }
+};
+
 // Implementations
 // ---------------
 
@@ -89,6 +89,17 @@ class CUDA_ALIGN16 EpanechnikovProductKernel2d {
     
 };
 
+template<>
+class KernelBlockTraits<EpanechnikovProductKernel2d<double>> {
+  public:
+    static constexpr bool value = true;
+    static constexpr int dim = 2;
+    static constexpr KernelBlockShape shape = KernelBlockShape::EpanechnikovProduct;
+    static void scales(const EpanechnikovProductKernel2d<double> &k, double *s) {
+      s[0] = 1.0 / (k.hx() * k.hx()); s[1] = 1.0 / (k.hy() * k.hy());
+    }
+};
+
 // Implementations
 // ---------------
 
@@ -88,6 +88,23 @@ class GaussianKernel {
     
 };
 
+template<int D, typename T>
+class RadialKernelTraits<GaussianKernel<D,T>> {
+  public:
+    static constexpr bool value = true;
+};
+
+template<int D>
+class KernelBlockTraits<GaussianKernel<D,double>> {
+  public:
+    static constexpr bool value = true;
+    static constexpr int dim = D;
+    static constexpr KernelBlockShape shape = KernelBlockShape::Gaussian;
+    static void scales(const GaussianKernel<D,double> &k, double *s) {
+      for (int d = 0; d < D; ++d) { s[d] = 1.0 / (k.bandwidth() * k.bandwidth()); }
+    }
+};
+
 // Implementations
 // ---------------
 
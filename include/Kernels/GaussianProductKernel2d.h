@@ -90,6 +90,17 @@ class CUDA_ALIGN16 GaussianProductKernel2d {
     
 };
 
+template<>
+class KernelBlockTraits<GaussianProductKernel2d<double>> {
+  public:
+    static constexpr bool value = true;
+    static constexpr int dim = 2;
+    static constexpr KernelBlockShape shape = KernelBlockShape::Gaussian;
+    static void scales(const GaussianProductKernel2d<double> &k, double *s) {
+      s[0] = 1.0 / (k.hx() * k.hx()); s[1] = 1.0 / (k.hy() * k.hy());
+    }
+};
+
 // Implementations
 // ---------------
 
@@ -446,6 +446,57 @@ class GaussianProductConv2dTraits<double> {
     }
 };
 
+// RadialKernel
+// ------------
+
+// RadialKernelTraits<KernelT>::value is true if KernelT depends on its point 
+// argument only through the euclidean norm. such kernels can be bounded from 
+// euclidean distances alone, as with Ball<> bounds; the others need bounds 
+// on the distance in each dimension. 
+template<typename KernelT> 
+class RadialKernelTraits {
+  public:
+    static constexpr bool value = false;
+};
+
+// MomentBound
+// -----------
+
+// MomentBoundTraits<KernelT>::value is true to have KernelDensity<> bound 
+// node contributions of KernelT from the node centroids and spreads, and 
+// prune each node once its bounds gap is within its mass share of both the 
+// relative and the absolute error. KernelT must be radial, and 
+// non-increasing and convex in the squared norm, as the Epanechnikov and 
+// Gaussian kernels are. the estimator only maintains the moments for 
+// kernels that opt in. 
+template<typename KernelT> 
+class MomentBoundTraits {
+  public:
+    static constexpr bool value = false;
+};
+
+// KernelBlock
+// -----------
+
+// shapes of the kernels with vectorized block sums; see KernelBlockSum.h. 
+// each is a function of t_d = (p_d-q_d)^2 * scale_d / (a*a), d < D. 
+enum class KernelBlockShape { 
+  Gaussian,             // exp(-0.5 * sum_d t_d)
+  Epanechnikov,         // max(1 - sum_d t_d, 0)
+  EpanechnikovProduct   // prod_d max(1 - t_d, 0)
+};
+
+// KernelBlockTraits<KernelT>::value is true if U(p,q,a) of KernelT is one 
+// of the KernelBlockShape's. such kernels also provide: 
+// + dim: the dimension D. 
+// + shape: the KernelBlockShape. 
+// + scales(k, s): writes scale_d of kernel `k` to s[d]. 
+template<typename KernelT> 
+class KernelBlockTraits {
+  public:
+    static constexpr bool value = false;
+};
+
 }
 
 #endif
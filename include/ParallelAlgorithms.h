@@ -0,0 +1,148 @@
+#ifndef BBRCITKDE_PARALLELALGORITHMS_H__
+#define BBRCITKDE_PARALLELALGORITHMS_H__
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <cstddef>
+
+#include <ThreadPool.h>
+
+// API
+// ---
+
+namespace bbrcit {
+
+// calls `f(b, e)` on subranges of [begin, end) as ThreadPool::parallel_for() 
+// does. runs serially on the calling thread if `pool` is null. 
+template<typename F>
+void parallel_for(ThreadPool *pool, size_t begin, size_t end, size_t grain, F f);
+
+// runs `f1` and `f2` as ThreadPool::fork_join() does. runs them one after 
+// the other on the calling thread if `pool` is null. 
+template<typename F1, typename F2>
+void fork_join(ThreadPool *pool, F1 &&f1, F2 &&f2);
+
+// sorts [first, last) like std::sort(). ranges larger than `grain` are split
+// in halves that are sorted in parallel and then merged.
+template<typename RandomIt, typename Compare>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp,
+                   ThreadPool &pool, size_t grain = 1 << 15);
+
+// rearranges [first, last) like std::nth_element(). ranges larger than
+// `grain` are narrowed down by parallel three-way partitions around
+// sampled pivots before the serial algorithm takes over.
+template<typename RandomIt, typename Compare>
+void parallel_nth_element(RandomIt first, RandomIt nth, RandomIt last, Compare comp,
+                          ThreadPool &pool, size_t grain = 1 << 16);
+
+// Implementations
+// ---------------
+
+template<typename F>
+void parallel_for(ThreadPool *pool, size_t begin, size_t end, size_t grain, F f) {
+  if (pool) { pool->parallel_for(begin, end, grain, f); return; }
+  if (grain < 1) { grain = 1; }
+  for (size_t b = begin; b < end; b += grain) { f(b, std::min(b+grain, end)); }
+}
+
+template<typename F1, typename F2>
+void fork_join(ThreadPool *pool, F1 &&f1, F2 &&f2) {
+  if (pool) { pool->fork_join(std::forward<F1>(f1), std::forward<F2>(f2)); return; }
+  f1(); f2();
+}
+
+template<typename RandomIt, typename Compare>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp,
+                   ThreadPool &pool, size_t grain) {
+
+  size_t n = last - first;
+  if (n <= grain || pool.size() == 1) { std::sort(first, last, comp); return; }
+
+  RandomIt mid = first + n / 2;
+  pool.fork_join([&] { parallel_sort(first, mid, comp, pool, grain); },
+                 [&] { parallel_sort(mid, last, comp, pool, grain); });
+  std::inplace_merge(first, mid, last, comp);
+}
+
+template<typename RandomIt, typename Compare>
+void parallel_nth_element(RandomIt first, RandomIt nth, RandomIt last, Compare comp,
+                          ThreadPool &pool, size_t grain) {
+
+  using ValueType = typename std::iterator_traits<RandomIt>::value_type;
+
+  // elements are scattered into `buffer` and then moved back.
+  std::vector<ValueType> buffer;
+
+  while (static_cast<size_t>(last - first) > grain && pool.size() > 1) {
+
+    size_t n = last - first;
+
+    // pivot: the median of a strided sample.
+    const size_t n_sample = 127;
+    std::vector<ValueType> sample; sample.reserve(n_sample);
+    for (size_t k = 0; k < n_sample; ++k) { sample.push_back(first[k * (n / n_sample)]); }
+    std::nth_element(sample.begin(), sample.begin() + n_sample/2, sample.end(), comp);
+    const ValueType pivot = sample[n_sample/2];
+
+    // count the elements less than, equal to, and greater than the pivot
+    // in each chunk.
+    size_t n_chunks = 4 * pool.size();
+    size_t chunk = (n + n_chunks - 1) / n_chunks;
+    n_chunks = (n + chunk - 1) / chunk;
+
+    std::vector<size_t> n_less(n_chunks, 0), n_equal(n_chunks, 0);
+    pool.parallel_for(0, n_chunks, 1, [&] (size_t b, size_t e) {
+      for (size_t c = b; c < e; ++c) {
+        for (size_t k = c*chunk; k < std::min(n, (c+1)*chunk); ++k) {
+          if (comp(first[k], pivot)) { ++n_less[c]; }
+          else if (!comp(pivot, first[k])) { ++n_equal[c]; }
+        }
+      }
+    });
+
+    // exclusive prefix sums give every chunk its output offsets.
+    size_t total_less = 0, total_equal = 0;
+    for (size_t c = 0; c < n_chunks; ++c) { total_less += n_less[c]; total_equal += n_equal[c]; }
+
+    std::vector<size_t> less_pos(n_chunks), equal_pos(n_chunks), greater_pos(n_chunks);
+    size_t l = 0, q = total_less, g = total_less + total_equal;
+    for (size_t c = 0; c < n_chunks; ++c) {
+      less_pos[c] = l; equal_pos[c] = q; greater_pos[c] = g;
+      size_t c_size = std::min(n, (c+1)*chunk) - c*chunk;
+      l += n_less[c]; q += n_equal[c]; g += c_size - n_less[c] - n_equal[c];
+    }
+
+    if (buffer.size() < n) { buffer.resize(n); }
+    pool.parallel_for(0, n_chunks, 1, [&] (size_t b, size_t e) {
+      for (size_t c = b; c < e; ++c) {
+        size_t li = less_pos[c], qi = equal_pos[c], gi = greater_pos[c];
+        for (size_t k = c*chunk; k < std::min(n, (c+1)*chunk); ++k) {
+          if (comp(first[k], pivot)) { buffer[li++] = std::move(first[k]); }
+          else if (!comp(pivot, first[k])) { buffer[qi++] = std::move(first[k]); }
+          else { buffer[gi++] = std::move(first[k]); }
+        }
+      }
+    });
+    pool.parallel_for(0, n, chunk, [&] (size_t b, size_t e) {
+      std::move(buffer.begin() + b, buffer.begin() + e, first + b);
+    });
+
+    // continue in the block containing nth. the equal block is final.
+    size_t k = nth - first;
+    if (k < total_less) {
+      last = first + total_less;
+    } else if (k < total_less + total_equal) {
+      return;
+    } else {
+      first = first + total_less + total_equal;
+    }
+  }
+
+  std::nth_element(first, nth, last, comp);
+}
+
+}
+
+#endif
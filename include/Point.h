@@ -1,8 +1,8 @@
 #ifndef BBRCITKDE_POINT_H__
 #define BBRCITKDE_POINT_H__
 
-#include <vector>
 #include <utility>
+#include <algorithm>
 #include <stdexcept>
 #include <initializer_list>
 #include <iostream>
@@ -59,18 +59,19 @@ class Point {
     // constructor: allows the usage Point<2,double> p = { 0.0, 1.0 };
     Point(const std::initializer_list<T>&);
 
-    // copy-control
-    Point(const Point<D,T>&);
-    Point<D,T>& operator=(const Point<D,T>&);
-    Point(Point<D,T>&&) noexcept;
-    Point<D,T>& operator=(Point<D,T> &&rhs) noexcept;
-    ~Point();
+    // copy-control. these are all trivial; Point<>'s are safe to memcpy. 
+    Point(const Point<D,T>&) = default;
+    Point<D,T>& operator=(const Point<D,T>&) = default;
+    Point(Point<D,T>&&) noexcept = default;
+    Point<D,T>& operator=(Point<D,T> &&rhs) noexcept = default;
+    ~Point() = default;
 
     // reset coordinate values: coordinate i set to element i in arg. 
     // other elements set to T(). 
     void reset(const std::initializer_list<T> &li);
 
     // access coordinate values by indexing (0 for 1st coordiate etc.)
+    // no bounds checking is performed. 
     const T& operator[](int) const;
     T& operator[](int);
 
@@ -84,8 +85,9 @@ class Point {
 
   private:
 
-    // represent the point using a list of coordinates of length D. 
-    std::vector<T> coord_;
+    // represent the point using an inline array of coordinates of length D. 
+    // the storage is fixed at compile time so that Point<>'s never touch the heap. 
+    T coord_[D];
 };
 
 
@@ -94,8 +96,9 @@ class Point {
 
 template <int D, typename T> 
 void Point<D,T>::reset(const std::initializer_list<T> &li) {
-  coord_ = li; 
-  if (coord_.size() != D) { coord_.resize(D); }
+  int n = std::min(static_cast<int>(li.size()), D);
+  std::copy(li.begin(), li.begin()+n, coord_);
+  std::fill(coord_+n, coord_+D, T());
 }
 
 template <int D, typename T> 
@@ -147,7 +150,7 @@ Point<D,T>& Point<D,T>::operator-=(const Point<D,T> &rhs) {
 
 template<int D, typename T>
 Point<D,T>& Point<D,T>::operator*=(double c) {
-  for (auto &e : coord_) { e *= c; }
+  for (int i = 0; i < D; ++i) { coord_[i] *= c; }
   return *this;
 }
 
@@ -156,7 +159,7 @@ Point<D,T>& Point<D,T>::operator/=(double c) {
   if (!c) { 
     throw std::domain_error("Point<>: operator/=(): division by zero. ");
   }
-  for (auto &e : coord_) { e /= c; }
+  for (int i = 0; i < D; ++i) { coord_[i] /= c; }
   return *this;
 }
 
@@ -166,34 +169,11 @@ inline void swap(Point<D,T> &lhs, Point<D,T> &rhs) {
 }
 
 template<int D, typename T>
-Point<D,T>::Point() : coord_(D) {}
+Point<D,T>::Point() : coord_() {}
 
 template<int D, typename T>
-Point<D,T>::Point(const std::initializer_list<T> &li) : coord_(li) {
-  if (coord_.size() != D) { coord_.resize(D); }
-}
-
-template<int D, typename T>
-Point<D,T>::~Point() {}
-
-template<int D, typename T>
-Point<D,T>::Point(const Point<D,T> &rhs) : coord_(rhs.coord_) {}
-
-template<int D, typename T>
-Point<D,T>::Point(Point<D,T> &&t) noexcept : coord_(std::move(t.coord_)) {}
-
-template<int D, typename T>
-Point<D,T>& Point<D,T>::operator=(const Point<D,T> &rhs) {
-  if (this == &rhs) { return *this; }
-  coord_ = rhs.coord_;
-  return *this;
-}
-
-template<int D, typename T>
-Point<D,T>& Point<D,T>::operator=(Point<D,T> &&rhs) noexcept {
-  if (this == &rhs) { return *this; }
-  coord_ = std::move(rhs.coord_);
-  return *this;
+Point<D,T>::Point(const std::initializer_list<T> &li) : coord_() {
+  reset(li);
 }
 
 template<int D, typename T>
@@ -213,7 +193,7 @@ std::ostream& operator<<(std::ostream &os, const Point<D, T> &p) {
 
 template <int D, typename T>
 inline const T& Point<D,T>::operator[](int i) const {
-  return coord_.at(i);
+  return coord_[i];
 }
 
 template <int D, typename T>
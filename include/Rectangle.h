@@ -2,7 +2,6 @@
 #define BBRCITKDE_RECTANGLE_H__
 
 #include <cmath>
-#include <vector>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -44,13 +43,15 @@ class Rectangle {
 
     Rectangle();
     Rectangle(const Point<D,T>&, const Point<D,T>&);
-    Rectangle(const Rectangle<D,T>&);
-    Rectangle(Rectangle<D,T>&&) noexcept;
-    Rectangle& operator=(const Rectangle<D,T>&);
-    Rectangle& operator=(Rectangle<D,T>&&) noexcept;
-    ~Rectangle();
 
-    // index access to edge intervals. 
+    // copy-control. these are all trivial; Rectangle<>'s are safe to memcpy. 
+    Rectangle(const Rectangle<D,T>&) = default;
+    Rectangle(Rectangle<D,T>&&) noexcept = default;
+    Rectangle& operator=(const Rectangle<D,T>&) = default;
+    Rectangle& operator=(Rectangle<D,T>&&) noexcept = default;
+    ~Rectangle() = default;
+
+    // index access to edge intervals. no bounds checking is performed. 
     const EdgeType& operator[](int) const;
     EdgeType& operator[](int);
 
@@ -82,9 +83,9 @@ class Rectangle {
 
   private:
 
-    // Rectangle<D,T>'s are represented as a list of pair<T,T>'s of length D.
-    // each pair<> represents the closed interval [lower, upper], where upper >= lower. 
-    std::vector<EdgeType> intervals_;
+    // Rectangle<D,T>'s are represented as an inline array of Interval<>'s of length D.
+    // each Interval<> represents the closed interval [lower, upper], where upper >= lower. 
+    EdgeType intervals_[D];
 };
 
 // Implementations
@@ -128,37 +129,11 @@ void swap(Rectangle<D,T> &lhs, Rectangle<D,T> &rhs) {
 }
 
 template <int D, typename T>
-Rectangle<D,T>::Rectangle() : intervals_(D, EdgeType(T(), T()) ) {}
-
-template <int D, typename T>
-Rectangle<D,T>::~Rectangle() {}
+Rectangle<D,T>::Rectangle() {}
 
 template <int D, typename T>
 Rectangle<D,T>::Rectangle(const Point<D,T> &p1, const Point<D,T> &p2) {
-  for (int i = 0; i < D; ++i) { 
-    auto p = std::minmax(p1[i], p2[i]);
-    intervals_.emplace_back(p.first, p.second); 
-  }
-}
-
-template <int D, typename T>
-Rectangle<D,T>::Rectangle(const Rectangle &r) : intervals_(r.intervals_) {}
-
-template <int D, typename T>
-Rectangle<D,T>::Rectangle(Rectangle &&r) noexcept : intervals_(std::move(r.intervals_)) {}
-
-template <int D, typename T>
-Rectangle<D,T>& Rectangle<D,T>::operator=(const Rectangle &r) {
-  if (this == &r) { return *this; }
-  intervals_ = r.intervals_;
-  return *this;
-}
-
-template <int D, typename T>
-Rectangle<D,T>& Rectangle<D,T>::operator=(Rectangle &&r) noexcept {
-  if (this == &r) { return *this; }
-  intervals_ = std::move(r.intervals_);
-  return *this;
+  resize(p1, p2);
 }
 
 template <int D, typename T>
@@ -243,7 +218,7 @@ std::ostream& operator<<(std::ostream &os, const Rectangle<D,T> &r) {
 
 template <int D, typename T>
 inline const typename Rectangle<D,T>::EdgeType& 
-Rectangle<D,T>::operator[](int i) const { return intervals_.at(i); }
+Rectangle<D,T>::operator[](int i) const { return intervals_[i]; }
 
 template <int D, typename T>
 inline typename Rectangle<D,T>::EdgeType& 
@@ -0,0 +1,97 @@
+#ifndef BBRCITKDE_SPACEFILLINGCURVE_H__
+#define BBRCITKDE_SPACEFILLINGCURVE_H__
+
+#include <cstdint>
+#include <algorithm>
+
+// API
+// ---
+
+namespace bbrcit {
+
+// returns the number of bits per dimension that curve keys in D dimensions
+// resolve: as many as fit into 64 bits, and at most 32.
+template<int D>
+constexpr int curve_key_bits() { return D >= 64 ? 1 : (64/D > 32 ? 32 : 64/D); }
+
+// maps x in [lo, hi] to an integer grid coordinate in [0, 2^bits).
+// degenerate intervals map to 0.
+template<typename T>
+std::uint32_t curve_grid_coordinate(const T &x, const T &lo, const T &hi, int bits);
+
+// returns the position along the Morton (Z-order) curve of the grid cell
+// with coordinates `x`, each of which has `curve_key_bits<D>()` bits.
+// interleaves the bits of the coordinates, most significant first.
+template<int D>
+std::uint64_t morton_key(const std::uint32_t (&x)[D]);
+
+// returns the position along the Hilbert curve of the grid cell with
+// coordinates `x`, each of which has `curve_key_bits<D>()` bits. unlike
+// the Morton curve, consecutive cells along the Hilbert curve are always
+// adjacent. `x` is overwritten.
+//
+// based on ''Programming the Hilbert curve'' by J. Skilling.
+template<int D>
+std::uint64_t hilbert_key(std::uint32_t (&x)[D]);
+
+// Implementations
+// ---------------
+
+template<typename T>
+inline std::uint32_t curve_grid_coordinate(const T &x, const T &lo, const T &hi, int bits) {
+  if (!(hi > lo)) { return 0; }
+  double n_cells = static_cast<double>(std::uint64_t(1) << bits);
+  double c = (x - lo) / (hi - lo) * n_cells;
+  return static_cast<std::uint32_t>(std::min(std::max(c, 0.0), n_cells - 1));
+}
+
+template<int D>
+std::uint64_t morton_key(const std::uint32_t (&x)[D]) {
+
+  const int bits = curve_key_bits<D>();
+
+  // in dimensions above 64, only the leading 64 bits of the interleaving
+  // are kept.
+  std::uint64_t key = 0; int n = 0;
+  for (int b = bits-1; b >= 0 && n < 64; --b) {
+    for (int i = 0; i < D && n < 64; ++i, ++n) {
+      key = (key << 1) | ((x[i] >> b) & 1u);
+    }
+  }
+  return key;
+}
+
+template<int D>
+std::uint64_t hilbert_key(std::uint32_t (&x)[D]) {
+
+  const int bits = curve_key_bits<D>();
+
+  // inverse undo: converts the coordinates into the transposed Hilbert
+  // index in place.
+  for (std::uint32_t q = std::uint32_t(1) << (bits-1); q > 1; q >>= 1) {
+    std::uint32_t p = q - 1;
+    for (int i = 0; i < D; ++i) {
+      if (x[i] & q) {
+        x[0] ^= p;
+      } else {
+        std::uint32_t t = (x[0] ^ x[i]) & p;
+        x[0] ^= t; x[i] ^= t;
+      }
+    }
+  }
+
+  // gray encode.
+  for (int i = 1; i < D; ++i) { x[i] ^= x[i-1]; }
+  std::uint32_t t = 0;
+  for (std::uint32_t q = std::uint32_t(1) << (bits-1); q > 1; q >>= 1) {
+    if (x[D-1] & q) { t ^= q - 1; }
+  }
+  for (int i = 0; i < D; ++i) { x[i] ^= t; }
+
+  // the transposed index interleaves like a Morton key.
+  return morton_key<D>(x);
+}
+
+}
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef BBRCITKDE_THREADPOOL_H__
+#define BBRCITKDE_THREADPOOL_H__
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <cstddef>
+
+namespace bbrcit {
+
+// ThreadPool implements a fork-join pool of persistent worker threads.
+//
+// + Every worker owns a deque of tasks. Tasks forked by a worker are pushed
+//   to the back of its own deque and popped back LIFO, while idle workers
+//   steal from the front of the other deques (work stealing). Tasks forked
+//   by threads outside the pool go to a shared injection deque.
+//
+// + A thread waiting for a forked task that was stolen does not block; it
+//   helps by stealing and running other tasks. Nested fork_join()'s are
+//   therefore safe at any depth.
+//
+// + size() counts the calling thread as a participant: ThreadPool(n) spawns
+//   n-1 workers. ThreadPool(1) runs everything on the calling thread.
+class ThreadPool {
+
+  public:
+
+    // construct a pool with `n_threads` participants. values less than 1
+    // select std::thread::hardware_concurrency().
+    explicit ThreadPool(int n_threads=1);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // returns the number of threads that participate in the computations,
+    // including the calling thread.
+    int size() const;
+
+    // runs `f1` and `f2`, possibly in parallel, and returns when both have
+    // completed. exceptions thrown by either are rethrown here.
+    template<typename F1, typename F2>
+      void fork_join(F1 &&f1, F2 &&f2);
+
+    // calls `f(b, e)` on disjoint subranges [b, e) that cover [begin, end).
+    // each subrange has at most `grain` elements.
+    template<typename F>
+      void parallel_for(size_t begin, size_t end, size_t grain, F f);
+
+  private:
+
+    struct Task {
+      std::function<void()> fn;
+      std::atomic<bool> done;
+      std::exception_ptr error;
+      Task() : done(false) {}
+    };
+
+    struct TaskQueue {
+      std::mutex m;
+      std::deque<Task*> tasks;
+    };
+
+    // identifies the pool and the deque owned by the current thread.
+    struct Identity {
+      const ThreadPool *pool;
+      int index;
+    };
+    static Identity& identity();
+
+    int own_queue() const;
+    void push(Task*);
+    bool unpush(Task*);
+    Task* steal(int);
+    void run(Task*);
+    void wait(Task*);
+    void worker_loop(int);
+
+    // queues_[i] is owned by worker i. the last element is the
+    // injection deque for threads outside of the pool.
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex sleep_m_;
+    std::condition_variable sleep_cv_;
+    std::atomic<int> n_queued_;
+    std::atomic<int> n_sleeping_;
+    std::atomic<bool> stop_;
+};
+
+// Implementations
+// ---------------
+
+inline ThreadPool::Identity& ThreadPool::identity() {
+  static thread_local Identity id = { nullptr, -1 };
+  return id;
+}
+
+inline ThreadPool::ThreadPool(int n_threads)
+  : n_queued_(0), n_sleeping_(0), stop_(false) {
+
+  if (n_threads < 1) {
+    n_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+
+  for (int i = 0; i < n_threads; ++i) {
+    queues_.emplace_back(new TaskQueue());
+  }
+
+  for (int i = 0; i < n_threads-1; ++i) {
+    workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+  }
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lk(sleep_m_);
+    stop_ = true;
+  }
+  sleep_cv_.notify_all();
+  for (auto &w : workers_) { w.join(); }
+}
+
+inline int ThreadPool::size() const { return workers_.size() + 1; }
+
+inline int ThreadPool::own_queue() const {
+  const Identity &id = identity();
+  return id.pool == this ? id.index : queues_.size()-1;
+}
+
+inline void ThreadPool::push(Task *t) {
+  TaskQueue &q = *queues_[own_queue()];
+  {
+    std::lock_guard<std::mutex> lk(q.m);
+    q.tasks.push_back(t);
+  }
+  ++n_queued_;
+  if (n_sleeping_ > 0) {
+    std::lock_guard<std::mutex> lk(sleep_m_);
+    sleep_cv_.notify_one();
+  }
+}
+
+// take `t` back if nobody has stolen it yet.
+inline bool ThreadPool::unpush(Task *t) {
+  TaskQueue &q = *queues_[own_queue()];
+  std::lock_guard<std::mutex> lk(q.m);
+  if (q.tasks.empty() || q.tasks.back() != t) { return false; }
+  q.tasks.pop_back();
+  --n_queued_;
+  return true;
+}
+
+// take the oldest task from any deque other than queues_[self].
+inline ThreadPool::Task* ThreadPool::steal(int self) {
+  int n = queues_.size();
+  for (int k = 1; k <= n; ++k) {
+    int i = (self + k) % n;
+    if (i == self) { continue; }
+    TaskQueue &q = *queues_[i];
+    std::lock_guard<std::mutex> lk(q.m);
+    if (!q.tasks.empty()) {
+      Task *t = q.tasks.front(); q.tasks.pop_front();
+      --n_queued_;
+      return t;
+    }
+  }
+  return nullptr;
+}
+
+inline void ThreadPool::run(Task *t) {
+  try { t->fn(); } catch (...) { t->error = std::current_exception(); }
+  t->done.store(true, std::memory_order_release);
+}
+
+// help with other work until `t` completes.
+inline void ThreadPool::wait(Task *t) {
+  int self = own_queue();
+  while (!t->done.load(std::memory_order_acquire)) {
+    Task *other = steal(self);
+    if (other) { run(other); } else { std::this_thread::yield(); }
+  }
+}
+
+inline void ThreadPool::worker_loop(int index) {
+
+  identity() = { this, index };
+  TaskQueue &own = *queues_[index];
+
+  while (true) {
+
+    Task *t = nullptr;
+    {
+      std::lock_guard<std::mutex> lk(own.m);
+      if (!own.tasks.empty()) {
+        t = own.tasks.back(); own.tasks.pop_back(); --n_queued_;
+      }
+    }
+    if (t == nullptr) { t = steal(index); }
+    if (t != nullptr) { run(t); continue; }
+
+    // nothing to do: sleep until new work arrives. no wakeup is lost: 
+    // push() counts the task in n_queued_ before it reads n_sleeping_, and 
+    // a sleeper counts itself in n_sleeping_ before its predicate reads 
+    // n_queued_. either push() sees the sleeper and notifies under 
+    // sleep_m_, or the sleeper sees the task and does not block. 
+    std::unique_lock<std::mutex> lk(sleep_m_);
+    if (stop_) { return; }
+    ++n_sleeping_;
+    sleep_cv_.wait(lk, [this] { return stop_ || n_queued_ > 0; });
+    --n_sleeping_;
+    if (stop_ && n_queued_ == 0) { return; }
+  }
+}
+
+template<typename F1, typename F2>
+void ThreadPool::fork_join(F1 &&f1, F2 &&f2) {
+
+  if (workers_.empty()) { f1(); f2(); return; }
+
+  // fork f1 so that an idle thread may steal it, and run f2 ourselves.
+  Task t; t.fn = std::forward<F1>(f1);
+  push(&t);
+
+  std::exception_ptr f2_error;
+  try { f2(); } catch (...) { f2_error = std::current_exception(); }
+
+  // join: run f1 here if it was not stolen, otherwise help until it is done.
+  if (unpush(&t)) { run(&t); } else { wait(&t); }
+
+  if (t.error) { std::rethrow_exception(t.error); }
+  if (f2_error) { std::rethrow_exception(f2_error); }
+}
+
+template<typename F>
+void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain, F f) {
+  if (begin >= end) { return; }
+  if (grain < 1) { grain = 1; }
+  if (end - begin <= grain || workers_.empty()) {
+    for (size_t b = begin; b < end; b += grain) { f(b, std::min(b+grain, end)); }
+    return;
+  }
+  size_t mid = begin + (end - begin) / 2;
+  fork_join([&] { parallel_for(begin, mid, grain, f); },
+            [&] { parallel_for(mid, end, grain, f); });
+}
+
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef BBRCITKDE_KDTREETESTUTILS_H__
+#define BBRCITKDE_KDTREETESTUTILS_H__
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include <FloatUtils.h>
+
+// returns the leaf index ranges of `tr` in sorted order.
+template <typename KdtreeT>
+std::vector<std::pair<size_t,size_t>> sorted_leaves(const KdtreeT &tr) {
+  std::vector<std::pair<size_t,size_t>> leaves;
+  tr.report_leaves(leaves);
+  std::sort(leaves.begin(), leaves.end());
+  return leaves;
+}
+
+// returns the range search result of `tr` in lexicographic order.
+template <typename KdtreeT>
+std::vector<typename KdtreeT::DataPointType>
+sorted_range_search(const KdtreeT &tr, const typename KdtreeT::RectangleType &q) {
+  using DataPointType = typename KdtreeT::DataPointType;
+  std::vector<DataPointType> result;
+  tr.range_search(q, result);
+  std::sort(result.begin(), result.end(), bbrcit::ExactLexicoLess<DataPointType>);
+  return result;
+}
+
+// returns a copy of the points of `tr` in lexicographic order.
+template <typename KdtreeT>
+std::vector<typename KdtreeT::DataPointType> sorted_points(const KdtreeT &tr) {
+  using DataPointType = typename KdtreeT::DataPointType;
+  std::vector<DataPointType> result(tr.points());
+  std::sort(result.begin(), result.end(), bbrcit::ExactLexicoLess<DataPointType>);
+  return result;
+}
+
+// true if the coordinates and weights of the two lists agree.
+template <typename PointT>
+bool same_points(const std::vector<PointT> &lhs, const std::vector<PointT> &rhs) {
+  if (lhs.size() != rhs.size()) { return false; }
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    if (!bbrcit::ExactEqual(lhs[i], rhs[i])) { return false; }
+    if (lhs[i].attributes().weight() != rhs[i].attributes().weight()) { return false; }
+  }
+  return true;
+}
+
+#endif
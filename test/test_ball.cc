@@ -0,0 +1,107 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <Ball.h>
+#include <Rectangle.h>
+#include <Point.h>
+#include <Kdtree.h>
+
+using namespace std;
+using bbrcit::Point;
+using bbrcit::Ball;
+using bbrcit::Rectangle;
+
+using BallTree2d = bbrcit::BallTree<2>;
+using DataPointType = typename BallTree2d::DataPointType;
+
+int main() {
+
+  cout << endl;
+
+  // test: constructors and accessors
+  Ball<2> b0;
+  cout << "+ Default constructor: " << b0 << " (cf. { (0, 0), 0 }) " << endl;
+  Ball<2> b1({1.0, 2.0}, 3.0);
+  cout << "+ Two argument constructor: " << b1 << " (cf. { (1, 2), 3 }) " << endl;
+  cout << "+ operator[]: " << "{ " << b1[0] << ", " << b1[1] << " }" << " (cf. { (-2, 4), (-1, 5) }) " << endl;
+  cout << endl;
+
+  // test: contains()
+  Point<2> p0 = {1.0, 5.0}, p1 = {4.0, 5.0};
+  cout << "+ contains() (1): " << b1.contains(p0) << " (cf. 1) " << endl;
+  cout << "+ contains() (2): " << b1.contains(p1) << " (cf. 0) " << endl;
+  cout << endl;
+
+  // test: distances to points
+  Ball<2> b2({0.0, 0.0}, 1.0);
+  Point<2> p2 = {3.0, 4.0}, p3 = {0.5, 0.0};
+  cout << "+ min_dist(Point) (1): " << b2.min_dist(p2) << " (cf. 4) " << endl;
+  cout << "+ min_dist(Point) (2): " << b2.min_dist(p3) << " (cf. 0) " << endl;
+  cout << "+ max_dist(Point): " << b2.max_dist(p2) << " (cf. 6) " << endl;
+  cout << endl;
+
+  // test: distances to balls and rectangles
+  Ball<2> b3({6.0, 8.0}, 2.0);
+  cout << "+ min_dist(Ball) (1): " << b2.min_dist(b3) << " (cf. 7) " << endl;
+  cout << "+ min_dist(Ball) (2): " << b2.min_dist(b2) << " (cf. 0) " << endl;
+  cout << "+ max_dist(Ball): " << b2.max_dist(b3) << " (cf. 13) " << endl;
+
+  Rectangle<2> r0({3.0, -1.0}, {5.0, 1.0});
+  cout << "+ min_dist(Rectangle): " << b2.min_dist(r0) << " (cf. 2) " << endl;
+  cout << "+ max_dist(Rectangle): " << b2.max_dist(r0) << " (cf. 6.09902) " << endl;
+  cout << endl;
+
+  // test: per dimension distances
+  cout << "+ min_dist(i, Point): " << b2.min_dist(0, p2) << " " << b2.min_dist(1, p2) << " (cf. 2 3) " << endl;
+  cout << "+ max_dist(i, Point): " << b2.max_dist(0, p2) << " " << b2.max_dist(1, p2) << " (cf. 4 5) " << endl;
+  cout << "+ min_dist(i, Ball): " << b2.min_dist(0, b3) << " " << b2.min_dist(1, b3) << " (cf. 3 5) " << endl;
+  cout << "+ Rectangle::min_dist(i, Ball): " << r0.min_dist(0, b2) << " (cf. 2) " << endl;
+  cout << "+ Rectangle::contains(Ball): " << r0.contains(Ball<2>({4.0, 0.0}, 1.0)) << " "
+       << r0.contains(Ball<2>({4.0, 0.0}, 1.5)) << " (cf. 1 0) " << endl;
+  cout << endl;
+
+  // test: BallTree<>
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  vector<DataPointType> data;
+  for (int i = 0; i < 20000; ++i) { data.push_back({{g(e), g(e)}}); }
+
+  bbrcit::KdtreeOptions options;
+  options.leaf_nmax = 16;
+  options.split = bbrcit::KdtreeSplit::MaxSpread;
+  BallTree2d tree(data, options);
+
+  // every ball at every depth contains the points under it.
+  bool bounds_ok = true;
+  for (int depth = 0; depth < 8; ++depth) {
+    vector<Ball<2>> balls;
+    tree.report_partitions(depth, balls);
+    size_t covered = 0;
+    for (const auto &b : balls) {
+      for (const auto &p : tree.points()) { covered += b.contains(p); }
+    }
+    bounds_ok = bounds_ok && covered >= tree.size();
+  }
+  vector<Ball<2>> leaves;
+  tree.report_partitions(1000, leaves);
+  vector<pair<size_t,size_t>> leaf_ranges;
+  tree.report_leaves(leaf_ranges);
+  for (size_t k = 0; k < leaves.size(); ++k) {
+    for (size_t i = leaf_ranges[k].first; i <= leaf_ranges[k].second; ++i) {
+      bounds_ok = bounds_ok && leaves[k].contains(tree.points()[i]);
+    }
+  }
+  cout << "+ BallTree<> leaf bounds: " << bounds_ok << " (cf. 1) " << endl;
+
+  Rectangle<2> query({-0.5, -0.2}, {0.7, 1.1});
+  vector<DataPointType> result;
+  tree.range_search(query, result);
+  size_t brute = count_if(tree.points().begin(), tree.points().end(),
+                          [&] (const DataPointType &p) { return query.contains(p); });
+  cout << "+ BallTree<> range search: " << result.size() << " (cf. " << brute << ") " << endl;
+  cout << endl;
+
+  return 0;
+}
@@ -0,0 +1,176 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <stdexcept>
+
+#include <DecoratedPoint.h>
+#include <Attributes/AdaKdeAttributes.h>
+#include <Kernels/GaussianKernel.h>
+#include <Kernels/EpanechnikovKernel.h>
+#include <CpuDirectKde.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+  using FloatType = double;
+  using HostPointType = bbrcit::DecoratedPoint<2, bbrcit::AdaKdeAttributes<FloatType>, FloatType>;
+  using KernelType = bbrcit::GaussianKernel<2,FloatType>;
+  using CpuDirectKdeType = bbrcit::CpuDirectKde<2,FloatType,KernelType>;
+}
+
+// returns the unnormalized contributions of refs[r_i..r_j] at each of
+// queries[q_i..q_j] through the naive double loop.
+template<typename KernT>
+vector<FloatType> naive_eval(const KernT &kernel, const vector<HostPointType> &refs,
+                             const vector<HostPointType> &queries,
+                             size_t r_i, size_t r_j, size_t q_i, size_t q_j) {
+  vector<FloatType> results;
+  for (size_t q = q_i; q <= q_j; ++q) {
+    FloatType sum = 0.0;
+    for (size_t r = r_i; r <= r_j; ++r) {
+      sum += refs[r].attributes().mass() *
+             kernel.unnormalized_eval(queries[q].point(), refs[r].point(), refs[r].attributes().abw());
+    }
+    results.push_back(sum);
+  }
+  return results;
+}
+
+bool within(const vector<FloatType> &actual, const vector<FloatType> &expected, FloatType tol) {
+  bool ok = actual.size() >= expected.size();
+  for (size_t i = 0; ok && i < expected.size(); ++i) {
+    ok = abs(actual[i] - expected[i]) <= tol * expected[i] + 1e-300;
+  }
+  return ok;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  uniform_real_distribution<> u(0.5, 2.0);
+
+  vector<HostPointType> refs, queries;
+  for (int i = 0; i < 10000; ++i) {
+    refs.push_back({{g(e), g(e)}});
+    refs.back().attributes().set_mass(u(e));
+    FloatType abw = u(e);
+    refs.back().attributes().set_lower_abw(abw);
+    refs.back().attributes().set_upper_abw(abw);
+  }
+  for (int i = 0; i < 2000; ++i) { queries.push_back({{g(e), g(e)}}); }
+
+  CpuDirectKdeType cpu_kde(refs, queries);
+  cpu_kde.kernel().set_bandwidth(0.2);
+  cout << "+ reference and query sizes: " << cpu_kde.reference_size() << " " << cpu_kde.query_size()
+       << " (c.f. " << refs.size() << " " << queries.size() << ")" << endl;
+
+  // test: index ranges that end inside and across reference tiles, and
+  // query ranges shorter and longer than a block.
+  vector<FloatType> results;
+  bool ranges_ok = true;
+  size_t ranges[][4] = { {0, 9999, 0, 1999}, {17, 4112, 3, 3}, {4095, 8200, 100, 1500}, {5, 5, 0, 127} };
+  for (const auto &r : ranges) {
+    cpu_kde.unnormalized_eval(r[0], r[1], r[2], r[3], results, 100);
+    ranges_ok = ranges_ok && within(results, naive_eval(cpu_kde.kernel(), refs, queries, r[0], r[1], r[2], r[3]), 1e-12);
+  }
+  cout << "+ unnormalized_eval() over index ranges: " << ranges_ok << " (c.f. 1)" << endl;
+
+  vector<FloatType> expected = naive_eval(cpu_kde.kernel(), refs, queries, 0, 9999, 0, 1999);
+  for (auto &v : expected) { v *= cpu_kde.kernel().normalization(); }
+  cpu_kde.eval(0, 9999, 0, 1999, results);
+  cout << "+ eval(): " << within(results, expected, 1e-12) << " (c.f. 1)" << endl;
+
+  // test: a compact kernel.
+  bbrcit::CpuDirectKde<2,FloatType,bbrcit::EpanechnikovKernel<2,FloatType>> epan_kde(refs, queries);
+  epan_kde.kernel().set_bandwidth(0.5);
+  epan_kde.unnormalized_eval(0, 9999, 0, 1999, results);
+  cout << "+ epanechnikov kernel: "
+       << within(results, naive_eval(epan_kde.kernel(), refs, queries, 0, 9999, 0, 1999), 1e-12)
+       << " (c.f. 1)" << endl;
+
+  // test: results do not depend on the number of threads; copies evaluate
+  // the same way.
+  vector<FloatType> single_results, threaded_results;
+  cpu_kde.eval(0, 9999, 0, 1999, single_results, 64);
+  CpuDirectKdeType threaded_kde(refs, queries, 4);
+  threaded_kde.kernel() = cpu_kde.kernel();
+  threaded_kde.eval(0, 9999, 0, 1999, threaded_results, 64);
+  CpuDirectKdeType copied_kde(threaded_kde);
+  vector<FloatType> copied_results;
+  copied_kde.eval(0, 9999, 0, 1999, copied_results, 64);
+  cout << "+ 4 threads: " << threaded_kde.n_threads() << " threads, same results "
+       << (threaded_results == single_results)
+       << " " << (copied_results == threaded_results) << " (c.f. 4 threads, same results 1 1)" << endl;
+
+  // test: a view over the reference points as a structure-of-arrays,
+  // evaluated at explicit queries on shared threads.
+  vector<FloatType> xs, ys, masses, abws;
+  for (const auto &r : refs) {
+    xs.push_back(r[0]); ys.push_back(r[1]);
+    masses.push_back(r.attributes().mass()); abws.push_back(r.attributes().abw());
+  }
+  const FloatType *coords[2] = { xs.data(), ys.data() };
+  vector<bbrcit::Point<2,FloatType>> query_points;
+  for (const auto &q : queries) { query_points.push_back(q.point()); }
+  CpuDirectKdeType view_kde(coords, masses.data(), abws.data(), refs.size(),
+                            std::make_shared<bbrcit::ThreadPool>(4));
+  view_kde.kernel() = cpu_kde.kernel();
+  CpuDirectKdeType view_copy = view_kde;
+  vector<FloatType> view_results(query_points.size()), view_copy_results(query_points.size());
+  view_kde.eval(0, 9999, query_points.data(), query_points.size(), view_results.data(), 64);
+  view_copy.eval(0, 9999, query_points.data(), query_points.size(), view_copy_results.data());
+  cout << "+ view: " << view_kde.reference_size() << " reference points, " << view_copy.n_threads()
+       << " threads, same results " << (view_results == single_results) << " "
+       << (view_copy_results == single_results)
+       << " (c.f. 10000 reference points, 4 threads, same results 1 1)" << endl;
+
+  // test: invalid ranges are rejected.
+  int caught = 0;
+  try { cpu_kde.eval(0, 10000, 0, 10, results); } catch (std::out_of_range&) { ++caught; }
+  try { cpu_kde.eval(10, 5, 0, 10, results); } catch (std::invalid_argument&) { ++caught; }
+  cout << "+ invalid ranges: " << caught << " (c.f. 2)" << endl;
+
+  // test: KernelDensity<>::direct_eval() through CpuDirectKde<>, against
+  // direct evaluation one query at a time.
+  using KernelDensityType = bbrcit::KernelDensity<2,KernelType,FloatType>;
+  using DataPointType = typename KernelDensityType::DataPointType;
+  vector<DataPointType> data, kde_queries;
+  for (int i = 0; i < 200000; ++i) { data.push_back({{g(e), g(e)}}); }
+  for (int i = 0; i < 1000; ++i) { kde_queries.push_back({{g(e), g(e)}}); }
+
+  for (int n_threads : {1, 4}) {
+    bbrcit::KdtreeOptions options; options.leaf_nmax = 32; options.n_threads = n_threads;
+    KernelDensityType kde(data, options);
+    kde.kernel().set_bandwidth(0.1);
+    auto batched = kde_queries, single = kde_queries;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto &q : single) { kde.direct_eval(q); }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> single_elapsed = end - start;
+
+    start = std::chrono::high_resolution_clock::now();
+    kde.direct_eval(batched);
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> batched_elapsed = end - start;
+
+    bool same = true;
+    for (size_t i = 0; i < batched.size(); ++i) {
+      FloatType v = batched[i].attributes().value(), w = single[i].attributes().value();
+      same = same && abs(v - w) <= 1e-12 * w;
+    }
+    cout << "+ direct_eval(), " << data.size() << " points at " << batched.size() << " queries, "
+         << n_threads << " thread(s): " << batched_elapsed.count() << " ms "
+         << "(c.f. " << single_elapsed.count() << " ms one query at a time). " << endl;
+    cout << "  same values: " << same << " (c.f. 1)" << endl;
+  }
+  cout << endl;
+
+  return 0;
+}
@@ -0,0 +1,110 @@
+#define _USE_MATH_DEFINES
+
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <Kernels/EpanechnikovKernel.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+
+  using FloatType = double;
+  using KFloatType = float;
+
+  // EpanechnikovKernel<> that counts its evaluations. the tree algorithms 
+  // evaluate the kernel once per point pair in the base cases and twice per 
+  // node pair to bound contributions, so fewer evaluations mean more pruning. 
+  class CountingKernel : public bbrcit::EpanechnikovKernel<2, KFloatType> {
+    public:
+      template<typename PointT>
+      KFloatType unnormalized_eval(const PointT &p, const PointT &q, KFloatType a) const {
+        ++n_evals;
+        return bbrcit::EpanechnikovKernel<2, KFloatType>::unnormalized_eval(p, q, a);
+      }
+      static size_t n_evals;
+  };
+  size_t CountingKernel::n_evals = 0;
+
+  using KernelDensityType = bbrcit::KernelDensity<2, CountingKernel, FloatType>;
+  using DataPointType = typename KernelDensityType::DataPointType;
+  using KdtreeType = typename KernelDensityType::KdtreeType;
+  using bbrcit::KdtreeOptions;
+  using bbrcit::KdtreeSplit;
+}
+
+// evaluates the density at every reference point with trees built using 
+// `options`, and reports the kernel evaluations and the cpu time. returns 
+// the results in lexicographic order of the points. 
+vector<DataPointType> run(const string &name, const vector<DataPointType> &data, 
+                          const KdtreeOptions &options, double rel_err, double abs_err) {
+
+  KernelDensityType kde(data, options);
+  kde.kernel().set_bandwidth(0.1);
+  KdtreeType query_tree(data, options);
+
+  CountingKernel::n_evals = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  kde.eval(query_tree, rel_err, abs_err);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+
+  cout << "  " << name << ": " << CountingKernel::n_evals << " kernel evaluations, " 
+       << elapsed.count() << " ms. " << endl;
+
+  vector<DataPointType> result(query_tree.points());
+  sort(result.begin(), result.end(), bbrcit::ExactLexicoLess<DataPointType>);
+  return result;
+}
+
+int main() {
+
+  // the test_kde11 workload at 2^17 points. 
+  mt19937 e;
+  normal_distribution<FloatType> d(0, 1);
+
+  vector<DataPointType> data;
+  for (size_t i = 0; i < (2 << 16); ++i) { data.push_back({{d(e), d(e)}}); }
+
+  double rel_err = 1e-6, abs_err = 1e-10;
+
+  cout << endl;
+  cout << "+ dual tree evaluation of " << data.size() << " points: " << endl;
+
+  KdtreeOptions options; options.leaf_nmax = 32;
+  vector<DataPointType> reference = run("round robin, cells", data, options, rel_err, abs_err);
+
+  vector<vector<DataPointType>> results;
+  options.tight_bbox = true;
+  results.push_back(run("round robin, tight", data, options, rel_err, abs_err));
+
+  options.split = KdtreeSplit::MaxSpread; options.tight_bbox = false;
+  results.push_back(run("max spread, cells", data, options, rel_err, abs_err));
+  options.tight_bbox = true;
+  results.push_back(run("max spread, tight", data, options, rel_err, abs_err));
+
+  options.split = KdtreeSplit::SlidingMidpoint; options.tight_bbox = false;
+  results.push_back(run("sliding midpoint, cells", data, options, rel_err, abs_err));
+  options.tight_bbox = true;
+  results.push_back(run("sliding midpoint, tight", data, options, rel_err, abs_err));
+  cout << endl;
+
+  // test: every configuration agrees with the default one to within the tolerance
+  bool all_ok = true;
+  for (const auto &r : results) {
+    for (size_t i = 0; i < r.size(); ++i) {
+      double lhs = r[i].attributes().value(), rhs = reference[i].attributes().value();
+      all_ok = all_ok && std::abs(lhs - rhs) <= 2 * (rel_err * std::abs(rhs) + abs_err);
+    }
+  }
+  cout << "+ results within tolerance: " << all_ok << " (c.f. 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
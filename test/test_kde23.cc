@@ -0,0 +1,178 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <Kernels/EpanechnikovKernel.h>
+#include <Kernels/GaussianKernel.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+  using FloatType = double;
+  using KernelDensityType = bbrcit::KernelDensity<2, bbrcit::EpanechnikovKernel<2,FloatType>, FloatType>;
+  using DataPointType = typename KernelDensityType::DataPointType;
+  using GaussKernelDensityType = bbrcit::KernelDensity<2, bbrcit::GaussianKernel<2,FloatType>, FloatType>;
+}
+
+// largest relative difference between single tree and direct evaluations
+// at `queries`. stale node attributes show up as large differences.
+double max_rel_diff(const KernelDensityType &kde, const vector<DataPointType> &queries) {
+  double result = 0.0;
+  for (auto q : queries) {
+    double exact = kde.direct_eval(q);
+    double approx = kde.eval(q, 1e-6, 1e-12);
+    if (exact > 0) { result = max(result, abs(approx - exact) / exact); }
+  }
+  return result;
+}
+
+double weight_sum(const KernelDensityType &kde) {
+  double result = 0.0;
+  for (const auto &p : kde.points()) { result += p.attributes().weight(); }
+  return result;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  uniform_real_distribution<> u(0.5, 2.0);
+
+  vector<DataPointType> data;
+  for (int i = 0; i < 200000; ++i) { data.push_back({{g(e), g(e)}}); }
+
+  vector<DataPointType> queries;
+  for (int i = 0; i < 100; ++i) { queries.push_back({{g(e), g(e)}}); }
+
+  KernelDensityType kde(data, 32);
+  kde.kernel().set_bandwidth(0.2);
+
+  size_t n = kde.size();
+  uniform_int_distribution<size_t> idx(0, n-1);
+
+  // test: weight updates that preserve the total. the result should match
+  // a density constructed from scratch with the same weights.
+  vector<size_t> indices; vector<FloatType> weights, abws;
+  for (int k = 0; k < 500; k += 2) {
+    size_t i = idx(e), j = idx(e);
+    FloatType wi = kde.points()[i].attributes().weight();
+    FloatType wj = kde.points()[j].attributes().weight();
+    if (i == j) { continue; }
+    indices.push_back(i); weights.push_back(wi + wj / 2); abws.push_back(1.0);
+    indices.push_back(j); weights.push_back(wj / 2); abws.push_back(1.0);
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+  kde.update_points(indices, weights, abws);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+  cout << "+ update_points() of " << indices.size() << " points: " << elapsed.count() << " ms. " << endl;
+
+  vector<DataPointType> reweighted(kde.points());
+  KernelDensityType ref(reweighted, 32);
+  ref.kernel().set_bandwidth(0.2);
+
+  double max_diff = 0.0;
+  for (auto q : queries) {
+    double lhs = kde.direct_eval(q), rhs = ref.direct_eval(q);
+    if (rhs > 0) { max_diff = max(max_diff, abs(lhs - rhs) / rhs); }
+  }
+  cout << "+ against rebuilt density: " << (max_diff < 1e-10) << " (c.f. 1)" << endl;
+  cout << "+ weight sum: " << weight_sum(kde) << " " << kde.weight_total() << " (c.f. 1 1)" << endl;
+  cout << "+ tree against direct evaluation: " << (max_rel_diff(kde, queries) < 1e-6) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  // test: local bandwidth updates and weights that change the total. node
+  // bounds on the updated paths must follow, otherwise pruning goes wrong. 
+  // the other weights are left alone, and evaluations scale by the total.
+  indices.clear(); weights.clear(); abws.clear();
+  for (int k = 0; k < 500; ++k) {
+    indices.push_back(idx(e));
+    weights.push_back(3.0 / n);
+    abws.push_back(u(e));
+  }
+  kde.update_points(indices, weights, abws);
+
+  double total = weight_sum(kde);
+  cout << "+ weight total follows the updates: " 
+       << (abs(kde.weight_total() - total) < 1e-9 * total) << " " << (total > 1) << " (c.f. 1 1)" << endl;
+  cout << "+ tree against direct evaluation: " << (max_rel_diff(kde, queries) < 1e-6) << " (c.f. 1)" << endl;
+
+  // a density rebuilt from the points normalizes their weights; it must agree. 
+  reweighted = kde.points();
+  KernelDensityType rescaled(reweighted, 32);
+  rescaled.kernel().set_bandwidth(0.2);
+
+  max_diff = 0.0;
+  for (auto q : queries) {
+    double lhs = kde.direct_eval(q), rhs = rescaled.direct_eval(q);
+    if (rhs > 0) { max_diff = max(max_diff, abs(lhs - rhs) / rhs); }
+  }
+  cout << "+ against rebuilt density: " << (max_diff < 1e-10) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  // test: cross validation and simulation after an update that doubles the 
+  // weight total. 
+  vector<DataPointType> sim_data(data.begin(), data.begin() + 1000);
+  GaussKernelDensityType sim_kde(sim_data, 8);
+  sim_kde.kernel().set_bandwidth(0.2);
+  size_t heavy = 123;
+  sim_kde.update_points({heavy}, {sim_kde.weight_total()}, {1.0});
+
+  vector<DataPointType> sim_reweighted(sim_kde.points());
+  GaussKernelDensityType sim_ref(sim_reweighted, 8);
+  sim_ref.kernel().set_bandwidth(0.2);
+  double lhs_cv = sim_kde.likelihood_cross_validate(1e-10, 1e-14);
+  double rhs_cv = sim_ref.likelihood_cross_validate(1e-10, 1e-14);
+  cout << "+ likelihood cross validation against rebuilt density: " 
+       << (abs(lhs_cv - rhs_cv) < 1e-8 * abs(rhs_cv)) << " (c.f. 1)" << endl;
+
+  // draws from a kernel this narrow land on their point. 
+  sim_kde.kernel().set_bandwidth(1e-6);
+
+  int n_heavy = 0, n_draws = 10000;
+  for (int k = 0; k < n_draws; ++k) {
+    DataPointType p = sim_kde.simulate(e);
+    if (abs(p[0] - sim_kde.points()[heavy][0]) < 1e-3 && 
+        abs(p[1] - sim_kde.points()[heavy][1]) < 1e-3) { ++n_heavy; }
+  }
+  cout << "+ share of draws from a point holding half the weight: " 
+       << (abs(double(n_heavy) / n_draws - 0.5) < 0.03) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  // test: cost of a small update against a full refresh.
+  indices.assign(1, idx(e)); weights.assign(1, 1.0 / n); abws.assign(1, 1.0);
+  start = std::chrono::high_resolution_clock::now();
+  for (int k = 0; k < 100; ++k) { kde.update_points(indices, weights, abws); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ 100 single point updates: " << elapsed.count() << " ms. " << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (int k = 0; k < 100; ++k) { kde.unadapt_density(); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ 100 full refreshes (unadapt_density()): " << elapsed.count() << " ms. " << endl;
+  cout << endl;
+
+  // test: argument checking.
+  bool caught = false;
+  try { kde.update_points({0, 1}, {0.0}, {1.0}); }
+  catch (std::invalid_argument&) { caught = true; }
+  cout << "+ length mismatch: " << caught << " (c.f. 1)" << endl;
+
+  caught = false;
+  try { kde.update_points({n}, {0.0}, {1.0}); }
+  catch (std::out_of_range&) { caught = true; }
+  cout << "+ index out of range: " << caught << " (c.f. 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include <Kernels/EpanechnikovKernel.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+  using FloatType = double;
+  using KernelType = bbrcit::EpanechnikovKernel<2,FloatType>;
+  using KernelDensityType = bbrcit::KernelDensity<2, KernelType, FloatType>;
+  using DataPointType = typename KernelDensityType::DataPointType;
+}
+
+// direct evaluation that reads the attributes of kde.points(). masses are 
+// relative to the weight total.
+FloatType points_eval(const KernelDensityType &kde, const DataPointType &q) {
+  FloatType total = 0.0;
+  for (const auto &p : kde.points()) {
+    total += p.attributes().mass() *
+             kde.kernel().unnormalized_eval(q.point(), p.point(), p.attributes().abw());
+  }
+  return total * kde.kernel().normalization() / kde.weight_total();
+}
+
+// largest relative difference between direct_eval(), which reads the
+// structure-of-arrays mirror, and points_eval().
+double max_rel_diff(const KernelDensityType &kde, const vector<DataPointType> &queries) {
+  double result = 0.0;
+  for (auto q : queries) {
+    double lhs = kde.direct_eval(q), rhs = points_eval(kde, q);
+    if (rhs > 0) { result = max(result, abs(lhs - rhs) / rhs); }
+  }
+  return result;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+
+  vector<DataPointType> data;
+  for (int i = 0; i < 100000; ++i) { data.push_back({{g(e), g(e)}}); }
+
+  vector<DataPointType> queries;
+  for (int i = 0; i < 200; ++i) { queries.push_back({{g(e), g(e)}}); }
+
+  // test: the mirror follows every operation that changes point attributes.
+  KernelDensityType kde(data, 32);
+  kde.kernel().set_bandwidth(0.2);
+  cout << "+ after construction: " << (max_rel_diff(kde, queries) < 1e-12) << " (c.f. 1)" << endl;
+
+  kde.adapt_density(0.5);
+  cout << "+ after adapt_density(): " << (max_rel_diff(kde, queries) < 1e-12) << " (c.f. 1)" << endl;
+
+  kde.update_points({0, 10, 100}, {3e-5, 1e-5, 2e-5}, {0.5, 1.5, 1.0});
+  cout << "+ after update_points(): " << (max_rel_diff(kde, queries) < 1e-12) << " (c.f. 1)" << endl;
+
+  KernelDensityType other(vector<DataPointType>(data.begin(), data.begin()+1000), 32);
+  other.kernel().set_bandwidth(0.2);
+  swap(kde, other);
+  cout << "+ after swap(): "
+       << (max_rel_diff(kde, queries) < 1e-12) << " "
+       << (max_rel_diff(other, queries) < 1e-12) << " (c.f. 1 1)" << endl;
+
+  KernelDensityType copy(other);
+  copy.unadapt_density();
+  cout << "+ after copy and unadapt_density(): "
+       << (max_rel_diff(copy, queries) < 1e-12) << " "
+       << (max_rel_diff(other, queries) < 1e-12) << " (c.f. 1 1)" << endl;
+
+  // test: the mirror arrays are cache line aligned.
+  bbrcit::AlignedVector<FloatType> v(1001);
+  cout << "+ alignment: " << (reinterpret_cast<std::uintptr_t>(v.data()) % 64) << " (c.f. 0)" << endl;
+  cout << endl;
+
+  // test: throughput of direct evaluation through the mirror against the
+  // array of structures in points().
+  vector<DataPointType> many_queries;
+  for (int i = 0; i < 2000; ++i) { many_queries.push_back({{g(e), g(e)}}); }
+
+  auto start = std::chrono::high_resolution_clock::now();
+  FloatType checksum = 0.0;
+  for (const auto &q : many_queries) { checksum += points_eval(copy, q); }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+  cout << "+ array of structures: " << elapsed.count() << " ms. " << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (auto q : many_queries) { checksum -= copy.direct_eval(q); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ structure of arrays: " << elapsed.count() << " ms. " << endl;
+  cout << "+ checksum: " << (abs(checksum) < 1e-6) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
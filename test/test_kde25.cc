@@ -0,0 +1,114 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <Kernels/EpanechnikovKernel.h>
+#include <Kernels/GaussianKernel.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+
+  const int D = 6;
+  using FloatType = double;
+  using AttrType = bbrcit::AdaKdeAttributes<FloatType>;
+
+  // EpanechnikovKernel<> that counts its evaluations. see test_kde22.
+  class CountingKernel : public bbrcit::EpanechnikovKernel<D, FloatType> {
+    public:
+      template<typename PointT>
+      FloatType unnormalized_eval(const PointT &p, const PointT &q, FloatType a) const {
+        ++n_evals;
+        return bbrcit::EpanechnikovKernel<D, FloatType>::unnormalized_eval(p, q, a);
+      }
+      static size_t n_evals;
+  };
+  size_t CountingKernel::n_evals = 0;
+}
+
+namespace bbrcit {
+  template<> class RadialKernelTraits<CountingKernel> {
+    public: static constexpr bool value = true;
+  };
+}
+
+// evaluates the density at `queries` with the dual tree algorithm over trees
+// of type TreeT. reports the kernel evaluations, the cpu time, and the
+// largest relative error against direct evaluation at the first 200 queries.
+template<typename TreeT>
+void run(const string &name, const vector<typename TreeT::DataPointType> &data,
+         const vector<typename TreeT::DataPointType> &queries) {
+
+  using KernelDensityType = bbrcit::KernelDensity<D, CountingKernel, FloatType, AttrType, TreeT>;
+
+  bbrcit::KdtreeOptions options;
+  options.leaf_nmax = 32;
+  options.split = bbrcit::KdtreeSplit::MaxSpread;
+
+  KernelDensityType kde(data, options);
+  kde.kernel().set_bandwidth(0.8);
+  TreeT query_tree(queries, options);
+
+  CountingKernel::n_evals = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  kde.eval(query_tree, 1e-3, 1e-10);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+  size_t n_evals = CountingKernel::n_evals;
+
+  double max_err = 0.0;
+  for (size_t i = 0; i < 200; ++i) {
+    auto q = query_tree.points()[i];
+    double exact = kde.direct_eval(q);
+    if (exact > 0) { max_err = max(max_err, abs(query_tree.points()[i].attributes().value() - exact) / exact); }
+  }
+
+  cout << "  " << name << ": " << n_evals << " kernel evaluations, "
+       << elapsed.count() << " ms, within tolerance: " << (max_err <= 1e-3) << " (c.f. 1)" << endl;
+
+  // single tree and adaptive paths run on the same index.
+  auto p = queries[0];
+  double single = kde.eval(p, 1e-6, 1e-10), direct = kde.direct_eval(p);
+  kde.adapt_density(0.5, 1e-3, 1e-10);
+  double adaptive = kde.eval(p, 1e-6, 1e-10), adaptive_direct = kde.direct_eval(p);
+  cout << "  " << name << ": single tree " << (abs(single - direct) <= 1e-6 * direct)
+       << ", adaptive " << (abs(adaptive - adaptive_direct) <= 1e-6 * adaptive_direct)
+       << " (c.f. 1 1)" << endl;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+
+  using DataPointType = typename bbrcit::Kdtree<D,AttrType,FloatType>::DataPointType;
+
+  // points near a randomly oriented plane: the feature sets this index is 
+  // meant for have a low intrinsic dimension. 
+  double basis[2][D];
+  for (int k = 0; k < 2; ++k) { for (int d = 0; d < D; ++d) { basis[k][d] = g(e); } }
+  auto sample = [&] () {
+    DataPointType p;
+    double u = g(e), v = g(e);
+    for (int d = 0; d < D; ++d) { p[d] = u * basis[0][d] + v * basis[1][d] + 0.05 * g(e); }
+    return p;
+  };
+
+  vector<DataPointType> data, queries;
+  for (int i = 0; i < 20000; ++i) { data.push_back(sample()); }
+  for (int i = 0; i < 5000; ++i) { queries.push_back(sample()); }
+
+  cout << "+ dual tree evaluation in " << D << " dimensions: " << endl;
+  run<bbrcit::Kdtree<D,AttrType,FloatType>>("kdtree", data, queries);
+  run<bbrcit::BallTree<D,AttrType,FloatType>>("ball tree", data, queries);
+  cout << endl;
+
+  return 0;
+}
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <Kernels/EpanechnikovKernel.h>
+#include <Kernels/GaussianKernel.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+
+  using FloatType = double;
+
+  // KernelT that counts its evaluations. see test_kde22.
+  template<typename KernelT>
+  class CountingKernel : public KernelT {
+    public:
+      template<typename PointT>
+      FloatType unnormalized_eval(const PointT &p, const PointT &q, FloatType a) const {
+        ++n_evals;
+        return KernelT::unnormalized_eval(p, q, a);
+      }
+      static size_t n_evals;
+  };
+  template<typename KernelT> size_t CountingKernel<KernelT>::n_evals = 0;
+
+  // the same kernel, declared radial and opted in to the moment bounds. 
+  // CountingKernel<> itself does not inherit the library kernels' traits, 
+  // so it runs the usual bounds. 
+  template<typename KernelT>
+  class MomentCountingKernel : public CountingKernel<KernelT> {};
+}
+
+namespace bbrcit {
+  template<typename KernelT> class RadialKernelTraits<MomentCountingKernel<KernelT>> {
+    public: static constexpr bool value = true;
+  };
+  template<typename KernelT> class MomentBoundTraits<MomentCountingKernel<KernelT>> {
+    public: static constexpr bool value = true;
+  };
+}
+
+// evaluates the density at `queries` with the single tree algorithm and 
+// reports the kernel evaluations and cpu time. also checks that the single 
+// and dual tree results are within tolerance of direct evaluation. 
+template<typename KernelT>
+void run(const string &name, const vector<typename bbrcit::KernelDensity<2,KernelT>::DataPointType> &data,
+         vector<typename bbrcit::KernelDensity<2,KernelT>::DataPointType> queries,
+         double bandwidth, double rel_err, bool adaptive) {
+
+  using KernelDensityType = bbrcit::KernelDensity<2,KernelT>;
+
+  KernelDensityType kde(data, 32);
+  kde.kernel().set_bandwidth(bandwidth);
+  if (adaptive) { kde.adapt_density(0.5, 1e-3, 1e-10); }
+
+  vector<double> exact;
+  for (auto q : queries) { exact.push_back(kde.direct_eval(q)); }
+
+  KernelT::n_evals = 0;
+  bool single_ok = true;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < queries.size(); ++i) {
+    auto q = queries[i];
+    single_ok = single_ok && abs(kde.eval(q, rel_err, 1e-10) - exact[i]) <= rel_err * exact[i] + 1e-10;
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+  size_t single_evals = KernelT::n_evals;
+
+  // the queries come back in the order of the query tree. 
+  kde.eval(queries, rel_err, 1e-10, 32);
+  bool dual_ok = true;
+  for (auto &q : queries) {
+    double value = q.attributes().value(), expected = kde.direct_eval(q);
+    dual_ok = dual_ok && abs(value - expected) <= rel_err * expected + 1e-10;
+  }
+
+  cout << "  " << name << ": " << single_evals << " kernel evaluations, " << elapsed.count() << " ms; "
+       << "within tolerance: " << single_ok << " " << dual_ok << " (c.f. 1 1)" << endl;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+
+  using Epanechnikov = bbrcit::EpanechnikovKernel<2,FloatType>;
+  using Gaussian = bbrcit::GaussianKernel<2,FloatType>;
+  using DataPointType = typename bbrcit::KernelDensity<2>::DataPointType;
+
+  cout << "+ library kernels opted in: " << bbrcit::MomentBoundTraits<Gaussian>::value << " "
+       << bbrcit::MomentBoundTraits<Epanechnikov>::value << " (c.f. 0 1)" << endl;
+
+  vector<DataPointType> data, queries;
+  for (int i = 0; i < 20000; ++i) { data.push_back({{g(e), g(e)}}); }
+  for (int i = 0; i < 1000; ++i) { queries.push_back({{g(e), g(e)}}); }
+
+  for (double rel_err : {1e-2, 1e-4, 1e-6}) {
+    cout << "+ gaussian kernel, rel_err = " << rel_err << ": " << endl;
+    run<CountingKernel<Gaussian>>("without moments", data, queries, 1.0, rel_err, false);
+    run<MomentCountingKernel<Gaussian>>("with moments", data, queries, 1.0, rel_err, false);
+    cout << "+ epanechnikov kernel, rel_err = " << rel_err << ": " << endl;
+    run<CountingKernel<Epanechnikov>>("without moments", data, queries, 1.0, rel_err, false);
+    run<MomentCountingKernel<Epanechnikov>>("with moments", data, queries, 1.0, rel_err, false);
+  }
+  cout << endl;
+
+  // adaptive densities: nodes whose points have different bandwidth
+  // corrections fall back to the usual bounds.
+  cout << "+ adaptive gaussian kernel, rel_err = 0.01: " << endl;
+  run<CountingKernel<Gaussian>>("without moments", data, queries, 1.0, 1e-2, true);
+  run<MomentCountingKernel<Gaussian>>("with moments", data, queries, 1.0, 1e-2, true);
+  cout << endl;
+
+  return 0;
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <vector>
+
+#include <Kernels/GaussianKernel.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+  using FloatType = double;
+  using KernelType = bbrcit::GaussianKernel<2,FloatType>;
+  using KernelDensityType = bbrcit::KernelDensity<2, KernelType, FloatType>;
+  using DataPointType = typename KernelDensityType::DataPointType;
+  using KdtreeType = typename KernelDensityType::KdtreeType;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+
+  vector<DataPointType> data;
+  for (int i = 0; i < 50000; ++i) { data.push_back({{g(e), g(e)}}); }
+
+  KernelDensityType kde(data, 32);
+  kde.kernel().set_bandwidth(0.05);
+
+  // test: self evaluation agrees with evaluation on a copy of the data tree.
+  auto start = std::chrono::high_resolution_clock::now();
+  KdtreeType query_tree = kde.data_tree();
+  kde.eval(query_tree, 1e-3, 1e-10);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> copy_elapsed = end - start;
+
+  vector<FloatType> values;
+  start = std::chrono::high_resolution_clock::now();
+  kde.self_eval(values, 1e-3, 1e-10);
+  end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> self_elapsed = end - start;
+
+  bool same = values.size() == query_tree.size();
+  for (size_t i = 0; same && i < values.size(); ++i) {
+    same = values[i] == query_tree.points()[i].attributes().value();
+  }
+  cout << "+ self_eval(), " << data.size() << " points: " << self_elapsed.count() << " ms "
+       << "(c.f. " << copy_elapsed.count() << " ms with a copy of the data tree). " << endl;
+  cout << "  same values: " << same << " (c.f. 1)" << endl;
+
+  // test: the data tree is left untouched.
+  bool untouched = true;
+  for (size_t i = 0; i < kde.size(); ++i) {
+    untouched = untouched && kde.points()[i].attributes().lower() == 0
+                          && kde.points()[i].attributes().upper() == 0;
+  }
+  cout << "  data tree untouched: " << untouched << " (c.f. 1)" << endl;
+
+  // test: the leave one out scores built on self evaluation.
+  FloatType expected = 0.0;
+  for (size_t i = 0; i < kde.size(); ++i) {
+    const auto &attr = kde.points()[i].attributes();
+    expected += attr.weight() * log(query_tree.points()[i].attributes().value() -
+                                    attr.mass() * kde.kernel().normalization());
+  }
+  FloatType cv = kde.likelihood_cross_validate(1e-3, 1e-10);
+  cout << "+ likelihood_cross_validate(): " << cv << " (c.f. " << expected << ")" << endl;
+  cout << endl;
+
+  return 0;
+}
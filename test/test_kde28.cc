@@ -0,0 +1,83 @@
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+
+#include <Kernels/GaussianKernel.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+  using FloatType = double;
+  using KernelType = bbrcit::GaussianKernel<2,FloatType>;
+  using KernelDensityType = bbrcit::KernelDensity<2, KernelType, FloatType>;
+  using DataPointType = typename KernelDensityType::DataPointType;
+}
+
+// returns the cpu time of dual tree evaluation at `queries` with data and
+// query trees of leaf size `leaf_nmax`; best of two runs.
+double eval_time(const vector<DataPointType> &data, const vector<DataPointType> &queries,
+                 double bandwidth, int leaf_nmax) {
+  KernelDensityType kde(data, leaf_nmax);
+  kde.kernel().set_bandwidth(bandwidth);
+  double best = std::numeric_limits<double>::max();
+  for (int run = 0; run < 2; ++run) {
+    vector<DataPointType> q = queries;
+    auto start = std::chrono::high_resolution_clock::now();
+    kde.eval(q, 1e-3, 1e-10, leaf_nmax);
+    auto end = std::chrono::high_resolution_clock::now();
+    best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  return best;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+
+  vector<DataPointType> data, queries;
+  for (int i = 0; i < 100000; ++i) { data.push_back({{g(e), g(e)}}); }
+  for (int i = 0; i < 10000; ++i) { queries.push_back({{g(e), g(e)}}); }
+
+  for (double bandwidth : {0.01, 0.1}) {
+
+    KernelDensityType kde(data, 32);
+    kde.kernel().set_bandwidth(bandwidth);
+
+    cout << "+ bandwidth " << bandwidth << ": " << endl;
+    int leaf_nmax = kde.calibrate_leaf_nmax(1e-3, 1e-10, 5000, 2, 4096, &cout);
+
+    cout << "  dual tree evaluation, " << data.size() << " points at "
+         << queries.size() << " queries: " << endl;
+    double best_time = std::numeric_limits<double>::max();
+    for (int l = 8; l <= 1024; l *= 2) {
+      double t = eval_time(data, queries, bandwidth, l);
+      cout << "  leaf_nmax " << l << ": " << t << " ms. " << endl;
+      best_time = std::min(best_time, t);
+    }
+
+    // test: the calibrated leaf size is close to the fastest fixed one. 
+    double calibrated_time = eval_time(data, queries, bandwidth, leaf_nmax);
+    cout << "  calibrated leaf_nmax " << leaf_nmax << ": " << calibrated_time << " ms, "
+         << "within 50% of the fastest: " << (calibrated_time <= 1.5 * best_time) 
+         << " (c.f. 1)" << endl;
+    cout << endl;
+  }
+
+  // test: invalid ranges are rejected.
+  KernelDensityType kde(data, 32);
+  bool caught = false;
+  try { kde.calibrate_leaf_nmax(1e-3, 1e-10, 1000, 8, 4); }
+  catch (std::invalid_argument&) { caught = true; }
+  cout << "+ invalid range: " << caught << " (c.f. 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <Kernels/GaussianKernel.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+  using FloatType = double;
+  using KernelType = bbrcit::GaussianKernel<2,FloatType>;
+  using KernelDensityType = bbrcit::KernelDensity<2, KernelType, FloatType>;
+  using DataPointType = typename KernelDensityType::DataPointType;
+  using KdtreeType = typename KernelDensityType::KdtreeType;
+}
+
+// builds an estimator whose dual tree evaluations run on `n_threads` threads.
+KernelDensityType make_kde(const vector<DataPointType> &data, int n_threads) {
+  bbrcit::KdtreeOptions options;
+  options.leaf_nmax = 32; options.n_threads = n_threads;
+  KernelDensityType kde(data, options);
+  kde.kernel().set_bandwidth(0.05);
+  return kde;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+
+  vector<DataPointType> data, queries;
+  for (int i = 0; i < 50000; ++i) { data.push_back({{g(e), g(e)}}); }
+  for (int i = 0; i < 50000; ++i) { queries.push_back({{g(e), g(e)}}); }
+
+  int n_cores = std::max(1u, std::thread::hardware_concurrency());
+  cout << "+ hardware concurrency: " << n_cores << endl;
+
+  KernelDensityType serial = make_kde(data, 1);
+  vector<FloatType> serial_values;
+  auto start = std::chrono::high_resolution_clock::now();
+  serial.self_eval(serial_values, 1e-3, 1e-10);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> serial_elapsed = end - start;
+
+  // the same query tree for every thread count. 
+  bbrcit::KdtreeOptions qtree_options; qtree_options.leaf_nmax = 32;
+  KdtreeType serial_tree(queries, qtree_options);
+  serial.eval(serial_tree, 1e-3, 1e-10);
+
+  // test: each forked task only sees its own query subtree, and runs the 
+  // same steps as the serial traversal. the results are therefore identical. 
+  // (the data trees are also identical: there are too few points for the 
+  // parallel construction to partition differently.) 
+  for (int n_threads : { 2, 4, 0 }) {
+
+    KernelDensityType kde = make_kde(data, n_threads);
+
+    vector<FloatType> values;
+    start = std::chrono::high_resolution_clock::now();
+    kde.self_eval(values, 1e-3, 1e-10);
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+
+    KdtreeType query_tree(queries, qtree_options);
+    kde.eval(query_tree, 1e-3, 1e-10);
+
+    bool same = values == serial_values;
+    for (size_t i = 0; same && i < query_tree.size(); ++i) {
+      same = query_tree.points()[i].attributes().value() == serial_tree.points()[i].attributes().value();
+    }
+
+    cout << "+ " << (n_threads ? n_threads : n_cores) << " threads: self_eval(), " << data.size() 
+         << " points: " << elapsed.count() << " ms (c.f. " << serial_elapsed.count() 
+         << " ms on 1 thread). " << endl;
+    cout << "  same values as 1 thread: " << same << " (c.f. 1)" << endl;
+  }
+
+  // test: cross validation goes through the same traversal. 
+  KernelDensityType kde = make_kde(data, 4);
+  cout << "+ likelihood_cross_validate(): " << kde.likelihood_cross_validate(1e-3, 1e-10) 
+       << " (c.f. " << serial.likelihood_cross_validate(1e-3, 1e-10) << ")" << endl;
+
+  // test: copies share the estimator's threads, and may evaluate at the
+  // same time as the original.
+  KernelDensityType copy = kde;
+  vector<FloatType> values, copy_values;
+  std::thread t([&] { copy.self_eval(copy_values, 1e-3, 1e-10); });
+  kde.self_eval(values, 1e-3, 1e-10);
+  t.join();
+  cout << "+ concurrent self_eval() on a copy: " << (values == serial_values) << " "
+       << (copy_values == serial_values) << " (c.f. 1 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
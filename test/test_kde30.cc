@@ -0,0 +1,145 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <Kernels/GaussianKernel.h>
+#include <Kernels/EpanechnikovKernel.h>
+#include <Kernels/GaussianProductKernel2d.h>
+#include <Kernels/EpanechnikovProductKernel2d.h>
+#include <KernelBlockSum.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+  using PointType = bbrcit::Point<2,double>;
+  using KernelType = bbrcit::GaussianKernel<2,double>;
+  using KernelDensityType = bbrcit::KernelDensity<2, KernelType, double>;
+  using DataPointType = typename KernelDensityType::DataPointType;
+
+  const bbrcit::SimdIsa isas[] = { bbrcit::SimdIsa::Sse2, bbrcit::SimdIsa::Avx2, bbrcit::SimdIsa::Avx512 };
+}
+
+// returns the largest relative difference between the block sums of each
+// instruction set and the scalar loop, at `queries`.
+template<typename KernT>
+double max_rel_diff(const KernT &kernel, const vector<PointType> &queries,
+                    const double *const *coords, const double *abws, const double *masses, size_t n) {
+  double max_diff = 0.0;
+  for (const auto &q : queries) {
+    bbrcit::set_simd_isa(bbrcit::SimdIsa::Scalar);
+    double expected = bbrcit::kernel_block_sum(kernel, q, coords, abws, masses, n);
+    for (auto isa : isas) {
+      bbrcit::set_simd_isa(isa);
+      double actual = bbrcit::kernel_block_sum(kernel, q, coords, abws, masses, n);
+      max_diff = max(max_diff, abs(actual - expected) / max(expected, 1e-300));
+    }
+  }
+  bbrcit::set_simd_isa(bbrcit::detected_simd_isa());
+  return max_diff;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  uniform_real_distribution<> u(0.5, 2.0);
+
+  cout << "+ detected instruction set: " << bbrcit::simd_isa_name(bbrcit::detected_simd_isa()) << endl;
+
+  // test: block sums agree with the scalar loop. the block sizes leave
+  // remainders for every vector width.
+  const size_t n = 1027;
+  vector<double> x(n), y(n), abws(n), masses(n);
+  for (size_t i = 0; i < n; ++i) { x[i] = g(e); y[i] = g(e); abws[i] = u(e); masses[i] = u(e); }
+  const double *coords[2] = { x.data(), y.data() };
+  vector<PointType> queries;
+  for (int i = 0; i < 100; ++i) { queries.push_back(PointType({g(e), g(e)})); }
+
+  for (size_t m : { size_t(1), size_t(7), n }) {
+    cout << "+ " << m << " point(s): " << endl;
+    cout << "  gaussian: " << (max_rel_diff(bbrcit::GaussianKernel<2,double>(0.3), queries, coords,
+                                             abws.data(), masses.data(), m) < 1e-12) << " (c.f. 1)" << endl;
+    cout << "  epanechnikov: " << (max_rel_diff(bbrcit::EpanechnikovKernel<2,double>(0.8), queries, coords,
+                                                 abws.data(), masses.data(), m) < 1e-12) << " (c.f. 1)" << endl;
+    cout << "  gaussian product: " << (max_rel_diff(bbrcit::GaussianProductKernel2d<double>(0.2, 0.5), queries,
+                                                     coords, abws.data(), masses.data(), m) < 1e-12) << " (c.f. 1)" << endl;
+    cout << "  epanechnikov product: " << (max_rel_diff(bbrcit::EpanechnikovProductKernel2d<double>(0.7, 1.1),
+                                                         queries, coords, abws.data(), masses.data(), m) < 1e-12)
+         << " (c.f. 1)" << endl;
+  }
+
+  // test: the vector exp() over its whole range, through single points.
+  bool exp_ok = true;
+  for (double t = 0.0; t < 1500.0; t += 0.37) {
+    double xt = sqrt(2.0*t);
+    for (auto isa : isas) {
+      bbrcit::set_simd_isa(isa);
+      vector<double> xs(8, xt), zs(8, 0.0), ones(8, 1.0);
+      const double *cs[2] = { xs.data(), zs.data() };
+      double expected = exp(-0.5*xt*xt) * 8;
+      double actual = bbrcit::kernel_block_sum(KernelType(1.0), PointType({0.0, 0.0}), cs,
+                                               ones.data(), ones.data(), 8);
+      exp_ok = exp_ok && (t > 700 ? actual < 1e-300 : abs(actual - expected) <= 1e-14 * expected);
+    }
+  }
+  bbrcit::set_simd_isa(bbrcit::detected_simd_isa());
+  cout << "+ exp() over [0, 1500]: " << exp_ok << " (c.f. 1)" << endl;
+
+  // test: sums over several queries at once are those of one query at a
+  // time, bit for bit. the query counts leave partial register blocks and
+  // batches, and the points span several tiles.
+  vector<PointType> many_queries;
+  for (int i = 0; i < 150; ++i) { many_queries.push_back(PointType({g(e), g(e)})); }
+  bool blocked_same = true;
+  for (auto isa : isas) {
+    bbrcit::set_simd_isa(isa);
+    bbrcit::GaussianKernel<2,double> kernel(0.3);
+    for (size_t n_q : { size_t(1), size_t(5), size_t(70), size_t(150) }) {
+      vector<double> sums(n_q, 0.0);
+      bbrcit::kernel_block_sums(kernel, many_queries.data(), n_q, coords,
+                                abws.data(), masses.data(), n, sums.data());
+      for (size_t k = 0; k < n_q; ++k) {
+        blocked_same = blocked_same &&
+          sums[k] == bbrcit::kernel_block_sum(kernel, many_queries[k], coords, abws.data(), masses.data(), n);
+      }
+    }
+  }
+  bbrcit::set_simd_isa(bbrcit::detected_simd_isa());
+  cout << "+ kernel_block_sums() same as one query at a time: " << blocked_same << " (c.f. 1)" << endl;
+
+  // test: direct evaluation with each instruction set.
+  vector<DataPointType> data;
+  for (int i = 0; i < 100000; ++i) { data.push_back({{g(e), g(e)}}); }
+  KernelDensityType kde(data, 32);
+  kde.kernel().set_bandwidth(0.1);
+  vector<DataPointType> direct_queries;
+  for (int i = 0; i < 200; ++i) { direct_queries.push_back({{g(e), g(e)}}); }
+
+  cout << "+ direct evaluation, " << data.size() << " points at " << direct_queries.size() << " queries: " << endl;
+  vector<double> expected;
+  for (auto isa : { bbrcit::SimdIsa::Scalar, bbrcit::SimdIsa::Sse2, bbrcit::SimdIsa::Avx2, bbrcit::SimdIsa::Avx512 }) {
+    if (static_cast<int>(isa) > static_cast<int>(bbrcit::detected_simd_isa())) { continue; }
+    bbrcit::set_simd_isa(isa);
+    auto start = std::chrono::high_resolution_clock::now();
+    vector<double> values;
+    for (auto &q : direct_queries) { values.push_back(kde.direct_eval(q)); }
+    auto end = std::chrono::high_resolution_clock::now();
+    if (expected.empty()) { expected = values; }
+    bool same = true;
+    for (size_t i = 0; i < values.size(); ++i) { same = same && abs(values[i] - expected[i]) <= 1e-12 * expected[i]; }
+    cout << "  " << bbrcit::simd_isa_name(isa) << ": "
+         << std::chrono::duration<double, std::milli>(end - start).count() << " ms, "
+         << "agrees with scalar: " << same << " (c.f. 1)" << endl;
+  }
+  bbrcit::set_simd_isa(bbrcit::detected_simd_isa());
+  cout << endl;
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <vector>
+
+#include <Kernels/GaussianKernel.h>
+#include <Kernels/EpanechnikovKernel.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+  using FloatType = double;
+  using KernelType = bbrcit::GaussianKernel<2,FloatType>;
+  using KernelDensityType = bbrcit::KernelDensity<2, KernelType, FloatType>;
+  using DataPointType = typename KernelDensityType::DataPointType;
+}
+
+// returns the cpu time of self_eval() on `kde`, which writes to `values`.
+double self_eval_time(const KernelDensityType &kde, vector<FloatType> &values) {
+  auto start = std::chrono::high_resolution_clock::now();
+  kde.self_eval(values, 1e-3, 1e-10);
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// true if each of `values` is within `rel_err` of `expected`.
+bool within(const vector<FloatType> &values, const vector<FloatType> &expected, FloatType rel_err) {
+  bool ok = values.size() == expected.size();
+  for (size_t i = 0; ok && i < values.size(); ++i) {
+    ok = abs(values[i] - expected[i]) <= rel_err * expected[i] + 1e-10;
+  }
+  return ok;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+
+  vector<DataPointType> data, queries;
+  for (int i = 0; i < 50000; ++i) { data.push_back({{g(e), g(e)}}); }
+  for (int i = 0; i < 5000; ++i) { queries.push_back({{g(e), g(e)}}); }
+
+  bbrcit::KdtreeOptions options; options.leaf_nmax = 32;
+  KernelDensityType kde(data, options);
+  kde.kernel().set_bandwidth(0.05);
+  cout << "+ defer_base_cases() by default: " << kde.defer_base_cases() << " (c.f. 0)" << endl;
+
+  // test: eval() with deferred base cases stays within tolerance, and the
+  // bounds still bracket the direct values.
+  for (bool defer : {false, true}) {
+    kde.set_defer_base_cases(defer);
+    vector<DataPointType> tree_queries = queries;
+    auto start = std::chrono::high_resolution_clock::now();
+    kde.eval(tree_queries, 1e-3, 1e-10, 32);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // eval() reorders the queries; direct evaluation puts them back in
+    // correspondence.
+    vector<DataPointType> check = tree_queries;
+    kde.direct_eval(check);
+    bool ok = true, bracketed = true;
+    for (size_t i = 0; i < tree_queries.size(); ++i) {
+      const auto &attr = tree_queries[i].attributes();
+      FloatType v = check[i].attributes().value();
+      ok = ok && abs(attr.value() - v) <= 1e-3 * v + 1e-10;
+      bracketed = bracketed && attr.lower() <= v * (1 + 1e-12) && v <= attr.upper() * (1 + 1e-12);
+    }
+    cout << "+ eval(), deferred " << defer << ": "
+         << std::chrono::duration<double, std::milli>(end - start).count() << " ms, "
+         << "within tolerance " << ok << ", bounds bracket " << bracketed << " (c.f. 1 1)" << endl;
+  }
+
+  // test: self evaluation on one and four threads, against direct
+  // evaluation at the reference points.
+  vector<FloatType> direct_values;
+  for (const auto &p : kde.points()) { DataPointType q = p; direct_values.push_back(kde.direct_eval(q)); }
+
+  for (int n_threads : {1, 4}) {
+    options.n_threads = n_threads;
+    KernelDensityType threaded_kde(data, options);
+    threaded_kde.kernel().set_bandwidth(0.05);
+
+    vector<FloatType> immediate, deferred;
+    double immediate_elapsed = self_eval_time(threaded_kde, immediate);
+    threaded_kde.set_defer_base_cases(true);
+    double deferred_elapsed = self_eval_time(threaded_kde, deferred);
+
+    cout << "+ self_eval(), " << data.size() << " points, " << n_threads << " thread(s): "
+         << deferred_elapsed << " ms deferred (c.f. " << immediate_elapsed << " ms immediate). " << endl;
+    cout << "  within tolerance: " << within(deferred, direct_values, 1e-3) << " "
+         << within(immediate, direct_values, 1e-3) << " (c.f. 1 1)" << endl;
+  }
+
+  // test: a compact kernel, whose base cases include zero contributions.
+  using EpanKernelDensityType = bbrcit::KernelDensity<2, bbrcit::EpanechnikovKernel<2,FloatType>, FloatType>;
+  options.n_threads = 1;
+  EpanKernelDensityType epan_kde(data, options);
+  epan_kde.kernel().set_bandwidth(0.2);
+  vector<FloatType> immediate, deferred;
+  epan_kde.self_eval(immediate, 1e-3, 1e-10);
+  epan_kde.set_defer_base_cases(true);
+  epan_kde.self_eval(deferred, 1e-3, 1e-10);
+  cout << "+ epanechnikov kernel: " << within(deferred, immediate, 2e-3) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
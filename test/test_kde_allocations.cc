@@ -0,0 +1,176 @@
+#define _USE_MATH_DEFINES
+
+#include <iostream>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <chrono>
+#include <vector>
+
+#include <Kernels/EpanechnikovKernel.h>
+#include <KernelDensity.h>
+
+#include "kde_test_utils.h"
+
+using namespace std;
+
+namespace {
+  using FloatType = double;
+  using KernelType = bbrcit::EpanechnikovKernel<2, FloatType>;
+  using KernelDensityType = bbrcit::KernelDensity<2, KernelType, FloatType>;
+  using DataPointType = typename KernelDensityType::DataPointType;
+  using KdtreeType = typename KernelDensityType::KdtreeType;
+
+  // number of calls to the global operator new since program start.
+  size_t n_allocations = 0;
+}
+
+// count every heap allocation made by this program.
+void* operator new(size_t n) {
+  ++n_allocations;
+  void *p = std::malloc(n ? n : 1);
+  if (!p) { throw std::bad_alloc(); }
+  return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+int main() {
+
+  std::chrono::high_resolution_clock::time_point start, end;
+  std::chrono::duration<double, std::milli> elapsed;
+
+  double rel_err = 1e-6, abs_err = 1e-10;
+  int n_references = 100000, n_queries = 10000;
+
+  default_random_engine e;
+  vector<DataPointType> references;
+  generate_bimodal_gaussian(e, references, n_references,
+                            1, 1, 0.5, 0.3, 30,
+                            -1, -1, 0.5, 0.3, -30);
+
+  vector<DataPointType> queries(references.begin(), references.begin()+n_queries);
+
+  KernelDensityType kde(references, 32);
+  kde.kernel().set_bandwidth(0.1);
+
+  cout << endl;
+
+  // single tree: evaluate each query separately
+  size_t n_before = n_allocations;
+  start = std::chrono::high_resolution_clock::now();
+  for (auto &q : queries) { kde.eval(q, rel_err, abs_err); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+
+  cout << "+ single tree: " << n_queries << " queries. " << endl;
+  cout << "  heap allocations: " << n_allocations - n_before << " (c.f. 0)" << endl;
+  cout << "  cpu time: " << elapsed.count() << " ms. " << endl;
+  cout << endl;
+
+  // dual tree: evaluate on a pre-built query tree
+  KdtreeType query_tree(std::move(queries), 32);
+
+  n_before = n_allocations;
+  start = std::chrono::high_resolution_clock::now();
+  kde.eval(query_tree, rel_err, abs_err);
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+
+  cout << "+ dual tree: " << n_queries << " queries. " << endl;
+  cout << "  heap allocations: " << n_allocations - n_before << " (c.f. 0)" << endl;
+  cout << "  cpu time: " << elapsed.count() << " ms. " << endl;
+  cout << endl;
+
+  // dual tree: repeated evaluation of small batches, with and without 
+  // an EvalContext that keeps the query tree alive across calls. 
+  int n_batches = 100, batch_size = 500;
+  vector<vector<DataPointType>> batches(n_batches);
+  for (int b = 0; b < n_batches; ++b) {
+    batches[b].assign(references.begin() + b * 50, references.begin() + b * 50 + batch_size);
+  }
+
+  n_before = n_allocations;
+  start = std::chrono::high_resolution_clock::now();
+  for (auto &batch : batches) { kde.eval(batch, rel_err, abs_err, 32); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+
+  cout << "+ dual tree: " << n_batches << " batches of " << batch_size << " queries. " << endl;
+  cout << "  heap allocations: " << n_allocations - n_before << endl;
+  cout << "  cpu time: " << elapsed.count() << " ms. " << endl;
+  cout << endl;
+
+  KernelDensityType::EvalContext context(32);
+  kde.eval(batches[0], rel_err, abs_err, context);
+
+  n_before = n_allocations;
+  start = std::chrono::high_resolution_clock::now();
+  for (auto &batch : batches) { kde.eval(batch, rel_err, abs_err, context); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+
+  cout << "+ dual tree with an EvalContext: " << n_batches << " batches of " << batch_size << " queries. " << endl;
+  cout << "  heap allocations: " << n_allocations - n_before << " (c.f. 0)" << endl;
+  cout << "  cpu time: " << elapsed.count() << " ms. " << endl;
+  cout << endl;
+
+  // the same on 4 threads: the query trees are rebuilt on the estimator's 
+  // threads rather than on threads of their own. 
+  bbrcit::KdtreeOptions options;
+  options.leaf_nmax = 32;
+  options.n_threads = 4;
+  KernelDensityType threaded_kde(references, options);
+  threaded_kde.kernel().set_bandwidth(0.1);
+
+  KernelDensityType::EvalContext threaded_context(32);
+  threaded_kde.eval(batches[0], rel_err, abs_err, threaded_context);
+
+  n_before = n_allocations;
+  start = std::chrono::high_resolution_clock::now();
+  for (auto &batch : batches) { threaded_kde.eval(batch, rel_err, abs_err, threaded_context); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+
+  cout << "+ dual tree with an EvalContext, 4 threads: " << n_batches << " batches of " << batch_size << " queries. " << endl;
+  cout << "  heap allocations: " << n_allocations - n_before << " (c.f. 0)" << endl;
+  cout << "  cpu time: " << elapsed.count() << " ms. " << endl;
+  cout << endl;
+
+  // batches large enough to be split over the threads: only the single 
+  // threaded estimator reuses the context without allocating. on 4 threads, 
+  // the forked build and traversal tasks allocate their own storage. 
+  int n_large_batches = 3, large_batch_size = 8000;
+  vector<DataPointType> large_batch(references.begin(), references.begin() + large_batch_size);
+
+  KernelDensityType::EvalContext large_context(32);
+  kde.eval(large_batch, rel_err, abs_err, large_context);
+
+  n_before = n_allocations;
+  start = std::chrono::high_resolution_clock::now();
+  for (int b = 0; b < n_large_batches; ++b) { kde.eval(large_batch, rel_err, abs_err, large_context); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+
+  cout << "+ dual tree with an EvalContext: " << n_large_batches << " batches of " << large_batch_size << " queries. " << endl;
+  cout << "  heap allocations: " << n_allocations - n_before << " (c.f. 0)" << endl;
+  cout << "  cpu time: " << elapsed.count() << " ms. " << endl;
+  cout << endl;
+
+  KernelDensityType::EvalContext threaded_large_context(32);
+  threaded_kde.eval(large_batch, rel_err, abs_err, threaded_large_context);
+
+  n_before = n_allocations;
+  start = std::chrono::high_resolution_clock::now();
+  for (int b = 0; b < n_large_batches; ++b) { threaded_kde.eval(large_batch, rel_err, abs_err, threaded_large_context); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+
+  cout << "+ dual tree with an EvalContext, 4 threads: " << n_large_batches << " batches of " << large_batch_size << " queries. " << endl;
+  cout << "  heap allocations: " << n_allocations - n_before << " (c.f. > 0)" << endl;
+  cout << "  cpu time: " << elapsed.count() << " ms. " << endl;
+  cout << endl;
+
+  return 0;
+}
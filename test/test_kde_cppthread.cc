@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <cmath>
 #include <random>
 #include <chrono>
@@ -110,6 +111,50 @@ int main() {
   elapsed = end-start;
   cout << "parallel single tree time: " << elapsed.count() << endl;
 
+  // the same through the library, on every core. 
+  vector<DataPointType> serial_queries = data;
+  single_tree_evaluate_segment(0, serial_queries.size(), serial_queries, 
+                               rel_err, abs_err, epan_kde);
+
+  queries = data;
+  start = std::chrono::high_resolution_clock::now();
+  epan_kde->eval_parallel(queries, rel_err, abs_err, 0);
+  end = std::chrono::high_resolution_clock::now();
+
+  elapsed = end-start;
+  cout << "eval_parallel() time (" << thread::hardware_concurrency() << " threads): " 
+       << elapsed.count() << endl;
+
+  bool same = true;
+  for (size_t i = 0; i < queries.size(); ++i) {
+    same = same && queries[i].attributes().value() == serial_queries[i].attributes().value();
+  }
+  cout << "eval_parallel() matches single tree in order: " << same << " (c.f. 1)" << endl;
+
+  // a pool kept across calls. 
+  bbrcit::ThreadPool pool(0);
+  queries.assign(data.begin(), data.begin() + 1000);
+  epan_kde->eval_parallel(queries, rel_err, abs_err, pool);
+  epan_kde->eval_parallel(queries, rel_err, abs_err, pool);
+  same = true;
+  for (size_t i = 0; i < queries.size(); ++i) {
+    same = same && queries[i].attributes().value() == serial_queries[i].attributes().value();
+  }
+  cout << "eval_parallel() with a persistent pool: " << same << " (c.f. 1)" << endl;
+
+  // precision losses are reported from the calling thread, in query order, 
+  // as serial evaluations report them. 
+  stringstream serial_report, parallel_report;
+  streambuf *cerr_buf = cerr.rdbuf(serial_report.rdbuf());
+  queries.assign(data.begin(), data.begin() + 100);
+  for (auto &q : queries) { epan_kde->eval(q, 0.0, 0.0); }
+  cerr.rdbuf(parallel_report.rdbuf());
+  epan_kde->eval_parallel(queries, 0.0, 0.0, pool);
+  cerr.rdbuf(cerr_buf);
+  cout << "eval_parallel() precision loss reports match serial: " 
+       << (!serial_report.str().empty() && serial_report.str() == parallel_report.str()) 
+       << " (c.f. 1)" << endl;
+
   delete epan_kde;
 
 
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+#include <Kdtree.h>
+#include <ThreadPool.h>
+
+using namespace std;
+
+namespace {
+  const int D = 2;
+  using KdtreeType = bbrcit::Kdtree<D>;
+  using DataPointType = typename KdtreeType::DataPointType;
+  using RectangleType = bbrcit::Rectangle<D,double>;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  uniform_real_distribution<> u(0.0, 1.0);
+
+  vector<DataPointType> data;
+  for (int i = 0; i < 1000000; ++i) { data.push_back({{g(e), g(e)}}); }
+  KdtreeType tree(data);
+
+  vector<RectangleType> windows;
+  for (int i = 0; i < 100000; ++i) {
+    double x = 4*u(e)-2, y = 4*u(e)-2;
+    windows.push_back(RectangleType({x, y}, {x+0.2*u(e), y+0.2*u(e)}));
+  }
+
+  // test: range_visit() reports the points of range_search(), in order.
+  bool visit_ok = true;
+  for (size_t q = 0; q < 1000; ++q) {
+    vector<DataPointType> expected;
+    tree.range_search(windows[q], expected);
+    size_t n = 0;
+    tree.range_visit(windows[q], [&] (size_t i, const DataPointType &p) {
+      visit_ok = visit_ok && n < expected.size() && &p == &tree.points()[i]
+                 && p[0] == expected[n][0] && p[1] == expected[n][1];
+      ++n;
+    });
+    visit_ok = visit_ok && n == expected.size();
+  }
+  cout << "+ range_visit(): " << visit_ok << " (c.f. 1)" << endl;
+
+  // test: batched range search against one query at a time.
+  vector<size_t> offsets, indices;
+  tree.range_search(windows, offsets, indices);
+  bool batch_ok = offsets.size() == windows.size() + 1;
+  for (size_t q = 0; batch_ok && q < windows.size(); ++q) {
+    vector<size_t> expected;
+    tree.range_visit(windows[q], [&expected] (size_t i, const DataPointType&) { expected.push_back(i); });
+    batch_ok = equal(expected.begin(), expected.end(), indices.begin()+offsets[q])
+               && offsets[q+1] - offsets[q] == expected.size();
+  }
+  cout << "+ batched range_search(): " << batch_ok << " (c.f. 1)" << endl;
+
+  vector<size_t> parallel_offsets, parallel_indices;
+  tree.range_search(windows, parallel_offsets, parallel_indices, 4);
+  cout << "+ batched range_search(), 4 threads: "
+       << (parallel_offsets == offsets && parallel_indices == indices) << " (c.f. 1)" << endl;
+
+  bbrcit::ThreadPool pool(4);
+  tree.range_search(windows, parallel_offsets, parallel_indices, pool);
+  cout << "+ batched range_search(), shared pool of 4: "
+       << (parallel_offsets == offsets && parallel_indices == indices) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  // test: timings for 10^5 windows.
+  auto start = std::chrono::high_resolution_clock::now();
+  vector<vector<DataPointType>> results(windows.size());
+  for (size_t q = 0; q < windows.size(); ++q) { tree.range_search(windows[q], results[q]); }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+  cout << "+ range_search() per window: " << elapsed.count() << " ms. " << endl;
+
+  size_t total = 0;
+  for (const auto &r : results) { total += r.size(); }
+  vector<vector<DataPointType>>().swap(results);
+
+  for (int n_threads : {1, 4}) {
+    start = std::chrono::high_resolution_clock::now();
+    tree.range_search(windows, offsets, indices, n_threads);
+    end = std::chrono::high_resolution_clock::now();
+    elapsed = end - start;
+    cout << "+ batched range_search(), " << n_threads << " thread(s): " << elapsed.count() << " ms. " << endl;
+  }
+
+  // repeated batches on a pool kept across them, against a pool per batch. 
+  const int n_batches = 5;
+  start = std::chrono::high_resolution_clock::now();
+  for (int b = 0; b < n_batches; ++b) { tree.range_search(windows, offsets, indices, 4); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ " << n_batches << " batches, 4 threads each: " << elapsed.count() << " ms. " << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (int b = 0; b < n_batches; ++b) { tree.range_search(windows, offsets, indices, pool); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ " << n_batches << " batches, shared pool of 4: " << elapsed.count() << " ms. " << endl;
+  cout << "+ totals agree: " << (total == indices.size()) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
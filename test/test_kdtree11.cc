@@ -0,0 +1,153 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+
+#include <SpaceFillingCurve.h>
+#include <Kdtree.h>
+#include <Kernels/GaussianKernel.h>
+#include <KernelDensity.h>
+
+using namespace std;
+
+namespace {
+  using KdtreeType = bbrcit::Kdtree<2>;
+  using DataPointType = typename KdtreeType::DataPointType;
+  using bbrcit::KdtreeCurve;
+}
+
+// returns true if the cells of the 2^bits grid at the origin occupy the
+// first positions along the Hilbert curve and consecutive cells are adjacent.
+template<int D>
+bool hilbert_is_continuous(int bits) {
+  size_t n = size_t(1) << (D*bits);
+  vector<vector<uint32_t>> cells(n);
+  for (size_t c = 0; c < n; ++c) {
+    uint32_t x[D], y[D];
+    for (int i = 0; i < D; ++i) { x[i] = y[i] = (c >> (i*bits)) & ((1u << bits) - 1); }
+    uint64_t key = bbrcit::hilbert_key<D>(x);
+    if (key >= n) { return false; }
+    cells[key].assign(y, y+D);
+  }
+  for (size_t k = 1; k < n; ++k) {
+    int dist = 0;
+    for (int i = 0; i < D; ++i) { dist += abs(int(cells[k][i]) - int(cells[k-1][i])); }
+    if (dist != 1) { return false; }
+  }
+  return true;
+}
+
+// returns true if the points within every leaf of `tree` follow the curve.
+bool leaves_follow_curve(const KdtreeType &tree, KdtreeCurve curve) {
+  double lo[2], hi[2];
+  for (int i = 0; i < 2; ++i) {
+    lo[i] = numeric_limits<double>::max(); hi[i] = numeric_limits<double>::lowest();
+    for (const auto &p : tree.points()) { lo[i] = min(lo[i], p[i]); hi[i] = max(hi[i], p[i]); }
+  }
+  auto key = [&] (const DataPointType &p) {
+    uint32_t x[2];
+    for (int i = 0; i < 2; ++i) {
+      x[i] = bbrcit::curve_grid_coordinate(p[i], lo[i], hi[i], bbrcit::curve_key_bits<2>());
+    }
+    return curve == KdtreeCurve::Morton ? bbrcit::morton_key<2>(x) : bbrcit::hilbert_key<2>(x);
+  };
+  vector<pair<size_t,size_t>> leaves;
+  tree.report_leaves(leaves);
+  for (const auto &l : leaves) {
+    for (size_t k = l.first; k < l.second; ++k) {
+      if (key(tree.points()[k]) > key(tree.points()[k+1])) { return false; }
+    }
+  }
+  return true;
+}
+
+int main() {
+
+  cout << endl;
+
+  // test: curve keys.
+  uint32_t x[2] = {1, 0}, y[2] = {0, 1};
+  cout << "+ morton_key(): " << bbrcit::morton_key<2>(x) << " " << bbrcit::morton_key<2>(y) << " (c.f. 2 1)" << endl;
+  cout << "+ hilbert_key() continuity, 2d: " << hilbert_is_continuous<2>(3) << " (c.f. 1)" << endl;
+  cout << "+ hilbert_key() continuity, 3d: " << hilbert_is_continuous<3>(2) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+
+  vector<DataPointType> data;
+  for (int i = 0; i < 100000; ++i) { data.push_back({{g(e), g(e)}}); }
+
+  // test: curve ordered trees hold the same points in the same leaves.
+  bbrcit::KdtreeOptions options; options.leaf_nmax = 32;
+  KdtreeType plain(data, options);
+  vector<bbrcit::Rectangle<2>> plain_cells, curve_cells;
+  plain.report_partitions(1000, plain_cells);
+
+  for (auto curve : {KdtreeCurve::Morton, KdtreeCurve::Hilbert}) {
+    for (auto split : {bbrcit::KdtreeSplit::RoundRobin, bbrcit::KdtreeSplit::SlidingMidpoint}) {
+      options.curve = curve; options.split = split;
+      KdtreeType tree(data, options);
+      bool same_cells = true;
+      if (split == bbrcit::KdtreeSplit::RoundRobin) {
+        tree.report_partitions(1000, curve_cells);
+        same_cells = curve_cells.size() == plain_cells.size();
+        for (size_t k = 0; same_cells && k < curve_cells.size(); ++k) {
+          for (int i = 0; i < 2; ++i) {
+            same_cells = same_cells && curve_cells[k][i].lower() == plain_cells[k][i].lower()
+                                    && curve_cells[k][i].upper() == plain_cells[k][i].upper();
+          }
+        }
+        curve_cells.clear();
+      }
+      cout << "+ " << (curve == KdtreeCurve::Morton ? "Morton" : "Hilbert") << ", "
+           << (split == bbrcit::KdtreeSplit::RoundRobin ? "median" : "sliding midpoint") << ": "
+           << "size " << (tree.size() == plain.size()) << ", cells " << same_cells
+           << ", leaves follow the curve " << leaves_follow_curve(tree, curve) << " (c.f. 1 1 1)" << endl;
+    }
+  }
+  options.split = bbrcit::KdtreeSplit::RoundRobin;
+  cout << endl;
+
+  // test: dual tree evaluation over a vector of queries. the query tree
+  // follows the curve of the reference tree.
+  using KernelDensityType = bbrcit::KernelDensity<2, bbrcit::GaussianKernel<2,double>, double>;
+  using KdePointType = typename KernelDensityType::DataPointType;
+  vector<KdePointType> kde_data, queries;
+  for (int i = 0; i < 50000; ++i) { kde_data.push_back({{g(e), g(e)}}); }
+  for (int i = 0; i < 50000; ++i) { queries.push_back({{g(e), g(e)}}); }
+
+  vector<double> sums;
+  for (auto curve : {KdtreeCurve::None, KdtreeCurve::Morton, KdtreeCurve::Hilbert}) {
+    options.curve = curve;
+    auto start = std::chrono::high_resolution_clock::now();
+    KernelDensityType kde(kde_data, options);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> build = end - start;
+    kde.kernel().set_bandwidth(0.1);
+
+    vector<KdePointType> q = queries;
+    start = std::chrono::high_resolution_clock::now();
+    kde.eval(q, 1e-3, 1e-8, 32);
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> eval = end - start;
+
+    double sum = 0.0;
+    for (const auto &p : q) { sum += p.attributes().value(); }
+    sums.push_back(sum);
+
+    cout << "+ " << (curve == KdtreeCurve::None ? "no curve" :
+                     curve == KdtreeCurve::Morton ? "Morton" : "Hilbert")
+         << ": build " << build.count() << " ms, eval " << eval.count() << " ms. " << endl;
+  }
+  cout << "+ results agree: " << (abs(sums[1] - sums[0]) < 1e-3 * sums[0])
+       << " " << (abs(sums[2] - sums[0]) < 1e-3 * sums[0]) << " (c.f. 1 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <algorithm>
+
+#include <Kdtree.h>
+#include <ExternalKdtree.h>
+#include <Attributes/PointWeights.h>
+
+using namespace std;
+
+namespace {
+  const int D = 2;
+  using AttrType = bbrcit::PointWeights<double>;
+  using KdtreeType = bbrcit::Kdtree<D,AttrType>;
+  using ExternalKdtreeType = bbrcit::ExternalKdtree<D,AttrType>;
+  using DataPointType = typename KdtreeType::DataPointType;
+  using RectangleType = bbrcit::Rectangle<D,double>;
+
+  const char *point_file = "test_kdtree12_points.bin";
+  const char *tree_file = "test_kdtree12_tree.bin";
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  uniform_real_distribution<> u(0.0, 1.0);
+
+  // the points are written in chunks, as a producer larger than memory would.
+  // a tenth of them sit on a line, so that many coordinates tie.
+  const int n_chunks = 10, chunk_size = 50000;
+  vector<DataPointType> data;
+  for (int c = 0; c < n_chunks; ++c) {
+    vector<DataPointType> chunk;
+    for (int i = 0; i < chunk_size; ++i) {
+      double x = g(e), y = i % 10 ? g(e) : 0.5;
+      chunk.push_back({{x, y}, {u(e)}});
+    }
+    ExternalKdtreeType::write_points(point_file, chunk, c > 0);
+    data.insert(data.end(), chunk.begin(), chunk.end());
+  }
+
+  // a budget of 1 MB leaves about 20000 points per subtree built in memory.
+  bbrcit::KdtreeOptions options; options.leaf_nmax = 32;
+  auto start = std::chrono::high_resolution_clock::now();
+  ExternalKdtreeType::build(point_file, tree_file, options, size_t(1) << 20);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+
+  ExternalKdtreeType tree(tree_file);
+  cout << "+ build(), " << n_chunks * chunk_size << " points: " << elapsed.count() << " ms. " << endl;
+  cout << "+ size(): " << tree.size() << " (c.f. " << data.size() << ")" << endl;
+  cout << "+ nodes_locked(): " << tree.nodes_locked() << " (1 unless RLIMIT_MEMLOCK is below the node array)" << endl;
+
+  // test: the tree file holds the points, and its leaves partition them.
+  options.dedup = bbrcit::KdtreeDedup::None;
+  KdtreeType memory_tree(data, options);
+  double total = 0.0, expected_total = 0.0;
+  for (size_t i = 0; i < tree.size(); ++i) { total += tree.points()[i].attributes().weight(); }
+  for (const auto &p : data) { expected_total += p.attributes().weight(); }
+  cout << "+ total weight: "
+       << (abs(total - expected_total) < 1e-9 * total) << " "
+       << (abs(tree.root_attributes().weight() - total) < 1e-9 * total) << " (c.f. 1 1)" << endl;
+
+  vector<pair<uint64_t,uint64_t>> leaves;
+  tree.report_leaves(leaves);
+  bool leaves_ok = !leaves.empty() && leaves.front().first == 0 && leaves.back().second == tree.size()-1;
+  for (size_t k = 1; k < leaves.size(); ++k) { leaves_ok = leaves_ok && leaves[k].first == leaves[k-1].second+1; }
+  for (const auto &l : leaves) { leaves_ok = leaves_ok && l.second - l.first + 1 <= 32; }
+  cout << "+ leaves cover the points: " << leaves_ok << " (c.f. 1)" << endl;
+
+  // test: range queries against the in memory tree.
+  bool count_ok = true, weight_ok = true, search_ok = true;
+  for (int k = 0; k < 500; ++k) {
+    double x = 4*u(e)-2, y = 4*u(e)-2;
+    RectangleType w({x, y}, {x+u(e), y+u(e)});
+    AttrType expected(0.0), actual(0.0);
+    size_t n = memory_tree.range_aggregate(w, expected);
+    count_ok = count_ok && tree.range_aggregate(w, actual) == n && tree.range_count(w) == n;
+    if (n) { weight_ok = weight_ok && abs(actual.weight() - expected.weight()) < 1e-9 * expected.weight(); }
+    vector<DataPointType> result;
+    tree.range_search(w, result);
+    for (const auto &p : result) { search_ok = search_ok && w.contains(p); }
+    search_ok = search_ok && result.size() == n;
+  }
+  cout << "+ range queries: " << count_ok << " " << weight_ok << " " << search_ok << " (c.f. 1 1 1)" << endl;
+
+  // test: files of another type are rejected.
+  bool caught = false;
+  try { bbrcit::ExternalKdtree<3,AttrType> other(tree_file); }
+  catch (std::runtime_error&) { caught = true; }
+  cout << "+ wrong dimension: " << caught << " (c.f. 1)" << endl;
+  cout << endl;
+
+  std::remove(point_file);
+  std::remove(tree_file);
+
+  return 0;
+}
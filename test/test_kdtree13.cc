@@ -0,0 +1,121 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#include <Kdtree.h>
+#include <KernelDensity.h>
+#include <Kernels/GaussianKernel.h>
+#include <Attributes/PointWeights.h>
+#include <Attributes/AdaKdeAttributes.h>
+
+using namespace std;
+
+namespace {
+  const int D = 2;
+  using AttrType = bbrcit::PointWeights<double>;
+  using KdtreeType = bbrcit::Kdtree<D,AttrType>;
+  using CompactKdtreeType = bbrcit::CompactKdtree<D,AttrType>;
+  using DataPointType = typename KdtreeType::DataPointType;
+  using RectangleType = bbrcit::Rectangle<D,double>;
+  using CompactRectangleType = bbrcit::CompactRectangle<D,double>;
+  using PointType = bbrcit::Point<D,double>;
+
+  using KernelType = bbrcit::GaussianKernel<D,double>;
+  using KdeAttrType = bbrcit::AdaKdeAttributes<double>;
+  using KernelDensityType = bbrcit::KernelDensity<D,KernelType,double,KdeAttrType>;
+  using CompactKernelDensityType = bbrcit::KernelDensity<D,KernelType,double,KdeAttrType,
+                                   bbrcit::CompactKdtree<D,KdeAttrType,double>>;
+}
+
+template<typename KernelDensityT>
+double eval_time(const vector<typename KernelDensityT::DataPointType> &data,
+                 vector<typename KernelDensityT::DataPointType> &queries) {
+  KernelDensityT kde(data, 32);
+  kde.kernel().set_bandwidth(0.05);
+  auto start = std::chrono::high_resolution_clock::now();
+  kde.eval(queries, 1e-3, 1e-10, 32);
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  uniform_real_distribution<> u(0.0, 1.0);
+
+  // test: rounding is outward, so distances from a CompactRectangle<> bound
+  // those from the Rectangle<> it was made from.
+  bool contains_ok = true, dist_ok = true;
+  for (int k = 0; k < 10000; ++k) {
+    double x = 1e3*g(e), y = g(e);
+    RectangleType r({x, y}, {x+u(e), y+1e-9*u(e)});
+    CompactRectangleType c(r);
+    PointType p({1e3*g(e), g(e)});
+    contains_ok = contains_ok && c.contains(r) && c.rectangle().contains(r);
+    dist_ok = dist_ok && c.min_dist(p) <= r.min_dist(p) && c.max_dist(p) >= r.max_dist(p);
+  }
+  cout << "+ CompactRectangle<> bounds: " << contains_ok << " " << dist_ok << " (c.f. 1 1)" << endl;
+  cout << "  sizeof: " << sizeof(CompactRectangleType)
+       << " (c.f. " << sizeof(RectangleType) << " for Rectangle<>)" << endl;
+
+  vector<DataPointType> data;
+  for (int i = 0; i < 1000000; ++i) { data.push_back({{g(e), g(e)}, {u(e)}}); }
+
+  KdtreeType tree(data, 32);
+  CompactKdtreeType compact_tree(data, 32);
+  cout << "+ node array, " << data.size() << " points: " << compact_tree.node_bytes() << " bytes "
+       << "(c.f. " << tree.node_bytes() << " bytes for Kdtree<>)" << endl;
+
+  // test: range queries and nearest neighbors agree with Kdtree<>.
+  bool range_ok = true;
+  for (int k = 0; k < 1000; ++k) {
+    double x = 4*u(e)-2, y = 4*u(e)-2;
+    RectangleType w({x, y}, {x+u(e), y+u(e)});
+    AttrType expected(0.0), actual(0.0);
+    size_t n = tree.range_aggregate(w, expected);
+    range_ok = range_ok && compact_tree.range_aggregate(w, actual) == n;
+    if (n) { range_ok = range_ok && abs(actual.weight() - expected.weight()) < 1e-9 * expected.weight(); }
+  }
+  cout << "+ range queries: " << range_ok << " (c.f. 1)" << endl;
+
+  bool knn_ok = true;
+  vector<size_t> indices, compact_indices;
+  vector<double> dists, compact_dists;
+  for (int k = 0; k < 1000; ++k) {
+    DataPointType q({g(e), g(e)});
+    tree.knn_search(q, 8, indices, dists);
+    compact_tree.knn_search(q, 8, compact_indices, compact_dists);
+    knn_ok = knn_ok && dists == compact_dists;
+  }
+  cout << "+ nearest neighbors: " << knn_ok << " (c.f. 1)" << endl;
+
+  // test: dual tree evaluation over a CompactKdtree<>.
+  vector<KernelDensityType::DataPointType> kde_data, queries;
+  for (size_t i = 0; i < data.size(); i += 10) { kde_data.push_back({{data[i][0], data[i][1]}}); }
+  for (int i = 0; i < 10000; ++i) { queries.push_back({{g(e), g(e)}}); }
+  auto compact_queries = queries;
+
+  double elapsed = eval_time<KernelDensityType>(kde_data, queries);
+  double compact_elapsed = eval_time<CompactKernelDensityType>(kde_data, compact_queries);
+
+  // both query trees are built the same way, so the queries come back in
+  // the same order.
+  bool eval_ok = true;
+  for (size_t i = 0; i < queries.size(); ++i) {
+    double v = queries[i].attributes().value(), cv = compact_queries[i].attributes().value();
+    eval_ok = eval_ok && queries[i][0] == compact_queries[i][0] && queries[i][1] == compact_queries[i][1]
+                      && abs(v - cv) <= 2e-3 * v + 1e-10;
+  }
+  cout << "+ dual tree evaluation, " << queries.size() << " queries: " << compact_elapsed << " ms "
+       << "(c.f. " << elapsed << " ms with Kdtree<>). " << endl;
+  cout << "  within tolerance: " << eval_ok << " (c.f. 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include <Kdtree.h>
+#include <Attributes/AdaKdeAttributes.h>
+
+using namespace std;
+
+namespace {
+  const int D = 3;
+  using AttrType = bbrcit::AdaKdeAttributes<double>;
+  using KdtreeType = bbrcit::Kdtree<D,AttrType>;
+  using DataPointType = typename KdtreeType::DataPointType;
+  using RectangleType = bbrcit::Rectangle<D,double>;
+
+  // attributes that carry a large payload along with each point.
+  class Payload {
+    public:
+      Payload& merge(const Payload &rhs) { values_[0] += rhs.values_[0]; return *this; }
+    private:
+      double values_[128] = {};
+  };
+}
+
+// true if the two trees have the same leaves, holding the same points.
+bool same_leaves(const KdtreeType &lhs, const KdtreeType &rhs) {
+  vector<pair<size_t,size_t>> lhs_leaves, rhs_leaves;
+  lhs.report_leaves(lhs_leaves); rhs.report_leaves(rhs_leaves);
+  if (lhs_leaves != rhs_leaves) { return false; }
+  for (const auto &l : lhs_leaves) {
+    vector<DataPointType> a(lhs.points().begin()+l.first, lhs.points().begin()+l.second+1);
+    vector<DataPointType> b(rhs.points().begin()+l.first, rhs.points().begin()+l.second+1);
+    sort(a.begin(), a.end(), bbrcit::ExactLexicoLess<DataPointType>);
+    sort(b.begin(), b.end(), bbrcit::ExactLexicoLess<DataPointType>);
+    for (size_t k = 0; k < a.size(); ++k) {
+      if (!bbrcit::ExactEqual(a[k], b[k])) { return false; }
+    }
+  }
+  return true;
+}
+
+// reports the build times of both builds over `n` random points.
+// duplicate merging is off to time the partitioning alone.
+template<typename AttrT>
+void build_times(int n) {
+  using TreeT = bbrcit::Kdtree<D,AttrT>;
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  vector<typename TreeT::DataPointType> data;
+  for (int i = 0; i < n; ++i) { data.push_back({{g(e), g(e), g(e)}}); }
+  cout << "+ build times, " << n << " points of " << sizeof(data[0]) << " bytes: " << endl;
+
+  bbrcit::KdtreeOptions options; options.leaf_nmax = 32; options.dedup = bbrcit::KdtreeDedup::None;
+  for (auto build : { bbrcit::KdtreeBuild::Select, bbrcit::KdtreeBuild::Indirect }) {
+    options.build = build;
+    auto start = std::chrono::high_resolution_clock::now();
+    TreeT tr(data, options);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    cout << "  " << (build == bbrcit::KdtreeBuild::Select ? "select" : "indirect") << ": "
+         << elapsed.count() << " ms. " << endl;
+  }
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  uniform_real_distribution<> u(0.0, 1.0);
+
+  vector<DataPointType> data;
+  for (int i = 0; i < 200000; ++i) { data.push_back({{g(e), g(e), g(e)}}); }
+
+  // test: indirect selection yields the same partitions.
+  bbrcit::KdtreeOptions options; options.leaf_nmax = 16;
+  for (auto split : { bbrcit::KdtreeSplit::RoundRobin, bbrcit::KdtreeSplit::MaxSpread }) {
+    for (int n_threads : { 1, 4 }) {
+      options.split = split; options.n_threads = n_threads; options.tight_bbox = n_threads > 1;
+      options.build = bbrcit::KdtreeBuild::Select;
+      KdtreeType selected(data, options);
+      options.build = bbrcit::KdtreeBuild::Indirect;
+      KdtreeType indirect(data, options);
+
+      bool range_ok = true;
+      for (int k = 0; k < 200; ++k) {
+        double x = 4*u(e)-2, y = 4*u(e)-2, z = 4*u(e)-2;
+        RectangleType w({x, y, z}, {x+u(e), y+u(e), z+u(e)});
+        range_ok = range_ok && selected.range_count(w) == indirect.range_count(w);
+      }
+      cout << "+ " << (split == bbrcit::KdtreeSplit::RoundRobin ? "round robin" : "max spread")
+           << ", " << n_threads << " thread(s): same leaves " << same_leaves(selected, indirect)
+           << ", same range counts " << range_ok << " (c.f. 1 1)" << endl;
+    }
+  }
+
+  // test: ties along the split dimension, and small trees.
+  vector<DataPointType> lattice;
+  for (int i = 0; i < 20000; ++i) { lattice.push_back({{double(i%7), double(i%11), double(i%13)}}); }
+  options = bbrcit::KdtreeOptions(); options.leaf_nmax = 4; options.dedup = bbrcit::KdtreeDedup::None;
+  options.build = bbrcit::KdtreeBuild::Indirect;
+  KdtreeType tied(lattice, options);
+  RectangleType w({0.0, 0.0, 0.0}, {3.0, 5.0, 6.0});
+  size_t expected = 0;
+  for (const auto &p : lattice) { expected += w.contains(p); }
+  KdtreeType small(vector<DataPointType>(data.begin(), data.begin()+3), options);
+  cout << "+ lattice range count: " << tied.range_count(w) << " (c.f. " << expected << ")" << endl;
+  cout << "+ small tree: " << small.size() << " " << small.node_count() << " (c.f. 3 1)" << endl;
+
+  build_times<AttrType>(1000000);
+  build_times<Payload>(100000);
+  cout << endl;
+
+  return 0;
+}
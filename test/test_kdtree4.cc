@@ -0,0 +1,80 @@
+#include <iostream>
+#include <vector>
+#include <utility>
+#include <random>
+#include <algorithm>
+
+#include <Rectangle.h>
+#include <Kdtree.h>
+
+#include "kdtree_test_utils.h"
+
+using namespace std;
+using bbrcit::Kdtree;
+using bbrcit::KdtreeLayout;
+using bbrcit::KdtreeOptions;
+
+using Kdtree2d = Kdtree<2>;
+using DataPointType = typename Kdtree2d::DataPointType;
+using RectangleType = typename Kdtree2d::RectangleType;
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+
+  vector<DataPointType> data;
+  for (int i = 0; i < 10000; ++i) { data.push_back({{g(e), g(e)}}); }
+
+  RectangleType query({-0.5, -0.2}, {0.7, 1.1});
+
+  KdtreeOptions options; options.leaf_nmax = 4;
+
+  options.layout = KdtreeLayout::DepthFirst;
+  Kdtree2d dfs(data, options);
+
+  options.layout = KdtreeLayout::BreadthFirst;
+  Kdtree2d bfs(data, options);
+
+  options.layout = KdtreeLayout::VanEmdeBoas;
+  Kdtree2d veb(data, options);
+
+  // test: every layout yields the same tree, only the node order differs
+  cout << "+ node_count(): " << dfs.node_count() << " " << bfs.node_count() << " "
+       << veb.node_count() << " (c.f. all equal) " << endl;
+  cout << "+ same points (1): " << same_points(dfs.points(), bfs.points()) << " (c.f. 1)" << endl;
+  cout << "+ same points (2): " << same_points(dfs.points(), veb.points()) << " (c.f. 1)" << endl;
+  cout << "+ same leaves (1): " << (sorted_leaves(dfs) == sorted_leaves(bfs)) << " (c.f. 1)" << endl;
+  cout << "+ same leaves (2): " << (sorted_leaves(dfs) == sorted_leaves(veb)) << " (c.f. 1)" << endl;
+
+  vector<DataPointType> dfs_result = sorted_range_search(dfs, query);
+  cout << "+ range search (1): "
+       << same_points(dfs_result, sorted_range_search(bfs, query)) << " (c.f. 1)" << endl;
+  cout << "+ range search (2): "
+       << same_points(dfs_result, sorted_range_search(veb, query)) << " (c.f. 1)" << endl;
+
+  vector<DataPointType> brute;
+  for (const auto &p : data) { if (query.contains(p)) { brute.push_back(p); } }
+  sort(brute.begin(), brute.end(), bbrcit::ExactLexicoLess<DataPointType>);
+  cout << "+ range search (3): " << same_points(dfs_result, brute) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  // test: copies and moves of the node array remain valid
+  Kdtree2d veb_copy(veb);
+  cout << "+ copy constructor: "
+       << same_points(dfs_result, sorted_range_search(veb_copy, query)) << " (c.f. 1)" << endl;
+
+  Kdtree2d veb_move(std::move(veb_copy));
+  cout << "+ move constructor: "
+       << same_points(dfs_result, sorted_range_search(veb_move, query)) << " "
+       << veb_copy.empty() << " (c.f. 1 1)" << endl;
+
+  Kdtree2d assigned; assigned = bfs;
+  cout << "+ copy assignment: "
+       << same_points(dfs_result, sorted_range_search(assigned, query)) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
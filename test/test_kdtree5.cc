@@ -0,0 +1,126 @@
+#include <iostream>
+#include <vector>
+#include <utility>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <stdexcept>
+
+#include <Rectangle.h>
+#include <Kdtree.h>
+#include <ThreadPool.h>
+#include <ParallelAlgorithms.h>
+
+#include "kdtree_test_utils.h"
+
+using namespace std;
+using bbrcit::Kdtree;
+using bbrcit::KdtreeOptions;
+using bbrcit::ThreadPool;
+
+using Kdtree2d = Kdtree<2>;
+using DataPointType = typename Kdtree2d::DataPointType;
+using RectangleType = typename Kdtree2d::RectangleType;
+
+int main() {
+
+  std::chrono::high_resolution_clock::time_point start, end;
+  std::chrono::duration<double, std::milli> elapsed;
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  uniform_int_distribution<> u(0, 99);
+
+  // test: parallel building blocks against their serial counterparts
+  ThreadPool pool(4);
+  cout << "+ pool size: " << pool.size() << " (c.f. 4)" << endl;
+
+  vector<int> v(300000);
+  for (auto &x : v) { x = u(e) * 1000 + u(e); }
+  vector<int> v_sorted(v); sort(v_sorted.begin(), v_sorted.end());
+
+  vector<int> w(v);
+  bbrcit::parallel_sort(w.begin(), w.end(), less<int>(), pool, 1000);
+  cout << "+ parallel_sort: " << (w == v_sorted) << " (c.f. 1)" << endl;
+
+  bool nth_ok = true;
+  for (size_t k : { size_t(0), size_t(12345), v.size()/2, v.size()-1 }) {
+    w = v;
+    bbrcit::parallel_nth_element(w.begin(), w.begin()+k, w.end(), less<int>(), pool, 1000);
+    nth_ok = nth_ok && w[k] == v_sorted[k];
+    nth_ok = nth_ok && all_of(w.begin(), w.begin()+k, [&] (int x) { return x <= w[k]; });
+    nth_ok = nth_ok && all_of(w.begin()+k, w.end(), [&] (int x) { return x >= w[k]; });
+  }
+  cout << "+ parallel_nth_element: " << nth_ok << " (c.f. 1)" << endl;
+
+  atomic<size_t> n_covered(0);
+  pool.parallel_for(0, 1000, 10, [&] (size_t b, size_t e) { n_covered += e - b; });
+  cout << "+ parallel_for: " << n_covered << " (c.f. 1000)" << endl;
+
+  bool caught = false;
+  try {
+    pool.fork_join([] { throw std::runtime_error("left"); }, [] {});
+  } catch (std::runtime_error&) { caught = true; }
+  cout << "+ fork_join exception: " << caught << " (c.f. 1)" << endl;
+  cout << endl;
+
+  // test: parallel and serial construction yield the same tree.
+  // duplicates exercise merge_duplicates().
+  vector<DataPointType> data;
+  for (int i = 0; i < 500000; ++i) { data.push_back({{g(e), g(e)}}); }
+  for (int i = 0; i < 1000; ++i) { data.push_back(data[i]); }
+
+  KdtreeOptions options; options.leaf_nmax = 8;
+
+  options.n_threads = 1;
+  start = std::chrono::high_resolution_clock::now();
+  Kdtree2d serial(data, options);
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ serial build: " << elapsed.count() << " ms. " << endl;
+
+  options.n_threads = 4;
+  start = std::chrono::high_resolution_clock::now();
+  Kdtree2d parallel(data, options);
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ parallel build (4 threads): " << elapsed.count() << " ms. " << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  Kdtree2d pooled(data, options, &pool);
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ parallel build (shared pool of 4): " << elapsed.count() << " ms. " << endl;
+  cout << endl;
+
+  cout << "+ size(): " << serial.size() << " " << parallel.size() << " (c.f. 500000 500000)" << endl;
+  cout << "+ node_count(): " << serial.node_count() << " " << parallel.node_count() << " (c.f. equal)" << endl;
+
+  vector<DataPointType> serial_points(serial.points()), parallel_points(parallel.points());
+  sort(serial_points.begin(), serial_points.end(), bbrcit::ExactLexicoLess<DataPointType>);
+  sort(parallel_points.begin(), parallel_points.end(), bbrcit::ExactLexicoLess<DataPointType>);
+  cout << "+ same points: " << same_points(serial_points, parallel_points) << " (c.f. 1)" << endl;
+  cout << "+ same leaves: " << (sorted_leaves(serial) == sorted_leaves(parallel)) << " (c.f. 1)" << endl;
+  cout << "+ same leaves (shared pool): " << (sorted_leaves(serial) == sorted_leaves(pooled)) << " (c.f. 1)" << endl;
+
+  RectangleType query({-0.5, -0.2}, {0.7, 1.1});
+  vector<DataPointType> brute;
+  for (const auto &p : serial_points) { if (query.contains(p)) { brute.push_back(p); } }
+  sort(brute.begin(), brute.end(), bbrcit::ExactLexicoLess<DataPointType>);
+  cout << "+ range search: "
+       << same_points(brute, sorted_range_search(serial, query)) << " "
+       << same_points(brute, sorted_range_search(parallel, query)) << " (c.f. 1 1)" << endl;
+
+  // test: the parallel bbox reduction covers every point.
+  vector<RectangleType> partitions;
+  parallel.report_partitions(0, partitions);
+  bool bbox_ok = true;
+  for (const auto &p : parallel.points()) { bbox_ok = bbox_ok && partitions[0].contains(p); }
+  cout << "+ root bounding box: " << bbox_ok << " (c.f. 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
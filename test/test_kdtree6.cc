@@ -0,0 +1,93 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+
+#include <Kdtree.h>
+
+#include "kdtree_test_utils.h"
+
+using namespace std;
+using bbrcit::Kdtree;
+using bbrcit::KdtreeOptions;
+using bbrcit::KdtreeDedup;
+
+using Kdtree2d = Kdtree<2>;
+using DataPointType = typename Kdtree2d::DataPointType;
+
+// builds a tree over `data` with the given dedup policy and reports the time. 
+Kdtree2d timed_build(const string &name, const vector<DataPointType> &data, 
+                     KdtreeDedup dedup, int n_threads) {
+  KdtreeOptions options; 
+  options.leaf_nmax = 32; options.dedup = dedup; options.n_threads = n_threads;
+  auto start = std::chrono::high_resolution_clock::now();
+  Kdtree2d tr(data, options);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+  cout << "  " << name << ": " << elapsed.count() << " ms. " << endl;
+  return tr;
+}
+
+int main() {
+
+  cout << endl;
+
+  default_random_engine e;
+  uniform_int_distribution<> u(0, 299);
+
+  // points on a coarse lattice so that many of them coincide. 
+  vector<DataPointType> data;
+  for (int i = 0; i < 200000; ++i) { data.push_back({{u(e)*0.1, u(e)*0.1}}); }
+  data.push_back({{-0.0, 0.0}});
+  data.push_back({{0.0, -0.0}});
+
+  KdtreeOptions options; options.leaf_nmax = 4;
+
+  options.dedup = KdtreeDedup::Sort;
+  Kdtree2d sorted(data, options);
+
+  options.dedup = KdtreeDedup::Hash;
+  Kdtree2d hashed(data, options);
+
+  options.n_threads = 4;
+  Kdtree2d hashed4(data, options);
+
+  options.dedup = KdtreeDedup::None; options.n_threads = 1;
+  Kdtree2d none(data, options);
+
+  // test: hashing merges the same points as sorting
+  cout << "+ size(): " << sorted.size() << " " << hashed.size() << " " << none.size()
+       << " (c.f. equal equal " << data.size() << ")" << endl;
+  cout << "+ same points and weights: " 
+       << same_points(sorted_points(sorted), sorted_points(hashed)) << " (c.f. 1)" << endl;
+
+  int total_weight = 0;
+  for (const auto &p : hashed.points()) { total_weight += p.attributes().weight(); }
+  cout << "+ total weight: " << total_weight << " (c.f. " << data.size() << ")" << endl;
+
+  // test: the merged points do not depend on the number of threads
+  cout << "+ parallel hash: " 
+       << same_points(sorted_points(hashed), sorted_points(hashed4)) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  // test: the grid use case. points are unique, so None yields the same tree. 
+  vector<DataPointType> grid;
+  for (int j = 0; j < 1000; ++j) {
+    for (int i = 0; i < 1000; ++i) { grid.push_back({{i*0.001, j*0.001}}); }
+  }
+
+  cout << "+ 1000x1000 grid build times: " << endl;
+  Kdtree2d g_sorted = timed_build("sort", grid, KdtreeDedup::Sort, 1);
+  Kdtree2d g_hashed = timed_build("hash", grid, KdtreeDedup::Hash, 1);
+  Kdtree2d g_hashed4 = timed_build("hash (4 threads)", grid, KdtreeDedup::Hash, 4);
+  Kdtree2d g_none = timed_build("none", grid, KdtreeDedup::None, 1);
+  cout << "  sizes: " << g_sorted.size() << " " << g_hashed.size() << " " 
+       << g_hashed4.size() << " " << g_none.size() << " (c.f. 1000000 x4)" << endl;
+  cout << "  same points: " 
+       << same_points(sorted_points(g_sorted), sorted_points(g_none)) << " "
+       << same_points(sorted_points(g_hashed4), sorted_points(g_none)) << " (c.f. 1 1)" << endl;
+  cout << endl;
+
+  return 0;
+}
@@ -0,0 +1,143 @@
+#include <iostream>
+#include <vector>
+#include <map>
+#include <utility>
+#include <random>
+#include <algorithm>
+#include <chrono>
+
+#include <Kdtree.h>
+#include <DynamicKdtree.h>
+
+using namespace std;
+using bbrcit::Kdtree;
+using bbrcit::DynamicKdtree;
+using bbrcit::KdtreeOptions;
+
+using DynamicKdtree2d = DynamicKdtree<2>;
+using DataPointType = typename DynamicKdtree2d::DataPointType;
+using RectangleType = typename DynamicKdtree2d::RectangleType;
+
+using Key = pair<double,double>;
+
+// compares `points` against the brute force set `truth` of weights by coordinates. 
+bool same_as(vector<DataPointType> points, const map<Key,int> &truth) {
+  if (points.size() != truth.size()) { return false; }
+  for (const auto &p : points) {
+    auto it = truth.find({p[0], p[1]});
+    if (it == truth.end() || it->second != p.attributes().weight()) { return false; }
+  }
+  return true;
+}
+
+int main() {
+
+  std::chrono::high_resolution_clock::time_point start, end;
+  std::chrono::duration<double, std::milli> elapsed;
+
+  cout << endl;
+
+  default_random_engine e;
+  uniform_int_distribution<> coord(0, 199), op(0, 9), wgt(1, 5);
+
+  KdtreeOptions options; options.leaf_nmax = 4;
+  DynamicKdtree2d tr(options, 16);
+  map<Key,int> truth;
+
+  // test: random inserts, reinserts, and erases against a brute force set. 
+  // points lie on a lattice so that collisions are frequent. 
+  int n_erased = 0, n_merged = 0;
+  for (int i = 0; i < 20000; ++i) {
+    DataPointType p = {{coord(e)*0.01, coord(e)*0.01}};
+    Key k(p[0], p[1]);
+    if (op(e) < 3) {
+      bool erased = tr.erase(p);
+      n_erased += erased;
+      if (erased != (truth.erase(k) == 1)) { cout << "erase mismatch. " << endl; }
+    } else {
+      int w = wgt(e);
+      p.set_attributes({w});
+      n_merged += truth.count(k);
+      truth[k] += w;
+      tr.insert(p);
+    }
+  }
+
+  vector<DataPointType> points;
+  tr.report_points(points);
+  cout << "+ size(): " << tr.size() << " (c.f. " << truth.size() << ")" << endl;
+  cout << "+ erased/merged: " << n_erased << " " << n_merged << " (c.f. both > 0)" << endl;
+  cout << "+ level_count(): " << tr.level_count() << " (c.f. small)" << endl;
+  cout << "+ report_points: " << same_as(points, truth) << " (c.f. 1)" << endl;
+
+  int total = 0;
+  for (const auto &kv : truth) { total += kv.second; }
+  cout << "+ attributes(): " << tr.attributes().weight() << " (c.f. " << total << ")" << endl;
+
+  RectangleType query({0.3, 0.5}, {1.2, 1.4});
+  vector<DataPointType> result;
+  tr.range_search(query, result);
+  map<Key,int> truth_in_query;
+  for (const auto &kv : truth) {
+    if (query.contains(DataPointType{{kv.first.first, kv.first.second}})) { truth_in_query.insert(kv); }
+  }
+  cout << "+ range_search: " << same_as(result, truth_in_query) << " (c.f. 1)" << endl;
+
+  cout << "+ contains: " << tr.contains(points[0]) << " "
+       << tr.contains(DataPointType{{-1.0, -1.0}}) << " (c.f. 1 0)" << endl;
+
+  tr.rebuild();
+  points.clear(); tr.report_points(points);
+  cout << "+ rebuild(): " << tr.level_count() << " " << same_as(points, truth) << " (c.f. 1 1)" << endl;
+  cout << endl;
+
+  // test: duplicates among the initial points are merged
+  vector<DataPointType> doubled(points);
+  doubled.insert(doubled.end(), points.begin(), points.end());
+  DynamicKdtree2d initial(doubled, options);
+  cout << "+ initial duplicates: " << initial.size() << " " << initial.attributes().weight() 
+       << " (c.f. " << truth.size() << " " << 2 * total << ")" << endl;
+  cout << endl;
+
+  // test: erasing everything leaves an empty set
+  DynamicKdtree2d copy(tr);
+  for (const auto &p : points) { copy.erase(p); }
+  cout << "+ erase all: " << copy.size() << " " << copy.empty() << " " 
+       << copy.level_count() << " (c.f. 0 1 0)" << endl;
+  cout << endl;
+
+  // timing: growing a set one point at a time, against rebuilding a 
+  // static Kdtree<> after every 1000 insertions. 
+  normal_distribution<> g(0.0, 1.0);
+  vector<DataPointType> stream;
+  for (int i = 0; i < 100000; ++i) { stream.push_back({{g(e), g(e)}}); }
+
+  DynamicKdtree2d grown(options);
+  start = std::chrono::high_resolution_clock::now();
+  for (const auto &p : stream) { grown.insert(p); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ " << stream.size() << " single insertions: " << elapsed.count() << " ms. " << endl;
+
+  // the same on 4 threads: every level is built on the pool kept by the set. 
+  KdtreeOptions threaded_options = options; threaded_options.n_threads = 4;
+  DynamicKdtree2d threaded(threaded_options);
+  start = std::chrono::high_resolution_clock::now();
+  for (const auto &p : stream) { threaded.insert(p); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ " << stream.size() << " single insertions, 4 threads: " << elapsed.count() << " ms. " << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (size_t n = 1000; n <= stream.size(); n += 1000) {
+    Kdtree<2> rebuilt(vector<DataPointType>(stream.begin(), stream.begin()+n), options);
+  }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ 100 full rebuilds: " << elapsed.count() << " ms. " << endl;
+  cout << "+ size(): " << grown.size() << " " << threaded.size() 
+       << " (c.f. " << stream.size() << " " << stream.size() << ")" << endl;
+  cout << endl;
+
+  return 0;
+}
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <vector>
+#include <utility>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+#include <Kdtree.h>
+
+using namespace std;
+
+namespace {
+  const int D = 3;
+}
+
+// brute force k nearest neighbors of `q` among `points`, ties to the lower index.
+template<typename PointT>
+vector<pair<double,size_t>> brute_knn(const vector<PointT> &points, const PointT &q, int k) {
+  vector<pair<double,size_t>> all;
+  for (size_t i = 0; i < points.size(); ++i) {
+    double total = 0.0;
+    for (int d = 0; d < D; ++d) { total += (points[i][d]-q[d]) * (points[i][d]-q[d]); }
+    all.push_back({std::sqrt(total), i});
+  }
+  partial_sort(all.begin(), all.begin()+k, all.end());
+  all.resize(k);
+  return all;
+}
+
+// checks single point and all kNN searches of a tree of type TreeT against
+// brute force.
+template<typename TreeT>
+void run(const string &name, const vector<typename TreeT::DataPointType> &data,
+         const vector<typename TreeT::DataPointType> &queries, int k) {
+
+  bbrcit::KdtreeOptions options; options.leaf_nmax = 16;
+  TreeT tree(data, options);
+  TreeT query_tree(queries, options);
+
+  vector<size_t> indices; vector<double> dists;
+  bool single_ok = true;
+  for (const auto &q : queries) {
+    tree.knn_search(q, k, indices, dists);
+    auto expected = brute_knn(tree.points(), q, k);
+    for (int i = 0; i < k; ++i) {
+      single_ok = single_ok && indices[i] == expected[i].second && dists[i] == expected[i].first;
+    }
+  }
+  cout << "  " << name << ", single point: " << single_ok << " (c.f. 1)" << endl;
+
+  tree.knn_search(query_tree, k, indices, dists);
+  bool dual_ok = indices.size() == k * query_tree.size();
+  for (size_t q = 0; dual_ok && q < query_tree.size(); ++q) {
+    auto expected = brute_knn(tree.points(), query_tree.points()[q], k);
+    for (int i = 0; i < k; ++i) {
+      dual_ok = dual_ok && indices[q*k+i] == expected[i].second && dists[q*k+i] == expected[i].first;
+    }
+  }
+  cout << "  " << name << ", all kNN: " << dual_ok << " (c.f. 1)" << endl;
+}
+
+// times single point searches against the dual tree for all points of a tree.
+template<typename TreeT>
+void benchmark(const string &name, const vector<typename TreeT::DataPointType> &data, int k, 
+               const bbrcit::KdtreeOptions &options) {
+
+  TreeT tree(data, options);
+
+  vector<size_t> indices; vector<double> dists;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (const auto &q : tree.points()) { tree.knn_search(q, k, indices, dists); }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+  cout << "  " << name << ", " << tree.size() << " single point searches: " << elapsed.count() << " ms. " << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  tree.knn_search(tree, k, indices, dists);
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "  " << name << ", all kNN: " << elapsed.count() << " ms. " << endl;
+}
+
+int main() {
+
+  using KdtreeType = bbrcit::Kdtree<D>;
+  using BallTreeType = bbrcit::BallTree<D>;
+  using DataPointType = typename KdtreeType::DataPointType;
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  uniform_int_distribution<> u(0, 9);
+
+  // test: against brute force. the second data set lies on a coarse grid,
+  // so that distances tie.
+  vector<DataPointType> data, grid, queries;
+  for (int i = 0; i < 3000; ++i) { data.push_back({{g(e), g(e), g(e)}}); }
+  for (int i = 0; i < 3000; ++i) { grid.push_back({{double(u(e)), double(u(e)), double(u(e))}}); }
+  for (int i = 0; i < 300; ++i) { queries.push_back({{g(e), g(e), g(e)}}); }
+
+  cout << "+ k = 1: " << endl;
+  run<KdtreeType>("kdtree", data, queries, 1);
+  run<BallTreeType>("ball tree", data, queries, 1);
+  cout << "+ k = 10: " << endl;
+  run<KdtreeType>("kdtree", data, queries, 10);
+  run<BallTreeType>("ball tree", data, queries, 10);
+  cout << "+ k = 10, ties: " << endl;
+  run<KdtreeType>("kdtree", grid, queries, 10);
+  run<BallTreeType>("ball tree", grid, queries, 10);
+  cout << endl;
+
+  // test: self queries find themselves first.
+  KdtreeType tree(data);
+  vector<size_t> indices; vector<double> dists;
+  tree.knn_search(tree, 2, indices, dists);
+  bool self_ok = true;
+  for (size_t i = 0; i < tree.size(); ++i) { self_ok = self_ok && indices[2*i] == i && dists[2*i] == 0.0; }
+  cout << "+ self queries: " << self_ok << " (c.f. 1)" << endl;
+
+  // test: argument checking.
+  bool caught = false;
+  try { tree.knn_search(data[0], 0, indices, dists); }
+  catch (std::invalid_argument&) { caught = true; }
+  cout << "+ k = 0: " << caught << " (c.f. 1)" << endl;
+
+  caught = false;
+  try { tree.knn_search(data[0], tree.size()+1, indices, dists); }
+  catch (std::invalid_argument&) { caught = true; }
+  cout << "+ k > size(): " << caught << " (c.f. 1)" << endl;
+  cout << endl;
+
+  // test: all kNN timings.
+  vector<DataPointType> big;
+  for (int i = 0; i < 200000; ++i) { big.push_back({{g(e), g(e), g(e)}}); }
+  bbrcit::KdtreeOptions options; options.leaf_nmax = 16;
+  cout << "+ k = 8: " << endl;
+  benchmark<KdtreeType>("kdtree, cells", big, 8, options);
+  options.tight_bbox = true;
+  benchmark<KdtreeType>("kdtree, tight", big, 8, options);
+  options.split = bbrcit::KdtreeSplit::MaxSpread;
+  benchmark<BallTreeType>("ball tree", big, 8, options);
+  cout << endl;
+
+  return 0;
+}
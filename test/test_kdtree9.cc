@@ -0,0 +1,114 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+#include <Kdtree.h>
+#include <Attributes/PointWeights.h>
+
+using namespace std;
+
+namespace {
+  const int D = 2;
+  using AttrType = bbrcit::PointWeights<double>;
+  using RectangleType = bbrcit::Rectangle<D,double>;
+}
+
+// checks range_count() and range_aggregate() of a tree of type TreeT
+// against brute force over random query windows.
+template<typename TreeT>
+void run(const string &name, const vector<typename TreeT::DataPointType> &data,
+         const vector<RectangleType> &windows) {
+
+  bbrcit::KdtreeOptions options;
+  options.leaf_nmax = 16;
+  options.split = bbrcit::KdtreeSplit::MaxSpread;
+  TreeT tree(data, options);
+
+  bool count_ok = true, weight_ok = true;
+  for (const auto &w : windows) {
+    size_t expected_count = 0; double expected_weight = 0.0;
+    for (const auto &p : tree.points()) {
+      if (w.contains(p)) { ++expected_count; expected_weight += p.attributes().weight(); }
+    }
+
+    AttrType weight(0.0);
+    size_t count = tree.range_aggregate(w, weight);
+    count_ok = count_ok && count == expected_count && tree.range_count(w) == expected_count;
+    if (count) { weight_ok = weight_ok && abs(weight.weight() - expected_weight) < 1e-9 * expected_weight; }
+  }
+  cout << "  " << name << ": counts " << count_ok << ", weights " << weight_ok << " (c.f. 1 1)" << endl;
+}
+
+int main() {
+
+  using KdtreeType = bbrcit::Kdtree<D,AttrType>;
+  using BallTreeType = bbrcit::BallTree<D,AttrType>;
+  using DataPointType = typename KdtreeType::DataPointType;
+
+  cout << endl;
+
+  default_random_engine e;
+  normal_distribution<> g(0.0, 1.0);
+  uniform_real_distribution<> u(0.0, 1.0);
+
+  vector<DataPointType> data;
+  for (int i = 0; i < 20000; ++i) { data.push_back({{g(e), g(e)}, {u(e)}}); }
+
+  vector<RectangleType> windows;
+  for (int i = 0; i < 500; ++i) {
+    double x = 4*u(e)-2, y = 4*u(e)-2;
+    windows.push_back(RectangleType({x, y}, {x+2*u(e), y+2*u(e)}));
+  }
+  windows.push_back(RectangleType({10.0, 10.0}, {11.0, 11.0}));
+  windows.push_back(RectangleType({-10.0, -10.0}, {10.0, 10.0}));
+
+  // test: against brute force.
+  cout << "+ range queries: " << endl;
+  run<KdtreeType>("kdtree", data, windows);
+  run<BallTreeType>("ball tree", data, windows);
+  cout << endl;
+
+  // test: empty windows leave the result untouched.
+  KdtreeType tree(data);
+  AttrType weight(-1.0);
+  size_t count = tree.range_aggregate(windows[500], weight);
+  cout << "+ empty window: " << count << " " << weight.weight() << " (c.f. 0 -1)" << endl;
+  cout << "+ whole space: " << tree.range_count(windows[501]) << " (c.f. " << tree.size() << ")" << endl;
+  cout << endl;
+
+  // test: timings of counting against reporting.
+  vector<DataPointType> big;
+  for (int i = 0; i < 1000000; ++i) { big.push_back({{g(e), g(e)}, {u(e)}}); }
+  KdtreeType big_tree(big);
+
+  size_t reported = 0, counted = 0, aggregated = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (const auto &w : windows) {
+    vector<DataPointType> result;
+    big_tree.range_search(w, result);
+    reported += result.size();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+  cout << "+ range_search(): " << elapsed.count() << " ms. " << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (const auto &w : windows) { counted += big_tree.range_count(w); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ range_count(): " << elapsed.count() << " ms. " << endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (const auto &w : windows) { aggregated += big_tree.range_aggregate(w, weight); }
+  end = std::chrono::high_resolution_clock::now();
+  elapsed = end - start;
+  cout << "+ range_aggregate(): " << elapsed.count() << " ms. " << endl;
+  cout << "+ totals agree: " << (reported == counted && counted == aggregated) << " (c.f. 1)" << endl;
+  cout << endl;
+
+  return 0;
+}